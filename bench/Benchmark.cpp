@@ -0,0 +1,85 @@
+#include "Benchmark.hpp"
+
+#include <cstdio>
+
+namespace {
+std::string JsonEscape(const std::string& text) {
+  std::string out;
+  for (char c : text) {
+    if (c == '"' || c == '\\') out += '\\';
+    out += c;
+  }
+  return out;
+}
+
+std::string FormatNumber(const char* format, double value) {
+  char buffer[64];
+  std::snprintf(buffer, sizeof(buffer), format, value);
+  return buffer;
+}
+}  // namespace
+
+Bench::Runner::Runner(const Options& options) : options(options) {}
+
+bool Bench::Runner::Enabled(const std::string& name) const {
+  return options.filter.empty() ||
+         name.find(options.filter) != std::string::npos;
+}
+
+void Bench::Runner::Write(std::ostream& out) const {
+  switch (options.format) {
+    case Format::CSV:
+      out << "name,variant,ns_per_op,ops_per_sec,operations,max_error,"
+             "passed\n";
+      for (const Result& r : results) {
+        out << r.name << ',' << r.variant << ','
+            << FormatNumber("%.4f", r.nsPerOp) << ','
+            << FormatNumber("%.0f", r.opsPerSecond) << ',' << r.operations
+            << ','
+            << (r.maxError < 0.0 ? "" : FormatNumber("%.3e", r.maxError))
+            << ',' << (r.tolerance < 0.0 ? "" : r.Failed() ? "no" : "yes")
+            << '\n';
+      }
+      break;
+
+    case Format::JSON:
+      out << "[\n";
+      for (size_t i = 0; i < results.size(); ++i) {
+        const Result& r = results[i];
+        out << "  {\"name\": \"" << JsonEscape(r.name) << "\", \"variant\": \""
+            << JsonEscape(r.variant)
+            << "\", \"ns_per_op\": " << FormatNumber("%.4f", r.nsPerOp)
+            << ", \"ops_per_sec\": " << FormatNumber("%.0f", r.opsPerSecond)
+            << ", \"operations\": " << r.operations;
+        if (r.maxError >= 0.0)
+          out << ", \"max_error\": " << FormatNumber("%.3e", r.maxError);
+        if (r.tolerance >= 0.0)
+          out << ", \"passed\": " << (r.Failed() ? "false" : "true");
+        out << (i + 1 < results.size() ? "},\n" : "}\n");
+      }
+      out << "]\n";
+      break;
+
+    case Format::TABLE:
+      for (const Result& r : results) {
+        char line[256];
+        std::snprintf(line, sizeof(line),
+                      "%-36s %-12s %10.3f ns/op %14.0f op/s", r.name.c_str(),
+                      r.variant.c_str(), r.nsPerOp, r.opsPerSecond);
+        out << line;
+        if (r.maxError >= 0.0)
+          out << "   max error " << FormatNumber("%.2e", r.maxError);
+        if (r.Failed())
+          out << "   FAILED (tolerance " << FormatNumber("%.2e", r.tolerance)
+              << ')';
+        out << '\n';
+      }
+      break;
+  }
+}
+
+size_t Bench::Runner::GetFailureCount() const {
+  size_t failures = 0;
+  for (const Result& r : results) failures += r.Failed();
+  return failures;
+}
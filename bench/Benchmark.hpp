@@ -0,0 +1,101 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace Bench {
+enum class Format { TABLE, CSV, JSON };
+
+struct Options {
+  Format format = Format::TABLE;
+  // Only benchmarks whose name contains this string run.
+  std::string filter;
+  // Minimum measured time per sample; the best of `samples` is reported.
+  double minSeconds = 0.05;
+  int samples = 3;
+};
+
+struct Result {
+  std::string name;
+  std::string variant;
+  double nsPerOp;
+  double opsPerSecond;
+  size_t operations;
+  // Accuracy check for the benchmarks that have one, negative otherwise.
+  double maxError;
+  // Largest acceptable maxError, negative when any error is accepted.
+  double tolerance;
+
+  bool Failed() const { return tolerance >= 0.0 && !(maxError <= tolerance); }
+};
+
+// Prevents the compiler from discarding the computation of `value`.
+template <typename T>
+inline void DoNotOptimize(const T& value) {
+#if defined(__GNUC__) || defined(__clang__)
+  asm volatile("" : : "m"(value) : "memory");
+#else
+  static volatile const void* sink;
+  sink = &value;
+#endif
+}
+
+class Runner {
+ private:
+  Options options;
+  std::vector<Result> results;
+
+ public:
+  explicit Runner(const Options& options);
+
+  bool Enabled(const std::string& name) const;
+
+  // Times `fn`, which performs `opsPerCall` operations per call, and
+  // records one result. Skipped when `name` does not match the filter.
+  // A result whose maxError exceeds `tolerance` counts as a failure.
+  template <typename Fn>
+  void Run(const std::string& name, const std::string& variant,
+           size_t opsPerCall, Fn&& fn, double maxError = -1.0,
+           double tolerance = -1.0);
+
+  void Write(std::ostream& out) const;
+  // Results that failed their accuracy check.
+  size_t GetFailureCount() const;
+};
+
+template <typename Fn>
+void Runner::Run(const std::string& name, const std::string& variant,
+                 size_t opsPerCall, Fn&& fn, double maxError,
+                 double tolerance) {
+  if (!Enabled(name)) return;
+  using Clock = std::chrono::steady_clock;
+
+  fn();  // warm caches and lazily initialized dispatch tables
+  double bestNs = 0.0;
+  size_t bestOps = 0;
+  for (int sample = 0; sample < options.samples; ++sample) {
+    size_t calls = 1;
+    for (;;) {
+      const auto begin = Clock::now();
+      for (size_t i = 0; i < calls; ++i) fn();
+      const double seconds =
+          std::chrono::duration<double>(Clock::now() - begin).count();
+      if (seconds >= options.minSeconds) {
+        const size_t ops = calls * opsPerCall;
+        const double ns = seconds * 1e9 / ops;
+        if (bestOps == 0 || ns < bestNs) {
+          bestNs = ns;
+          bestOps = ops;
+        }
+        break;
+      }
+      calls *= 2;
+    }
+  }
+  results.push_back(
+      {name, variant, bestNs, 1e9 / bestNs, bestOps, maxError, tolerance});
+}
+}  // namespace Bench
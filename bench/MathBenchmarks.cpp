@@ -0,0 +1,764 @@
+#include "MathBenchmarks.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "Aabb.hpp"
+#include "Affine3x4.hpp"
+#include "BatchKernels.hpp"
+#include "CpuFeatures.hpp"
+#include "GpuMatrix.hpp"
+#include "Matrix4x4.hpp"
+#include "MatrixKernels.hpp"
+#include "PhysicsWorld.hpp"
+#include "Quaternion.hpp"
+#include "Vector2.hpp"
+#include "Vector3.hpp"
+#include "Vector3Batch.hpp"
+#include "VectorOps.hpp"
+
+namespace {
+// Fixed seed so every run (and every release) measures the same data.
+std::mt19937& Generator() {
+  static std::mt19937 generator(642);
+  return generator;
+}
+
+float RandomFloat(float low, float high) {
+  return std::uniform_real_distribution<float>(low, high)(Generator());
+}
+
+math::Vector3 RandomVector3() {
+  return math::Vector3(RandomFloat(-10.0f, 10.0f), RandomFloat(-10.0f, 10.0f),
+                       RandomFloat(-10.0f, 10.0f));
+}
+
+std::vector<math::Vector3> RandomVector3s(size_t count) {
+  std::vector<math::Vector3> out(count);
+  for (auto& v : out) v = RandomVector3();
+  return out;
+}
+
+math::Quaternion RandomRotation() {
+  return math::Quaternion(RandomFloat(-1.0f, 1.0f), RandomFloat(-1.0f, 1.0f),
+                          RandomFloat(-1.0f, 1.0f), RandomFloat(-1.0f, 1.0f))
+      .Normalized();
+}
+
+std::vector<math::Quaternion> RandomRotations(size_t count) {
+  std::vector<math::Quaternion> out(count);
+  for (auto& q : out) q = RandomRotation();
+  return out;
+}
+
+// Rotation + translation, the common case for bodies and cameras.
+std::vector<math::Affine3x4> RandomRigid(size_t count) {
+  std::vector<math::Affine3x4> out(count);
+  for (auto& a : out) a = RandomRotation().ToAffine3x4(RandomVector3());
+  return out;
+}
+
+std::vector<math::Affine3x4> RandomAffine(size_t count) {
+  std::vector<math::Affine3x4> out(count);
+  for (auto& a : out) {
+    a = math::Affine3x4::CreateScale(RandomFloat(0.5f, 2.0f),
+                                     RandomFloat(0.5f, 2.0f),
+                                     RandomFloat(0.5f, 2.0f)) *
+        RandomRotation().ToAffine3x4(RandomVector3());
+  }
+  return out;
+}
+
+std::vector<math::Matrix4x4> ToMatrices(
+    const std::vector<math::Affine3x4>& in) {
+  std::vector<math::Matrix4x4> out(in.size());
+  for (size_t i = 0; i < in.size(); ++i) out[i] = in[i].ToMatrix4x4();
+  return out;
+}
+
+math::Matrix4x4 Projection() {
+  return math::Matrix4x4::CreatePerspectiveMatrix(0.785398f, 4.0f / 3.0f,
+                                                  0.1f, 100.0f);
+}
+
+// Projections over a range of fields of view and clip distances.
+std::vector<math::Matrix4x4> RandomProjections(size_t count) {
+  std::vector<math::Matrix4x4> out(count);
+  for (auto& m : out) {
+    m = math::Matrix4x4::CreatePerspectiveMatrix(
+        RandomFloat(0.5f, 1.5f), RandomFloat(1.0f, 2.0f),
+        RandomFloat(0.05f, 1.0f), RandomFloat(50.0f, 500.0f));
+  }
+  return out;
+}
+
+// Full matrices with no affine structure. The diagonal is pushed away from
+// zero so they stay well conditioned and float can invert them accurately.
+std::vector<math::Matrix4x4> RandomGeneral(size_t count) {
+  std::vector<math::Matrix4x4> out(count);
+  for (auto& m : out) {
+    for (int r = 0; r < 4; ++r) {
+      for (int c = 0; c < 4; ++c)
+        m.element[r][c] = RandomFloat(-1.0f, 1.0f) + (r == c ? 3.0f : 0.0f);
+    }
+  }
+  return out;
+}
+
+// Gauss-Jordan elimination with partial pivoting, in double precision.
+void ReferenceInverse(const math::Matrix4x4& m, double out[4][4]) {
+  double a[4][8];
+  for (int r = 0; r < 4; ++r) {
+    for (int c = 0; c < 4; ++c) {
+      a[r][c] = m.element[r][c];
+      a[r][c + 4] = r == c ? 1.0 : 0.0;
+    }
+  }
+  for (int c = 0; c < 4; ++c) {
+    int pivot = c;
+    for (int r = c + 1; r < 4; ++r) {
+      if (std::fabs(a[r][c]) > std::fabs(a[pivot][c])) pivot = r;
+    }
+    for (int k = 0; k < 8; ++k) std::swap(a[c][k], a[pivot][k]);
+    const double scale = 1.0 / a[c][c];
+    for (int k = 0; k < 8; ++k) a[c][k] *= scale;
+    for (int r = 0; r < 4; ++r) {
+      if (r == c) continue;
+      const double factor = a[r][c];
+      for (int k = 0; k < 8; ++k) a[r][k] -= factor * a[c][k];
+    }
+  }
+  for (int r = 0; r < 4; ++r) {
+    for (int c = 0; c < 4; ++c) out[r][c] = a[r][c + 4];
+  }
+}
+
+// Largest deviation of `inverse` from the double-precision inverse of `m`,
+// relative to the largest element of the latter.
+double InverseError(const math::Matrix4x4& m, const math::Matrix4x4& inverse) {
+  double expected[4][4];
+  ReferenceInverse(m, expected);
+  double error = 0.0;
+  double magnitude = 0.0;
+  for (int r = 0; r < 4; ++r) {
+    for (int c = 0; c < 4; ++c) {
+      const double difference = inverse.element[r][c] - expected[r][c];
+      error = std::max(error, std::fabs(difference));
+      magnitude = std::max(magnitude, std::fabs(expected[r][c]));
+    }
+  }
+  return error / magnitude;
+}
+
+// Largest deviation of `a * inverse` from the identity.
+double RoundTripError(const math::Affine3x4& a,
+                      const math::Affine3x4& inverse) {
+  const math::Affine3x4 product = a * inverse;
+  double error = 0.0;
+  for (int r = 0; r < 3; ++r) {
+    for (int c = 0; c < 4; ++c) {
+      const double expected = r == c ? 1.0 : 0.0;
+      error = std::max(error, std::fabs(product.element[r][c] - expected));
+    }
+  }
+  return error;
+}
+
+// Largest componentwise difference between two matrix arrays.
+double MaxDifference(const std::vector<math::Matrix4x4>& a,
+                     const std::vector<math::Matrix4x4>& b) {
+  double error = 0.0;
+  for (size_t i = 0; i < a.size(); ++i) {
+    for (int r = 0; r < 4; ++r) {
+      for (int c = 0; c < 4; ++c) {
+        error = std::max(error, std::fabs(static_cast<double>(
+                                    a[i].element[r][c] - b[i].element[r][c])));
+      }
+    }
+  }
+  return error;
+}
+}  // namespace
+
+void Bench::RunMatrixBenchmarks(Runner& runner, size_t count) {
+  const std::string kernel = math::MatrixKernelName();
+  const auto lhs = ToMatrices(RandomAffine(count));
+  const auto rhs = ToMatrices(RandomAffine(count));
+  std::vector<float> angles(count);
+  for (auto& angle : angles) angle = RandomFloat(-3.0f, 3.0f);
+  const auto vectors = RandomVector3s(count);
+  std::vector<math::Matrix4x4> out(count);
+
+  runner.Run("Matrix4x4/CreateIdentityMatrix", "scalar", count, [&] {
+    for (size_t i = 0; i < count; ++i)
+      out[i] = math::Matrix4x4::CreateIdentityMatrix();
+    DoNotOptimize(out[count / 2]);
+  });
+  runner.Run("Matrix4x4/CreateScaleMatrix", "scalar", count, [&] {
+    for (size_t i = 0; i < count; ++i)
+      out[i] = math::Matrix4x4::CreateScaleMatrix(vectors[i]);
+    DoNotOptimize(out[count / 2]);
+  });
+  runner.Run("Matrix4x4/CreateRotationYawMatrix", "scalar", count, [&] {
+    for (size_t i = 0; i < count; ++i)
+      out[i] = math::Matrix4x4::CreateRotationYawMatrix(angles[i]);
+    DoNotOptimize(out[count / 2]);
+  });
+  runner.Run("Matrix4x4/CreateTranslationMatrix", "scalar", count, [&] {
+    for (size_t i = 0; i < count; ++i)
+      out[i] = math::Matrix4x4::CreateTranslationMatrix(vectors[i]);
+    DoNotOptimize(out[count / 2]);
+  });
+  runner.Run("Matrix4x4/CreatePerspectiveMatrix", "scalar", count, [&] {
+    for (size_t i = 0; i < count; ++i) {
+      out[i] = math::Matrix4x4::CreatePerspectiveMatrix(
+          0.5f + angles[i] * 0.1f, 4.0f / 3.0f, 0.1f, 100.0f);
+    }
+    DoNotOptimize(out[count / 2]);
+  });
+
+  std::vector<math::Matrix4x4> reference(count);
+  std::vector<math::Matrix4x4> simd(count);
+  for (size_t i = 0; i < count; ++i) {
+    reference[i] = lhs[i] * rhs[i];
+    math::Multiply(lhs[i], rhs[i], simd[i]);
+  }
+  runner.Run("Matrix4x4/multiply", "operator*", count, [&] {
+    for (size_t i = 0; i < count; ++i) out[i] = lhs[i] * rhs[i];
+    DoNotOptimize(out[count / 2]);
+  });
+  runner.Run(
+      "Matrix4x4/multiply", kernel, count,
+      [&] {
+        for (size_t i = 0; i < count; ++i)
+          math::Multiply(lhs[i], rhs[i], out[i]);
+        DoNotOptimize(out[count / 2]);
+      },
+      MaxDifference(reference, simd));
+
+  runner.Run("Matrix4x4/transpose", "scalar", count, [&] {
+    for (size_t i = 0; i < count; ++i) {
+      for (int r = 0; r < 4; ++r) {
+        for (int c = 0; c < 4; ++c) out[i].element[c][r] = lhs[i].element[r][c];
+      }
+    }
+    DoNotOptimize(out[count / 2]);
+  });
+  runner.Run("Matrix4x4/transpose", kernel, count, [&] {
+    for (size_t i = 0; i < count; ++i) math::Transpose(lhs[i], out[i]);
+    DoNotOptimize(out[count / 2]);
+  });
+
+  const math::Matrix4x4 projection = Projection();
+  std::vector<float> packed(count * 4, 1.0f);
+  for (size_t i = 0; i < count; ++i) {
+    packed[i * 4 + 0] = vectors[i].x;
+    packed[i * 4 + 1] = vectors[i].y;
+    packed[i * 4 + 2] = vectors[i].z;
+  }
+  std::vector<float> transformed(count * 4);
+  runner.Run("Matrix4x4/transform vectors", "scalar", count, [&] {
+    for (size_t n = 0; n < count; ++n) {
+      for (int j = 0; j < 4; ++j) {
+        float sum = 0.0f;
+        for (int k = 0; k < 4; ++k)
+          sum += packed[n * 4 + k] * projection.element[k][j];
+        transformed[n * 4 + j] = sum;
+      }
+    }
+    DoNotOptimize(transformed[count]);
+  });
+  runner.Run("Matrix4x4/transform vectors", kernel, count, [&] {
+    math::TransformVectors(projection, packed.data(), transformed.data(),
+                           count);
+    DoNotOptimize(transformed[count]);
+  });
+  std::vector<math::Vector3> points(count);
+  runner.Run("Matrix4x4/transform points", kernel, count, [&] {
+    math::TransformPoints(lhs[0], vectors.data(), points.data(), count);
+    DoNotOptimize(points[count / 2]);
+  });
+
+  const auto rigid = ToMatrices(RandomRigid(count));
+  const auto affine = ToMatrices(RandomAffine(count));
+  const auto projections = RandomProjections(count);
+  const auto general = RandomGeneral(count);
+  // Relative error a float inverse of these inputs stays well within.
+  constexpr double inverseTolerance = 1e-4;
+  struct InverseCase {
+    const char* name;
+    const char* variant;
+    const std::vector<math::Matrix4x4>* input;
+    math::Matrix4x4 (*invert)(const math::Matrix4x4&);
+  };
+  const InverseCase inverseCases[] = {
+      {"Matrix4x4/inverse rigid", "Inverse", &rigid,
+       [](const math::Matrix4x4& m) { return math::Inverse(m); }},
+      {"Matrix4x4/inverse rigid", "InverseAffine", &rigid,
+       math::InverseAffine},
+      {"Matrix4x4/inverse rigid", "InverseRigid", &rigid, math::InverseRigid},
+      {"Matrix4x4/inverse affine", "Inverse", &affine,
+       [](const math::Matrix4x4& m) { return math::Inverse(m); }},
+      {"Matrix4x4/inverse affine", "InverseAffine", &affine,
+       math::InverseAffine},
+      {"Matrix4x4/inverse projection", "Inverse", &projections,
+       [](const math::Matrix4x4& m) { return math::Inverse(m); }},
+      {"Matrix4x4/inverse general", "Inverse", &general,
+       [](const math::Matrix4x4& m) { return math::Inverse(m); }},
+  };
+  for (const InverseCase& c : inverseCases) {
+    const auto& input = *c.input;
+    double error = 0.0;
+    for (size_t i = 0; i < count; ++i)
+      error = std::max(error, InverseError(input[i], c.invert(input[i])));
+    runner.Run(
+        c.name, c.variant, count,
+        [&] {
+          for (size_t i = 0; i < count; ++i) out[i] = c.invert(input[i]);
+          DoNotOptimize(out[count / 2]);
+        },
+        error, inverseTolerance);
+  }
+}
+
+void Bench::RunAffineBenchmarks(Runner& runner, size_t count) {
+  const auto lhs = RandomAffine(count);
+  const auto rhs = RandomAffine(count);
+  const auto rigid = RandomRigid(count);
+  const auto vectors = RandomVector3s(count);
+  const math::Matrix4x4 projection = Projection();
+  std::vector<float> angles(count);
+  for (auto& angle : angles) angle = RandomFloat(-3.0f, 3.0f);
+  std::vector<math::Affine3x4> out(count);
+  std::vector<math::Matrix4x4> matrices(count);
+  std::vector<math::Vector3> points(count);
+
+  runner.Run("Affine3x4/CreateRotationYaw", "scalar", count, [&] {
+    for (size_t i = 0; i < count; ++i)
+      out[i] = math::Affine3x4::CreateRotationYaw(angles[i]);
+    DoNotOptimize(out[count / 2]);
+  });
+  runner.Run("Affine3x4/multiply", "scalar", count, [&] {
+    for (size_t i = 0; i < count; ++i) out[i] = lhs[i] * rhs[i];
+    DoNotOptimize(out[count / 2]);
+  });
+  runner.Run("Affine3x4/multiply projection", "scalar", count, [&] {
+    for (size_t i = 0; i < count; ++i) matrices[i] = lhs[i] * projection;
+    DoNotOptimize(matrices[count / 2]);
+  });
+  // Absolute error of A * A^-1 against the identity.
+  constexpr double roundTripTolerance = 1e-4;
+  double inverseError = 0.0;
+  double rigidError = 0.0;
+  for (size_t i = 0; i < count; ++i) {
+    inverseError =
+        std::max(inverseError, RoundTripError(lhs[i], lhs[i].Inverse()));
+    rigidError =
+        std::max(rigidError, RoundTripError(rigid[i], rigid[i].InverseRigid()));
+  }
+  runner.Run(
+      "Affine3x4/Inverse", "scalar", count,
+      [&] {
+        for (size_t i = 0; i < count; ++i) out[i] = lhs[i].Inverse();
+        DoNotOptimize(out[count / 2]);
+      },
+      inverseError, roundTripTolerance);
+  runner.Run(
+      "Affine3x4/InverseRigid", "scalar", count,
+      [&] {
+        for (size_t i = 0; i < count; ++i) out[i] = rigid[i].InverseRigid();
+        DoNotOptimize(out[count / 2]);
+      },
+      rigidError, roundTripTolerance);
+  runner.Run("Affine3x4/TransformPoint", "scalar", count, [&] {
+    for (size_t i = 0; i < count; ++i)
+      points[i] = lhs[i].TransformPoint(vectors[i]);
+    DoNotOptimize(points[count / 2]);
+  });
+  runner.Run("Affine3x4/ToMatrix4x4", "scalar", count, [&] {
+    for (size_t i = 0; i < count; ++i) matrices[i] = lhs[i].ToMatrix4x4();
+    DoNotOptimize(matrices[count / 2]);
+  });
+
+  std::vector<math::GpuMatrix> gpu(count);
+  runner.Run("GpuMatrix/from Affine3x4", "batch", count, [&] {
+    math::ToGpuMatrices(lhs.data(), gpu.data(), count);
+    DoNotOptimize(gpu[count / 2]);
+  });
+  runner.Run("GpuMatrix/from Matrix4x4", "batch", count, [&] {
+    math::ToGpuMatrices(matrices.data(), gpu.data(), count);
+    DoNotOptimize(gpu[count / 2]);
+  });
+}
+
+void Bench::RunQuaternionBenchmarks(Runner& runner, size_t count) {
+  const auto lhs = RandomRotations(count);
+  const auto rhs = RandomRotations(count);
+  const auto omega = RandomVector3s(count);
+  const auto vectors = RandomVector3s(count);
+  std::vector<math::Quaternion> out(count);
+  std::vector<math::Vector3> rotated(count);
+  std::vector<math::Affine3x4> affines(count);
+  std::vector<math::Matrix4x4> matrices(count);
+  const float dt = 1.0f / 120.0f;
+
+  runner.Run("Quaternion/multiply", "scalar", count, [&] {
+    for (size_t i = 0; i < count; ++i) out[i] = lhs[i] * rhs[i];
+    DoNotOptimize(out[count / 2]);
+  });
+  runner.Run("Quaternion/Rotate", "scalar", count, [&] {
+    for (size_t i = 0; i < count; ++i) rotated[i] = lhs[i].Rotate(vectors[i]);
+    DoNotOptimize(rotated[count / 2]);
+  });
+  runner.Run("Quaternion/Nlerp", "scalar", count, [&] {
+    for (size_t i = 0; i < count; ++i)
+      out[i] = math::Quaternion::Nlerp(lhs[i], rhs[i], 0.3f);
+    DoNotOptimize(out[count / 2]);
+  });
+  runner.Run("Quaternion/Slerp", "scalar", count, [&] {
+    for (size_t i = 0; i < count; ++i)
+      out[i] = math::Quaternion::Slerp(lhs[i], rhs[i], 0.3f);
+    DoNotOptimize(out[count / 2]);
+  });
+  runner.Run("Quaternion/Integrate", "scalar", count, [&] {
+    for (size_t i = 0; i < count; ++i) out[i] = lhs[i].Integrate(omega[i], dt);
+    DoNotOptimize(out[count / 2]);
+  });
+  runner.Run("Quaternion/Integrate", "batch", count, [&] {
+    math::IntegrateQuaternions(lhs.data(), omega.data(), dt, out.data(),
+                               count);
+    DoNotOptimize(out[count / 2]);
+  });
+  runner.Run("Quaternion/ToAffine3x4", "scalar", count, [&] {
+    for (size_t i = 0; i < count; ++i)
+      affines[i] = lhs[i].ToAffine3x4(vectors[i]);
+    DoNotOptimize(affines[count / 2]);
+  });
+  runner.Run("Quaternion/ToAffine3x4", "batch", count, [&] {
+    math::QuaternionsToAffines(lhs.data(), vectors.data(), affines.data(),
+                               count);
+    DoNotOptimize(affines[count / 2]);
+  });
+  runner.Run("Quaternion/ToMatrix4x4", "scalar", count, [&] {
+    for (size_t i = 0; i < count; ++i)
+      matrices[i] = lhs[i].ToAffine3x4(vectors[i]).ToMatrix4x4();
+    DoNotOptimize(matrices[count / 2]);
+  });
+  runner.Run("Quaternion/ToMatrix4x4", "batch", count, [&] {
+    math::QuaternionsToMatrices(lhs.data(), vectors.data(), matrices.data(),
+                                count);
+    DoNotOptimize(matrices[count / 2]);
+  });
+}
+
+void Bench::RunVectorBenchmarks(Runner& runner, size_t count) {
+  const auto a = RandomVector3s(count);
+  const auto b = RandomVector3s(count);
+  const auto c = RandomVector3s(count);
+  std::vector<math::Vector3> out(count);
+  std::vector<float> scalars(count);
+  const float dt = 1.0f / 120.0f;
+
+  runner.Run("Vector3/operator+", "scalar", count, [&] {
+    for (size_t i = 0; i < count; ++i) out[i] = a[i] + b[i];
+    DoNotOptimize(out[count / 2]);
+  });
+  runner.Run("Vector3/operator-", "scalar", count, [&] {
+    for (size_t i = 0; i < count; ++i) out[i] = a[i] - b[i];
+    DoNotOptimize(out[count / 2]);
+  });
+  runner.Run("Vector3/operator*", "scalar", count, [&] {
+    for (size_t i = 0; i < count; ++i) out[i] = a[i] * dt;
+    DoNotOptimize(out[count / 2]);
+  });
+  runner.Run("Vector3/Dot", "scalar", count, [&] {
+    for (size_t i = 0; i < count; ++i) scalars[i] = math::Dot(a[i], b[i]);
+    DoNotOptimize(scalars[count / 2]);
+  });
+  runner.Run("Vector3/Cross", "scalar", count, [&] {
+    for (size_t i = 0; i < count; ++i) out[i] = math::Cross(a[i], b[i]);
+    DoNotOptimize(out[count / 2]);
+  });
+
+  // p + v * dt + a * dt^2 / 2 written four ways.
+  runner.Run("Vector3/integrate", "operators", count, [&] {
+    for (size_t i = 0; i < count; ++i)
+      out[i] = a[i] + b[i] * dt + c[i] * (0.5f * dt * dt);
+    DoNotOptimize(out[count / 2]);
+  });
+  runner.Run("Vector3/integrate", "MulAdd", count, [&] {
+    for (size_t i = 0; i < count; ++i)
+      out[i] = math::IntegratePosition(a[i], b[i], c[i], dt);
+    DoNotOptimize(out[count / 2]);
+  });
+  runner.Run("Vector3/integrate", "expression", count, [&] {
+    for (size_t i = 0; i < count; ++i) {
+      out[i] = math::Evaluate(math::Lazy(a[i]) + math::Lazy(b[i]) * dt +
+                              math::Lazy(c[i]) * (0.5f * dt * dt));
+    }
+    DoNotOptimize(out[count / 2]);
+  });
+  runner.Run("Vector3/integrate", "batch", count, [&] {
+    math::IntegratePositions(a.data(), b.data(), c.data(), dt, out.data(),
+                             count);
+    DoNotOptimize(out[count / 2]);
+  });
+
+  std::vector<math::Vector2> a2(count), b2(count), out2(count);
+  for (size_t i = 0; i < count; ++i) {
+    a2[i] = math::Vector2(a[i].x, a[i].y);
+    b2[i] = math::Vector2(b[i].x, b[i].y);
+  }
+  runner.Run("Vector2/operator+", "scalar", count, [&] {
+    for (size_t i = 0; i < count; ++i) out2[i] = a2[i] + b2[i];
+    DoNotOptimize(out2[count / 2]);
+  });
+  runner.Run("Vector2/operator-", "scalar", count, [&] {
+    for (size_t i = 0; i < count; ++i) out2[i] = a2[i] - b2[i];
+    DoNotOptimize(out2[count / 2]);
+  });
+  runner.Run("Vector2/operator*", "scalar", count, [&] {
+    for (size_t i = 0; i < count; ++i) out2[i] = a2[i] * dt;
+    DoNotOptimize(out2[count / 2]);
+  });
+}
+
+void Bench::RunBatchBenchmarks(Runner& runner, size_t count) {
+  const auto aos = RandomVector3s(count);
+  const auto other = RandomVector3s(count);
+  math::Vector3Batch a(aos.data(), count);
+  const math::Vector3Batch b(other.data(), count);
+  math::Vector3Batch crossed;
+  std::vector<math::Vector3> aosOut(count);
+  std::vector<float> dots(count);
+
+  runner.Run("Vector3Batch/FromAoS", "soa", count, [&] {
+    a.FromAoS(aos.data(), count);
+    DoNotOptimize(a.X()[count / 2]);
+  });
+  runner.Run("Vector3Batch/ToAoS", "soa", count, [&] {
+    a.ToAoS(aosOut.data());
+    DoNotOptimize(aosOut[count / 2]);
+  });
+  runner.Run("Vector3Batch/Add", "soa", count, [&] {
+    a.Add(b);
+    DoNotOptimize(a.X()[count / 2]);
+  });
+  runner.Run("Vector3Batch/Scale", "soa", count, [&] {
+    a.Scale(0.999f);
+    DoNotOptimize(a.X()[count / 2]);
+  });
+  runner.Run("Vector3Batch/MulAdd", "soa", count, [&] {
+    a.MulAdd(b, 1e-3f);
+    DoNotOptimize(a.X()[count / 2]);
+  });
+  runner.Run("Vector3Batch/Dot", "soa", count, [&] {
+    math::Vector3Batch::Dot(a, b, dots.data());
+    DoNotOptimize(dots[count / 2]);
+  });
+  runner.Run("Vector3Batch/Cross", "soa", count, [&] {
+    math::Vector3Batch::Cross(a, b, crossed);
+    DoNotOptimize(crossed.X()[count / 2]);
+  });
+  runner.Run("Vector3Batch/Normalize", "soa", count, [&] {
+    a.Normalize();
+    DoNotOptimize(a.X()[count / 2]);
+  });
+  runner.Run("Vector3Batch/MinMax", "soa", count, [&] {
+    const math::Vector3 lower = a.Min();
+    const math::Vector3 upper = a.Max();
+    DoNotOptimize(lower);
+    DoNotOptimize(upper);
+  });
+
+  // The same bulk operations on array-of-structs data for comparison.
+  std::vector<math::Vector3> positions(aos);
+  runner.Run("Vector3Batch/MulAdd", "aos", count, [&] {
+    math::MulAdd(positions.data(), other.data(), 1e-3f, positions.data(),
+                 count);
+    DoNotOptimize(positions[count / 2]);
+  });
+  runner.Run("Vector3Batch/Normalize", "aos", count, [&] {
+    for (auto& v : positions) {
+      const float lengthSq = math::LengthSquared(v);
+      const float inv = lengthSq > 0.0f ? 1.0f / std::sqrt(lengthSq) : 0.0f;
+      v = math::Vector3(v.x * inv, v.y * inv, v.z * inv);
+    }
+    DoNotOptimize(positions[count / 2]);
+  });
+  runner.Run("Vector3Batch/MinMax", "aos", count, [&] {
+    math::Vector3 lower = positions[0];
+    math::Vector3 upper = positions[0];
+    for (const auto& v : positions) {
+      lower = math::Vector3(std::min(lower.x, v.x), std::min(lower.y, v.y),
+                            std::min(lower.z, v.z));
+      upper = math::Vector3(std::max(upper.x, v.x), std::max(upper.y, v.y),
+                            std::max(upper.z, v.z));
+    }
+    DoNotOptimize(lower);
+    DoNotOptimize(upper);
+  });
+}
+
+void Bench::RunDispatchBenchmarks(Runner& runner, size_t count) {
+  const math::SimdTier active = math::GetSimdTier();
+  const auto lhs = ToMatrices(RandomAffine(count));
+  const auto rhs = ToMatrices(RandomAffine(count));
+  std::vector<math::Matrix4x4> product(count);
+  std::vector<float> a(count), b(count), sum(count), expected(count);
+  for (size_t i = 0; i < count; ++i) {
+    a[i] = RandomFloat(-10.0f, 10.0f);
+    b[i] = RandomFloat(-10.0f, 10.0f);
+    expected[i] = a[i] + b[i] * 0.01f;
+  }
+
+  // Boxes of size 0.5 to 2 scattered over a 100^3 volume, queried with a
+  // box that overlaps a few percent of them.
+  std::vector<float> bounds[6];
+  for (auto& stream : bounds) stream.resize(count);
+  for (size_t i = 0; i < count; ++i) {
+    const math::Vector3 center = RandomVector3() * 5.0f;
+    const float size = RandomFloat(0.25f, 1.0f);
+    bounds[0][i] = center.x - size;
+    bounds[1][i] = center.y - size;
+    bounds[2][i] = center.z - size;
+    bounds[3][i] = center.x + size;
+    bounds[4][i] = center.y + size;
+    bounds[5][i] = center.z + size;
+  }
+  const math::AabbStreams boxes = {bounds[0].data(), bounds[1].data(),
+                                   bounds[2].data(), bounds[3].data(),
+                                   bounds[4].data(), bounds[5].data()};
+  const math::Aabb query = {math::Vector3(-15.0f, -15.0f, -15.0f),
+                            math::Vector3(15.0f, 15.0f, 15.0f)};
+  size_t expectedHits = 0;
+  for (size_t i = 0; i < count; ++i) {
+    const math::Aabb box = {math::Vector3(bounds[0][i], bounds[1][i],
+                                          bounds[2][i]),
+                            math::Vector3(bounds[3][i], bounds[4][i],
+                                          bounds[5][i])};
+    expectedHits += box.Overlaps(query);
+  }
+  std::vector<uint32_t> hits(count);
+
+  const int widest = static_cast<int>(math::DetectSimdTier());
+  for (int t = 0; t <= widest; ++t) {
+    const math::SimdTier tier =
+        math::SetSimdTier(static_cast<math::SimdTier>(t));
+    const std::string name = math::SimdTierName(tier);
+    runner.Run("dispatch/Multiply", name, count, [&] {
+      for (size_t i = 0; i < count; ++i)
+        math::Multiply(lhs[i], rhs[i], product[i]);
+      DoNotOptimize(product[count / 2]);
+    });
+
+    math::MulAddStream(a.data(), b.data(), 0.01f, sum.data(), count);
+    double error = 0.0;
+    for (size_t i = 0; i < count; ++i)
+      error = std::max(error, std::fabs(double(sum[i]) - expected[i]));
+    runner.Run(
+        "dispatch/MulAddStream", name, count,
+        [&] {
+          math::MulAddStream(a.data(), b.data(), 0.01f, sum.data(), count);
+          DoNotOptimize(sum[count / 2]);
+        },
+        error);
+
+    // The error column reports a miscount of overlapping boxes.
+    const size_t found = math::OverlapAabbs(query, boxes, count, hits.data());
+    runner.Run(
+        "dispatch/OverlapAabbs", name, count,
+        [&] {
+          DoNotOptimize(math::OverlapAabbs(query, boxes, count, hits.data()));
+        },
+        std::fabs(double(found) - double(expectedHits)), 0.0);
+  }
+  math::SetSimdTier(active);
+}
+
+void Bench::RunWorkloadBenchmarks(Runner& runner, size_t count) {
+  const std::string kernel = math::MatrixKernelName();
+  const math::Matrix4x4 scale =
+      math::Matrix4x4::CreateScaleMatrix(math::Vector3(0.1f, 0.1f, 0.1f));
+  const math::Matrix4x4 translation =
+      math::Matrix4x4::CreateTranslationMatrix(math::Vector3(0, 0, -0.3f));
+  const math::Matrix4x4 projection = Projection();
+  constexpr auto scaleAffine = math::Affine3x4::CreateScale(0.1f, 0.1f, 0.1f);
+  constexpr auto translationAffine =
+      math::Affine3x4::CreateTranslation(0.0f, 0.0f, -0.3f);
+  std::vector<float> yaw(count);
+  for (auto& angle : yaw) angle = RandomFloat(-3.0f, 3.0f);
+  std::vector<math::Matrix4x4> out(count);
+
+  // main.cpp's per-frame chain: scale * yaw * translation * projection.
+  runner.Run("workload/transform chain", "operator*", count, [&] {
+    for (size_t i = 0; i < count; ++i) {
+      out[i] = math::Matrix4x4::CreateIdentityMatrix() * scale *
+               math::Matrix4x4::CreateRotationYawMatrix(yaw[i]) * translation *
+               projection;
+    }
+    DoNotOptimize(out[count / 2]);
+  });
+  runner.Run("workload/transform chain", kernel, count, [&] {
+    for (size_t i = 0; i < count; ++i) {
+      math::Multiply(scale, math::Matrix4x4::CreateRotationYawMatrix(yaw[i]),
+                     out[i]);
+      math::Multiply(out[i], translation, out[i]);
+      math::Multiply(out[i], projection, out[i]);
+    }
+    DoNotOptimize(out[count / 2]);
+  });
+  runner.Run("workload/transform chain", "Affine3x4", count, [&] {
+    for (size_t i = 0; i < count; ++i) {
+      out[i] = scaleAffine * math::Affine3x4::CreateRotationYaw(yaw[i]) *
+               translationAffine * projection;
+    }
+    DoNotOptimize(out[count / 2]);
+  });
+
+  // Rigid bodies: integrate orientation and position, then build the
+  // instance matrices that would be uploaded.
+  auto orientations = RandomRotations(count);
+  auto positions = RandomVector3s(count);
+  const auto angular = RandomVector3s(count);
+  const auto linear = RandomVector3s(count);
+  std::vector<math::GpuMatrix> instances(count);
+  std::vector<math::Affine3x4> affines(count);
+  const float dt = 1.0f / 120.0f;
+  runner.Run("workload/body step", "scalar", count, [&] {
+    for (size_t i = 0; i < count; ++i) {
+      orientations[i] = orientations[i].Integrate(angular[i], dt);
+      positions[i] = math::MulAdd(positions[i], linear[i], dt);
+      instances[i] =
+          math::ToGpuMatrix(orientations[i].ToAffine3x4(positions[i]));
+    }
+    DoNotOptimize(instances[count / 2]);
+  });
+  runner.Run("workload/body step", "batch", count, [&] {
+    math::IntegrateQuaternions(orientations.data(), angular.data(), dt,
+                               orientations.data(), count);
+    math::MulAdd(positions.data(), linear.data(), dt, positions.data(), count);
+    math::QuaternionsToAffines(orientations.data(), positions.data(),
+                               affines.data(), count);
+    math::ToGpuMatrices(affines.data(), instances.data(), count);
+    DoNotOptimize(instances[count / 2]);
+  });
+
+  // The same step through the SoA rigid-body world.
+  Engine::PhysicsWorld world;
+  for (size_t i = 0; i < count; ++i) {
+    Engine::RigidBodyDesc desc;
+    desc.position = positions[i];
+    desc.orientation = orientations[i];
+    desc.linearVelocity = linear[i];
+    desc.angularVelocity = angular[i];
+    world.CreateBody(desc);
+  }
+  runner.Run("workload/body step", "PhysicsWorld", count, [&] {
+    world.Step(dt);
+    DoNotOptimize(world);
+  });
+}
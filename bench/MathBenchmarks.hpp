@@ -0,0 +1,18 @@
+#pragma once
+
+#include "Benchmark.hpp"
+
+namespace Bench {
+// Each suite works on arrays of `count` elements so the timed loops cannot
+// be folded away, and reports the time per element.
+void RunMatrixBenchmarks(Runner& runner, size_t count);
+void RunAffineBenchmarks(Runner& runner, size_t count);
+void RunQuaternionBenchmarks(Runner& runner, size_t count);
+void RunVectorBenchmarks(Runner& runner, size_t count);
+void RunBatchBenchmarks(Runner& runner, size_t count);
+// The runtime-dispatched kernels once per SIMD tier the CPU supports. Restores
+// the active tier afterwards.
+void RunDispatchBenchmarks(Runner& runner, size_t count);
+// Realistic pipelines, e.g. main.cpp's per-object transform chain.
+void RunWorkloadBenchmarks(Runner& runner, size_t count);
+}  // namespace Bench
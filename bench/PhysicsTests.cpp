@@ -0,0 +1,789 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "Aabb.hpp"
+#include "Collider.hpp"
+#include "Collision.hpp"
+#include "ContactCache.hpp"
+#include "ContactSolver.hpp"
+#include "ConvexHull.hpp"
+#include "CpuFeatures.hpp"
+#include "DynamicAabbTree.hpp"
+#include "GameObject.hpp"
+#include "Gjk.hpp"
+#include "JobSystem.hpp"
+#include "PairSet.hpp"
+#include "PhysicsWorld.hpp"
+#include "Quaternion.hpp"
+#include "Scene.hpp"
+#include "SceneCommands.hpp"
+#include "SpatialHashGrid.hpp"
+#include "SweepAndPrune.hpp"
+#include "Vector3.hpp"
+
+// Correctness checks for the physics code, built from the same engine
+// sources as math_bench. Every failed check is printed; the exit status is
+// non-zero if any failed.
+namespace {
+using math::Vector3;
+using PairList = std::set<std::pair<uint32_t, uint32_t>>;
+
+int failures = 0;
+
+void Check(bool condition, const char* test, const std::string& what) {
+  if (condition) return;
+  ++failures;
+  std::fprintf(stderr, "  %s: %s\n", test, what.c_str());
+}
+
+void CheckNear(float value, float expected, float tolerance, const char* test,
+               const char* what) {
+  char text[160];
+  std::snprintf(text, sizeof(text), "%s is %g, expected %g", what, value,
+                expected);
+  Check(std::fabs(value - expected) <= tolerance, test, text);
+}
+
+void CheckNear(const Vector3& value, const Vector3& expected, float tolerance,
+               const char* test, const char* what) {
+  char text[160];
+  std::snprintf(text, sizeof(text), "%s is (%g, %g, %g), expected (%g, %g, %g)",
+                what, value.x, value.y, value.z, expected.x, expected.y,
+                expected.z);
+  Check(std::fabs(value.x - expected.x) <= tolerance &&
+            std::fabs(value.y - expected.y) <= tolerance &&
+            std::fabs(value.z - expected.z) <= tolerance,
+        test, text);
+}
+
+// Fixed seed, so a failure reproduces.
+std::mt19937& Generator() {
+  static std::mt19937 generator(1207);
+  return generator;
+}
+
+float RandomFloat(float low, float high) {
+  return std::uniform_real_distribution<float>(low, high)(Generator());
+}
+
+uint32_t RandomIndex(uint32_t count) {
+  return std::uniform_int_distribution<uint32_t>(0, count - 1)(Generator());
+}
+
+Vector3 RandomVector3(float extent) {
+  return Vector3(RandomFloat(-extent, extent), RandomFloat(-extent, extent),
+                 RandomFloat(-extent, extent));
+}
+
+math::Aabb RandomBox(float extent) {
+  const Vector3 center = RandomVector3(extent);
+  const Vector3 half(RandomFloat(0.1f, 1.0f), RandomFloat(0.1f, 1.0f),
+                     RandomFloat(0.1f, 1.0f));
+  return {center - half, center + half};
+}
+
+// ---------------------------------------------------------------------------
+// Broadphases against brute force.
+
+PairList BruteForcePairs(const std::vector<math::Aabb>& boxes,
+                         const std::vector<bool>& alive) {
+  PairList pairs;
+  for (uint32_t i = 0; i < boxes.size(); ++i) {
+    if (!alive[i]) continue;
+    for (uint32_t j = i + 1; j < boxes.size(); ++j) {
+      if (alive[j] && boxes[i].Overlaps(boxes[j])) pairs.insert({i, j});
+    }
+  }
+  return pairs;
+}
+
+// The pairs as box indices, `toBox` mapping a proxy to its box. Each pair
+// must be reported once.
+template <typename ToBox>
+PairList ToBoxPairs(const std::vector<Engine::BroadphasePair>& found,
+                    ToBox&& toBox, const char* test, const char* what) {
+  PairList pairs;
+  bool unique = true;
+  for (const Engine::BroadphasePair& pair : found) {
+    const uint32_t a = toBox(pair.a);
+    const uint32_t b = toBox(pair.b);
+    unique &= pairs.insert({std::min(a, b), std::max(a, b)}).second;
+  }
+  Check(unique, test, std::string(what) + " reported a pair twice");
+  return pairs;
+}
+
+void TestBroadphases() {
+  const char* test = "broadphase pairs";
+  // Enough boxes for the grid to build and pair in parallel.
+  const uint32_t count = 5000;
+  std::vector<math::Aabb> boxes(count);
+  std::vector<bool> alive(count, true);
+  for (auto& box : boxes) box = RandomBox(30.0f);
+
+  Engine::DynamicAabbTree tree;
+  Engine::SweepAndPrune sweep;
+  // Leaves y out of the sort; the pairs read back must still be exact.
+  Engine::SweepAndPrune sweepXZ(Engine::SweepAndPrune::AXIS_X |
+                                Engine::SweepAndPrune::AXIS_Z);
+  std::vector<uint32_t> treeProxies(count), sweepProxies(count),
+      sweepXZProxies(count);
+  for (uint32_t i = 0; i < count; ++i) {
+    treeProxies[i] = tree.CreateProxy(boxes[i], i);
+    sweepProxies[i] = sweep.CreateProxy(boxes[i], i);
+    sweepXZProxies[i] = sweepXZ.CreateProxy(boxes[i], i);
+  }
+  Engine::JobSystem jobs;
+  jobs.Start(3);
+
+  std::vector<Engine::BroadphasePair> found;
+  for (int round = 0; round < 3; ++round) {
+    const PairList expected = BruteForcePairs(boxes, alive);
+
+    // The tree compares fat boxes, so it finds every exact pair plus some
+    // whose fat boxes overlap.
+    tree.UpdatePairs();
+    found.clear();
+    tree.GetOverlappingPairs(found);
+    const PairList treePairs = ToBoxPairs(
+        found, [&](uint32_t p) { return tree.GetUserData(p); }, test, "tree");
+    Check(std::includes(treePairs.begin(), treePairs.end(), expected.begin(),
+                        expected.end()),
+          test, "tree missed an overlapping pair");
+    bool fatOverlap = true;
+    for (const Engine::BroadphasePair& pair : found) {
+      fatOverlap &= tree.GetFatBox(pair.a).Overlaps(tree.GetFatBox(pair.b));
+    }
+    Check(fatOverlap, test, "tree reported boxes whose fat boxes are apart");
+
+    for (Engine::SweepAndPrune* s : {&sweep, &sweepXZ}) {
+      s->Update();
+      found.clear();
+      s->GetOverlappingPairs(found);
+      const PairList pairs = ToBoxPairs(
+          found, [&](uint32_t p) { return s->GetUserData(p); }, test,
+          "sweep and prune");
+      Check(pairs == expected, test,
+            s == &sweep ? "sweep and prune differs from brute force"
+                        : "sweep and prune on x and z differs from brute "
+                          "force");
+    }
+
+    // The grid is rebuilt from the live boxes, as Scene does every step.
+    std::vector<math::Aabb> live;
+    std::vector<uint32_t> liveIndex;
+    for (uint32_t i = 0; i < count; ++i) {
+      if (!alive[i]) continue;
+      live.push_back(boxes[i]);
+      liveIndex.push_back(i);
+    }
+    Engine::SpatialHashGrid serialGrid;
+    serialGrid.Build(live.data(), live.size());
+    std::vector<Engine::BroadphasePair> serial;
+    serialGrid.FindPairs(serial);
+    Check(ToBoxPairs(
+              serial, [&](uint32_t i) { return liveIndex[i]; }, test,
+              "grid") == expected,
+          test, "grid differs from brute force");
+    // Built and paired on the job system, it must match the serial grid
+    // pair for pair, in the same order.
+    Engine::SpatialHashGrid parallelGrid;
+    parallelGrid.SetJobSystem(&jobs);
+    parallelGrid.Build(live.data(), live.size());
+    found.clear();
+    parallelGrid.FindPairs(found);
+    Check(found.size() == serial.size() &&
+              std::equal(found.begin(), found.end(), serial.begin(),
+                         [](const Engine::BroadphasePair& a,
+                            const Engine::BroadphasePair& b) {
+                           return a.a == b.a && a.b == b.b;
+                         }),
+          test, "parallel grid differs from the serial grid");
+
+    // Nudges most boxes, teleports some and destroys a few for the next
+    // round.
+    for (uint32_t i = 0; i < count; ++i) {
+      if (!alive[i]) continue;
+      if (i % 97 == static_cast<uint32_t>(round)) {
+        alive[i] = false;
+        tree.DestroyProxy(treeProxies[i]);
+        sweep.DestroyProxy(sweepProxies[i]);
+        sweepXZ.DestroyProxy(sweepXZProxies[i]);
+        continue;
+      }
+      const Vector3 offset =
+          i % 10 == 0 ? RandomVector3(15.0f) : RandomVector3(0.3f);
+      boxes[i] = {boxes[i].min + offset, boxes[i].max + offset};
+      tree.MoveProxy(treeProxies[i], boxes[i], offset);
+      sweep.MoveProxy(sweepProxies[i], boxes[i]);
+      sweepXZ.MoveProxy(sweepXZProxies[i], boxes[i]);
+    }
+  }
+  jobs.Stop();
+}
+
+// ---------------------------------------------------------------------------
+// GJK distance and EPA depth.
+
+const Vector3 cubePoints[8] = {
+    Vector3(-0.5f, -0.5f, -0.5f), Vector3(0.5f, -0.5f, -0.5f),
+    Vector3(-0.5f, 0.5f, -0.5f),  Vector3(0.5f, 0.5f, -0.5f),
+    Vector3(-0.5f, -0.5f, 0.5f),  Vector3(0.5f, -0.5f, 0.5f),
+    Vector3(-0.5f, 0.5f, 0.5f),   Vector3(0.5f, 0.5f, 0.5f)};
+
+Engine::Pose MakePose(const Vector3& position,
+                      const math::Quaternion& orientation = {}) {
+  Engine::Pose pose;
+  pose.position = position;
+  pose.orientation = orientation;
+  return pose;
+}
+
+void TestGjkDistance() {
+  const char* test = "gjk distance";
+  const Engine::ConvexHull cube(cubePoints, 8);
+  const Engine::Pose origin = MakePose(Vector3(0.0f, 0.0f, 0.0f));
+
+  // Face to face.
+  Engine::GjkResult r = Engine::GjkDistance(
+      cube, origin, cube, MakePose(Vector3(3.0f, 0.0f, 0.0f)), nullptr);
+  Check(!r.overlap, test, "cubes 3 apart overlap");
+  CheckNear(r.distance, 2.0f, 1e-4f, test, "distance of cubes 3 apart");
+  CheckNear(r.pointA.x, 0.5f, 1e-4f, test, "closest x on the first cube");
+  CheckNear(r.pointB.x, 2.5f, 1e-4f, test, "closest x on the second cube");
+
+  // Face to edge: the second cube turned 45 degrees about z reaches
+  // sqrt(0.5) towards the first.
+  const math::Quaternion turned =
+      math::Quaternion::CreateFromAxisAngle(Vector3(0.0f, 0.0f, 1.0f),
+                                            0.785398163f);
+  r = Engine::GjkDistance(cube, origin, cube,
+                          MakePose(Vector3(3.0f, 0.2f, 0.0f), turned),
+                          nullptr);
+  CheckNear(r.distance, 2.5f - std::sqrt(0.5f), 1e-4f, test,
+            "distance of a cube and a turned cube");
+
+  // Point to face, then point to vertex, of the cube turned about z.
+  const Vector3 point(0.0f, 0.0f, 0.0f);
+  const Engine::ConvexHull single(&point, 1);
+  r = Engine::GjkDistance(single, MakePose(Vector3(0.1f, 2.0f, 0.2f)), cube,
+                          origin, nullptr);
+  CheckNear(r.distance, 1.5f, 1e-4f, test, "distance of a point to a face");
+  CheckNear(r.pointB, Vector3(0.1f, 0.5f, 0.2f), 1e-4f, test,
+            "closest point on the face");
+  r = Engine::GjkDistance(single, MakePose(Vector3(2.0f, 2.0f, 2.0f)), cube,
+                          origin, nullptr);
+  CheckNear(r.distance, 1.5f * std::sqrt(3.0f), 1e-4f, test,
+            "distance of a point to a vertex");
+
+  // The cache seeds the next query with the last simplex.
+  Engine::GjkCache cache;
+  Engine::GjkDistance(cube, origin, cube, MakePose(Vector3(3.0f, 0.0f, 0.0f)),
+                      &cache);
+  r = Engine::GjkDistance(cube, origin, cube,
+                          MakePose(Vector3(3.01f, 0.0f, 0.0f)), &cache);
+  CheckNear(r.distance, 2.01f, 1e-4f, test, "distance with a warm cache");
+  Check(r.iterations <= 2, test, "warm cache did not converge at once");
+
+  // Overlapping shapes.
+  r = Engine::GjkDistance(cube, origin, cube,
+                          MakePose(Vector3(0.9f, 0.3f, 0.0f)), nullptr);
+  Check(r.overlap, test, "overlapping cubes reported apart");
+}
+
+void TestEpaDepth() {
+  const char* test = "epa depth";
+  const Engine::ConvexHull cube(cubePoints, 8);
+  const Engine::Pose origin = MakePose(Vector3(0.0f, 0.0f, 0.0f));
+
+  Engine::ConvexContact contact;
+  Check(Engine::CollideConvex(cube, origin, cube,
+                              MakePose(Vector3(0.8f, 0.0f, 0.0f)), nullptr,
+                              contact),
+        test, "cubes 0.8 apart do not collide");
+  CheckNear(contact.depth, 0.2f, 1e-3f, test, "depth of cubes 0.8 apart");
+  CheckNear(contact.normal, Vector3(1.0f, 0.0f, 0.0f), 1e-3f, test,
+            "normal of cubes 0.8 apart");
+
+  // The shallowest axis wins, whichever way it points.
+  Check(Engine::CollideConvex(cube, origin, cube,
+                              MakePose(Vector3(0.3f, -0.85f, 0.1f)), nullptr,
+                              contact),
+        test, "cubes 0.85 apart in y do not collide");
+  CheckNear(contact.depth, 0.15f, 1e-3f, test, "depth of cubes 0.85 apart");
+  CheckNear(contact.normal, Vector3(0.0f, -1.0f, 0.0f), 1e-3f, test,
+            "normal of cubes 0.85 apart");
+
+  Check(!Engine::CollideConvex(cube, origin, cube,
+                               MakePose(Vector3(1.1f, 0.0f, 0.0f)), nullptr,
+                               contact),
+        test, "cubes 1.1 apart collide");
+
+  // A sphere against a box hull goes through GJK/EPA on the sphere's
+  // center; against the closed-form box it must give the same answer. The
+  // deep case has the center inside the box: depth = 0.2 + radius.
+  const Engine::Collider hull = Engine::Collider::Convex(cube);
+  const Engine::Collider box =
+      Engine::Collider::Box(Vector3(0.5f, 0.5f, 0.5f));
+  const Engine::Collider sphere = Engine::Collider::Sphere(0.5f);
+  const struct {
+    float height;
+    float depth;
+  } cases[] = {{0.9f, 0.1f}, {0.3f, 0.7f}};
+  for (const auto& c : cases) {
+    for (const Engine::Collider* shape : {&hull, &box}) {
+      const char* what =
+          shape == &hull ? "sphere on a hull" : "sphere on a box";
+      Engine::ContactManifold manifold;
+      const bool touching = Engine::Collide(
+          *shape, origin, sphere, MakePose(Vector3(0.1f, c.height, -0.2f)),
+          nullptr, manifold);
+      Check(touching && manifold.pointCount == 1, test,
+            std::string(what) + " has no single contact point");
+      if (manifold.pointCount == 0) continue;
+      CheckNear(manifold.points[0].depth, c.depth, 1e-3f, test, what);
+      CheckNear(manifold.normal, Vector3(0.0f, 1.0f, 0.0f), 1e-3f, test,
+                what);
+    }
+  }
+  Engine::ContactManifold manifold;
+  Check(!Engine::Collide(hull, origin, sphere,
+                         MakePose(Vector3(0.0f, 1.2f, 0.0f)), nullptr,
+                         manifold),
+        test, "sphere 0.2 above a hull touches it");
+}
+
+// ---------------------------------------------------------------------------
+// PairSet under churn, with an array kept parallel to GetPairs() the way
+// the broadphases and the contact cache keep theirs.
+
+void TestPairSet() {
+  const char* test = "pair set";
+  Engine::PairSet set;
+  PairList expected;
+  std::vector<uint64_t> parallel;
+  auto key = [](uint32_t a, uint32_t b) {
+    return static_cast<uint64_t>(std::min(a, b)) << 32 | std::max(a, b);
+  };
+
+  for (int round = 0; round < 2; ++round) {
+    for (int op = 0; op < 50000; ++op) {
+      const uint32_t a = RandomIndex(96);
+      uint32_t b = RandomIndex(96);
+      if (a == b) b = (b + 1) % 96;
+      const auto pair = std::make_pair(std::min(a, b), std::max(a, b));
+      // Inserts win early so the set grows; erases win late so it shrinks.
+      const bool insert = RandomIndex(100) < (op < 25000 ? 70u : 30u);
+      if (insert) {
+        const bool added = set.Insert(a, b);
+        Check(added == expected.insert(pair).second, test,
+              "Insert disagrees with std::set");
+        if (added) parallel.push_back(key(a, b));
+      } else {
+        const uint32_t index = set.IndexOf(b, a);
+        const bool erased = set.Erase(b, a);
+        Check(erased == (expected.erase(pair) == 1), test,
+              "Erase disagrees with std::set");
+        Check(erased == (index != Engine::PairSet::notFound), test,
+              "IndexOf disagrees with Erase");
+        if (erased) {
+          parallel[index] = parallel.back();
+          parallel.pop_back();
+        }
+      }
+      Check(set.Contains(a, b) == (expected.count(pair) == 1), test,
+            "Contains disagrees with std::set");
+      if (failures > 20) return;
+    }
+
+    Check(set.Size() == expected.size(), test, "wrong size");
+    const auto& pairs = set.GetPairs();
+    bool consistent = pairs.size() == parallel.size();
+    for (uint32_t i = 0; consistent && i < pairs.size(); ++i) {
+      consistent = pairs[i].a < pairs[i].b &&
+                   expected.count({pairs[i].a, pairs[i].b}) == 1 &&
+                   set.IndexOf(pairs[i].b, pairs[i].a) == i &&
+                   parallel[i] == key(pairs[i].a, pairs[i].b);
+    }
+    Check(consistent, test, "GetPairs, IndexOf and the parallel array differ");
+
+    set.Clear();
+    expected.clear();
+    parallel.clear();
+    Check(set.Size() == 0 && !set.Contains(1, 2) &&
+              set.IndexOf(1, 2) == Engine::PairSet::notFound,
+          test, "not empty after Clear");
+  }
+}
+
+// ---------------------------------------------------------------------------
+// ContactCache.
+
+Engine::ContactManifold MakeManifold(std::initializer_list<uint32_t> ids) {
+  Engine::ContactManifold manifold;
+  manifold.normal = Vector3(0.0f, 1.0f, 0.0f);
+  for (uint32_t id : ids) {
+    Engine::ContactPoint& point = manifold.points[manifold.pointCount++];
+    point.position = Vector3(0.0f, 0.0f, 0.0f);
+    point.depth = 0.01f;
+    point.id = id;
+  }
+  return manifold;
+}
+
+void TestContactCache() {
+  const char* test = "contact cache";
+  Engine::ContactCache cache;
+  std::vector<Engine::RigidBodyPair> separated;
+  const Engine::RigidBodyHandle b0{0, 0}, b1{1, 0}, b2{2, 0}, b1Reused{1, 1};
+
+  cache.BeginStep();
+  Engine::Contact& first = cache.Acquire(b1, b0);
+  Check(first.a == b0 && first.b == b1, test, "pair not ordered by slot");
+  Engine::ContactCache::Update(first, MakeManifold({10, 20, 30}));
+  for (int i = 0; i < 3; ++i) {
+    first.impulses[i].normal = 1.0f + i;
+    first.impulses[i].tangent[0] = -1.0f - i;
+  }
+  Engine::ContactCache::Update(cache.Acquire(b0, b2), MakeManifold({5}));
+  cache.EndStep(separated);
+  Check(cache.Size() == 2 && separated.empty(), test,
+        "first step did not keep both pairs");
+
+  // Points 20 and 30 persist and keep their impulses, in their new slots;
+  // point 40 is new and starts from zero.
+  cache.BeginStep();
+  Engine::Contact& again = cache.Acquire(b0, b1);
+  Engine::ContactCache::Update(again, MakeManifold({30, 40, 20}));
+  CheckNear(again.impulses[0].normal, 3.0f, 0.0f, test, "impulse of id 30");
+  CheckNear(again.impulses[0].tangent[0], -3.0f, 0.0f, test,
+            "friction impulse of id 30");
+  CheckNear(again.impulses[1].normal, 0.0f, 0.0f, test, "impulse of id 40");
+  CheckNear(again.impulses[2].normal, 2.0f, 0.0f, test, "impulse of id 20");
+  CheckNear(again.impulses[3].normal, 0.0f, 0.0f, test, "unused impulse");
+  // Pair (0, 2) was not acquired: it is dropped and, having touched,
+  // reported as separated.
+  cache.EndStep(separated);
+  Check(cache.Size() == 1, test, "pair not acquired was kept");
+  Check(separated.size() == 1 && separated[0].a == b0 && separated[0].b == b2,
+        test, "dropped touching pair not reported as separated");
+
+  // Slot 1 now holds another body: the pair starts over.
+  cache.BeginStep();
+  Engine::Contact& reused = cache.Acquire(b0, b1Reused);
+  Check(reused.manifold.pointCount == 0 && reused.impulses[0].normal == 0.0f,
+        test, "contact survived its body's slot being reused");
+  Engine::ContactCache::Update(reused, MakeManifold({30}));
+  CheckNear(reused.impulses[0].normal, 0.0f, 0.0f, test,
+            "impulse after the slot was reused");
+  separated.clear();
+  cache.EndStep(separated);
+  Check(cache.Size() == 1 && separated.empty(), test,
+        "reused pair not kept as one contact");
+}
+
+// ---------------------------------------------------------------------------
+// Solver determinism: a stack of boxes must come to rest in exactly the
+// same place whatever the thread count and SIMD tier.
+
+struct StackResult {
+  std::vector<Vector3> positions;
+  std::vector<math::Quaternion> orientations;
+  size_t contacts;
+};
+
+StackResult RunStack(Engine::SolverMode mode, unsigned threads) {
+  Engine::JobSystem jobs;
+  jobs.Start(threads - 1);
+  StackResult result;
+  {
+    Engine::Scene scene;
+    scene.SetJobSystem(&jobs);
+    scene.GetContactSolver().SetMode(mode);
+    scene.GetContactSolver().SetIterations(8);
+    scene.GetPhysicsWorld().SetTimeToSleep(1e30f);
+
+    std::vector<std::shared_ptr<Engine::GameObject>> objects;
+    auto add = [&](const Vector3& position, float mass,
+                   const Engine::Collider& collider) {
+      auto object = std::make_shared<Engine::GameObject>();
+      scene.AddGameObject(object);
+      Engine::RigidBodyDesc desc;
+      desc.position = position;
+      desc.mass = mass;
+      desc.collider = collider;
+      desc.inertia = Engine::ComputeBoxInertia(mass, collider.halfExtents);
+      scene.AddRigidBody(*object, desc);
+      objects.push_back(object);
+    };
+    add(Vector3(0.0f, -0.5f, 0.0f), 0.0f,
+        Engine::Collider::Box(Vector3(20.0f, 0.5f, 20.0f)));
+    // Slightly staggered, so the boxes slide and tip rather than sit.
+    for (int y = 0; y < 4; ++y) {
+      for (int x = 0; x < 4; ++x) {
+        for (int z = 0; z < 3; ++z) {
+          add(Vector3(x * 1.02f + 0.03f * y, 0.5f + y * 1.01f,
+                      z * 1.02f - 0.02f * y),
+              1.0f, Engine::Collider::Box(Vector3(0.5f, 0.5f, 0.5f)));
+        }
+      }
+    }
+    for (int step = 0; step < 120; ++step) scene.FixedUpdate(1.0f / 60.0f);
+
+    const Engine::PhysicsWorld& world = scene.GetPhysicsWorld();
+    for (const auto& object : objects) {
+      result.positions.push_back(world.GetPosition(object->GetRigidBody()));
+      result.orientations.push_back(
+          world.GetOrientation(object->GetRigidBody()));
+    }
+    result.contacts = scene.GetContacts().size();
+    scene.Exit();
+  }
+  jobs.Stop();
+  return result;
+}
+
+bool BitwiseEqual(const StackResult& a, const StackResult& b) {
+  return a.contacts == b.contacts &&
+         a.positions.size() == b.positions.size() &&
+         std::memcmp(a.positions.data(), b.positions.data(),
+                     a.positions.size() * sizeof(Vector3)) == 0 &&
+         std::memcmp(a.orientations.data(), b.orientations.data(),
+                     a.orientations.size() * sizeof(math::Quaternion)) == 0;
+}
+
+float MaxPositionDifference(const StackResult& a, const StackResult& b) {
+  float difference = 0.0f;
+  for (size_t i = 0; i < a.positions.size() && i < b.positions.size(); ++i) {
+    const Vector3 d = a.positions[i] - b.positions[i];
+    difference = std::max({difference, std::fabs(d.x), std::fabs(d.y),
+                           std::fabs(d.z)});
+  }
+  return difference;
+}
+
+void TestSolverDeterminism() {
+  const char* test = "solver determinism";
+  const math::SimdTier initial = math::GetSimdTier();
+  // Every tier this machine runs, once each.
+  std::vector<math::SimdTier> tiers;
+  for (int t = 0; t <= static_cast<int>(math::SimdTier::AVX512); ++t) {
+    const math::SimdTier tier =
+        math::SetSimdTier(static_cast<math::SimdTier>(t));
+    if (std::find(tiers.begin(), tiers.end(), tier) == tiers.end())
+      tiers.push_back(tier);
+  }
+
+  for (Engine::SolverMode mode :
+       {Engine::SolverMode::ISLANDS, Engine::SolverMode::GRAPH_COLORING}) {
+    const char* modeName =
+        mode == Engine::SolverMode::ISLANDS ? "islands" : "graph coloring";
+    // The AVX2 tiers integrate with fused multiply-adds, which round once
+    // instead of twice: bit for bit they match each other, not the tiers
+    // below, which must still agree closely.
+    StackResult references[2];
+    math::SimdTier referenceTiers[2];
+    bool haveReference[2] = {false, false};
+    for (math::SimdTier tier : tiers) {
+      math::SetSimdTier(tier);
+      const int fused = tier >= math::SimdTier::AVX2 ? 1 : 0;
+      if (!haveReference[fused]) {
+        references[fused] = RunStack(mode, 1);
+        referenceTiers[fused] = tier;
+        haveReference[fused] = true;
+        Check(references[fused].contacts > 0, test,
+              "the stack has no contacts");
+      }
+      for (unsigned threads : {1u, 2u, 4u}) {
+        char what[160];
+        std::snprintf(what, sizeof(what),
+                      "%s on %s with %u threads differs from %s with 1",
+                      modeName, math::SimdTierName(tier), threads,
+                      math::SimdTierName(referenceTiers[fused]));
+        Check(BitwiseEqual(RunStack(mode, threads), references[fused]), test,
+              what);
+      }
+    }
+    if (haveReference[0] && haveReference[1]) {
+      CheckNear(MaxPositionDifference(references[0], references[1]), 0.0f,
+                1e-3f, test, "position difference with and without fma");
+    }
+  }
+  math::SetSimdTier(initial);
+}
+
+// ---------------------------------------------------------------------------
+// Continuous collision: a small sphere moving 5 m per step meets a wall
+// 2 cm thick.
+
+float ShootAtThinWall(bool continuous) {
+  Engine::Scene scene;
+  scene.GetPhysicsWorld().SetGravity(Vector3(0.0f, 0.0f, 0.0f));
+  auto add = [&](const Vector3& position, float mass,
+                 const Engine::Collider& collider, const Vector3& velocity,
+                 bool isContinuous) {
+    auto object = std::make_shared<Engine::GameObject>();
+    scene.AddGameObject(object);
+    Engine::RigidBodyDesc desc;
+    desc.position = position;
+    desc.mass = mass;
+    desc.collider = collider;
+    desc.linearVelocity = velocity;
+    desc.continuous = isContinuous;
+    if (mass > 0.0f)
+      desc.inertia = Engine::ComputeSphereInertia(mass, collider.radius);
+    return scene.AddRigidBody(*object, desc);
+  };
+  add(Vector3(5.0f, 0.0f, 0.0f), 0.0f,
+      Engine::Collider::Box(Vector3(0.01f, 2.0f, 2.0f)),
+      Vector3(0.0f, 0.0f, 0.0f), false);
+  const Engine::RigidBodyHandle bullet =
+      add(Vector3(0.0f, 0.3f, 0.2f), 1.0f, Engine::Collider::Sphere(0.05f),
+          Vector3(300.0f, 0.0f, 0.0f), continuous);
+  for (int step = 0; step < 60; ++step) scene.FixedUpdate(1.0f / 60.0f);
+  const float x = scene.GetPhysicsWorld().GetPosition(bullet).x;
+  scene.Exit();
+  return x;
+}
+
+void TestContinuousCollision() {
+  const char* test = "continuous collision";
+  // The wall's near face is at 4.99; the sphere stops against it.
+  const float stopped = ShootAtThinWall(true);
+  Check(stopped <= 4.99f - 0.05f + 1e-3f, test,
+        "continuous sphere passed the wall, x = " + std::to_string(stopped));
+  // Without it the sphere steps from 0 to 5 m to 10 m, over the wall.
+  const float passed = ShootAtThinWall(false);
+  Check(passed > 5.0f, test,
+        "discrete sphere stopped, so the case no longer tests anything");
+}
+
+// ---------------------------------------------------------------------------
+// SceneCommands: applied in object order, serial or parallel update alike.
+
+struct CommandLog {
+  // Object ids in the order their deferred writes ran, per frame.
+  std::vector<std::vector<int>> frames;
+  int initialized = 0;
+};
+
+class LoggingObject : public Engine::GameObject {
+ private:
+  int id;
+  CommandLog& log;
+
+ public:
+  LoggingObject(int id, CommandLog& log) : id(id), log(log) {}
+
+  bool Initialize() override {
+    ++log.initialized;
+    return true;
+  }
+
+  void UpdateDeferred(Engine::SceneCommands& commands) override {
+    const int self = id;
+    CommandLog* target = &log;
+    commands.Defer([target, self](Engine::Scene&) {
+      target->frames.back().push_back(self);
+    });
+    const size_t frame = log.frames.size() - 1;
+    // Spawns land at the end of the scene, destroys leave it; neither
+    // shows before the next frame.
+    if (frame == 0 && id < 1000 && id % 50 == 7)
+      commands.Spawn(std::make_shared<LoggingObject>(1000 + id, log));
+    if (frame == 0 && id % 40 == 3) commands.Destroy(*this);
+  }
+};
+
+void TestSceneCommands() {
+  const char* test = "scene commands";
+  // Several update chunks, so a parallel update splits the objects.
+  const int count = 600;
+  std::vector<int> firstFrame, secondFrame, spawned;
+  for (int id = 0; id < count; ++id) {
+    firstFrame.push_back(id);
+    if (id % 40 != 3) secondFrame.push_back(id);
+    if (id % 50 == 7) spawned.push_back(1000 + id);
+  }
+  secondFrame.insert(secondFrame.end(), spawned.begin(), spawned.end());
+
+  Engine::JobSystem jobs;
+  jobs.Start(3);
+  for (bool parallel : {false, true}) {
+    const std::string mode = parallel ? "parallel: " : "serial: ";
+    CommandLog log;
+    Engine::Scene scene;
+    scene.SetJobSystem(&jobs);
+    scene.SetParallelUpdate(parallel);
+    std::vector<Engine::RigidBodyHandle> bodies;
+    for (int id = 0; id < count; ++id) {
+      auto object = std::make_shared<LoggingObject>(id, log);
+      scene.AddGameObject(object);
+      Engine::RigidBodyDesc desc;
+      desc.position = Vector3(id * 2.0f, 0.0f, 0.0f);
+      desc.collider = Engine::Collider::Sphere(0.5f);
+      bodies.push_back(scene.AddRigidBody(*object, desc));
+    }
+
+    for (int frame = 0; frame < 2; ++frame) {
+      log.frames.emplace_back();
+      scene.Update();
+    }
+    Check(log.frames.size() == 2 && log.frames[0] == firstFrame, test,
+          mode + "first frame's writes out of object order");
+    Check(log.frames.size() == 2 && log.frames[1] == secondFrame, test,
+          mode + "second frame does not drop the destroyed objects and "
+                 "append the spawned ones in order");
+    Check(log.initialized == static_cast<int>(spawned.size()), test,
+          mode + "spawned objects not initialized exactly once");
+    bool bodiesMatch = true;
+    for (int id = 0; id < count; ++id) {
+      bodiesMatch &=
+          scene.GetPhysicsWorld().IsAlive(bodies[id]) == (id % 40 != 3);
+    }
+    Check(bodiesMatch, test, mode + "destroyed objects kept their bodies");
+    scene.Exit();
+  }
+  jobs.Stop();
+}
+
+struct Test {
+  const char* name;
+  void (*run)();
+};
+
+const Test tests[] = {
+    {"broadphase pairs", TestBroadphases},
+    {"gjk distance", TestGjkDistance},
+    {"epa depth", TestEpaDepth},
+    {"pair set", TestPairSet},
+    {"contact cache", TestContactCache},
+    {"solver determinism", TestSolverDeterminism},
+    {"continuous collision", TestContinuousCollision},
+    {"scene commands", TestSceneCommands},
+};
+}  // namespace
+
+int main() {
+  int failedTests = 0;
+  for (const Test& test : tests) {
+    const int before = failures;
+    test.run();
+    const bool passed = failures == before;
+    failedTests += passed ? 0 : 1;
+    std::printf("%-22s %s\n", test.name, passed ? "ok" : "FAILED");
+  }
+  std::printf("\n%d of %zu tests failed\n", failedTests,
+              sizeof(tests) / sizeof(tests[0]));
+  return failedTests == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,102 @@
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+#include "Benchmark.hpp"
+#include "CpuFeatures.hpp"
+#include "MathBenchmarks.hpp"
+
+namespace {
+void PrintUsage() {
+  std::fprintf(stderr,
+               "usage: math_bench [--format=table|csv|json] [--filter=TEXT]\n"
+               "                  [--min-time=SECONDS] [--samples=N]\n"
+               "                  [--count=N] [--output=FILE]\n"
+               "                  [--simd=scalar|sse2|sse4.2|avx|avx2|"
+               "avx512]\n");
+}
+
+bool StartsWith(const std::string& text, const std::string& prefix) {
+  return text.compare(0, prefix.size(), prefix) == 0;
+}
+}  // namespace
+
+int main(int argc, char** argv) {
+  Bench::Options options;
+  size_t count = 4096;
+  std::string output;
+
+  for (int i = 1; i < argc; ++i) {
+    const std::string arg = argv[i];
+    if (StartsWith(arg, "--format=")) {
+      const std::string format = arg.substr(9);
+      if (format == "table") {
+        options.format = Bench::Format::TABLE;
+      } else if (format == "csv") {
+        options.format = Bench::Format::CSV;
+      } else if (format == "json") {
+        options.format = Bench::Format::JSON;
+      } else {
+        PrintUsage();
+        return EXIT_FAILURE;
+      }
+    } else if (StartsWith(arg, "--filter=")) {
+      options.filter = arg.substr(9);
+    } else if (StartsWith(arg, "--min-time=")) {
+      options.minSeconds = std::atof(arg.c_str() + 11);
+    } else if (StartsWith(arg, "--samples=")) {
+      options.samples = std::atoi(arg.c_str() + 10);
+    } else if (StartsWith(arg, "--count=")) {
+      count = std::strtoul(arg.c_str() + 8, nullptr, 10);
+    } else if (StartsWith(arg, "--simd=")) {
+      math::SimdTier tier;
+      if (!math::ParseSimdTier(arg.c_str() + 7, tier)) {
+        PrintUsage();
+        return EXIT_FAILURE;
+      }
+      math::SetSimdTier(tier);
+    } else if (StartsWith(arg, "--output=")) {
+      output = arg.substr(9);
+    } else {
+      PrintUsage();
+      return EXIT_FAILURE;
+    }
+  }
+  if (count == 0 || options.samples <= 0 || options.minSeconds <= 0.0) {
+    PrintUsage();
+    return EXIT_FAILURE;
+  }
+
+  if (options.format == Bench::Format::TABLE) {
+    std::printf("math_bench: %zu elements per call, simd tier: %s\n\n", count,
+                math::SimdTierName(math::GetSimdTier()));
+  }
+
+  Bench::Runner runner(options);
+  Bench::RunMatrixBenchmarks(runner, count);
+  Bench::RunAffineBenchmarks(runner, count);
+  Bench::RunQuaternionBenchmarks(runner, count);
+  Bench::RunVectorBenchmarks(runner, count);
+  Bench::RunBatchBenchmarks(runner, count);
+  Bench::RunDispatchBenchmarks(runner, count);
+  Bench::RunWorkloadBenchmarks(runner, count);
+
+  if (output.empty()) {
+    runner.Write(std::cout);
+  } else {
+    std::ofstream file(output);
+    if (!file) {
+      std::fprintf(stderr, "math_bench: cannot open %s\n", output.c_str());
+      return EXIT_FAILURE;
+    }
+    runner.Write(file);
+  }
+  if (const size_t failures = runner.GetFailureCount()) {
+    std::fprintf(stderr, "math_bench: %zu accuracy check(s) failed\n",
+                 failures);
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
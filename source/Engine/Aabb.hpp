@@ -0,0 +1,91 @@
+#pragma once
+
+#include <Vector3.hpp>
+#include <algorithm>
+#include <cmath>
+
+namespace math {
+// Axis-aligned bounding box. Boxes touching on a face count as overlapping.
+struct Aabb {
+  Vector3 min;
+  Vector3 max;
+
+  Vector3 Center() const {
+    return Vector3((min.x + max.x) * 0.5f, (min.y + max.y) * 0.5f,
+                   (min.z + max.z) * 0.5f);
+  }
+  // Half size along each axis.
+  Vector3 Extents() const {
+    return Vector3((max.x - min.x) * 0.5f, (max.y - min.y) * 0.5f,
+                   (max.z - min.z) * 0.5f);
+  }
+  float SurfaceArea() const {
+    const float dx = max.x - min.x;
+    const float dy = max.y - min.y;
+    const float dz = max.z - min.z;
+    return 2.0f * (dx * dy + dy * dz + dz * dx);
+  }
+
+  bool Overlaps(const Aabb& other) const {
+    return min.x <= other.max.x && max.x >= other.min.x &&
+           min.y <= other.max.y && max.y >= other.min.y &&
+           min.z <= other.max.z && max.z >= other.min.z;
+  }
+  bool Contains(const Aabb& other) const {
+    return min.x <= other.min.x && min.y <= other.min.y &&
+           min.z <= other.min.z && max.x >= other.max.x &&
+           max.y >= other.max.y && max.z >= other.max.z;
+  }
+
+  // Slab test for the ray origin + t * direction, 0 <= t <= maxDistance,
+  // taking the reciprocal of the direction so one ray can be tested
+  // against many boxes. On a hit, `distance` is the entry t (0 if the
+  // origin is inside).
+  bool IntersectsRay(const Vector3& origin, const Vector3& inverseDirection,
+                     float maxDistance, float& distance) const {
+    const float tx1 = (min.x - origin.x) * inverseDirection.x;
+    const float tx2 = (max.x - origin.x) * inverseDirection.x;
+    const float ty1 = (min.y - origin.y) * inverseDirection.y;
+    const float ty2 = (max.y - origin.y) * inverseDirection.y;
+    const float tz1 = (min.z - origin.z) * inverseDirection.z;
+    const float tz2 = (max.z - origin.z) * inverseDirection.z;
+    // Axes the ray is parallel to give infinite slab distances. A ray that
+    // runs exactly along a face may count either way.
+    const float enter =
+        std::fmax(std::fmax(std::fmax(std::fmin(tx1, tx2), std::fmin(ty1, ty2)),
+                            std::fmin(tz1, tz2)),
+                  0.0f);
+    const float exit =
+        std::fmin(std::fmin(std::fmin(std::fmax(tx1, tx2), std::fmax(ty1, ty2)),
+                            std::fmax(tz1, tz2)),
+                  maxDistance);
+    if (enter > exit) return false;
+    distance = enter;
+    return true;
+  }
+
+  // Grown by `margin` on every side.
+  Aabb Fattened(float margin) const {
+    return {Vector3(min.x - margin, min.y - margin, min.z - margin),
+            Vector3(max.x + margin, max.y + margin, max.z + margin)};
+  }
+
+  static Aabb Merge(const Aabb& a, const Aabb& b) {
+    return {Vector3(std::min(a.min.x, b.min.x), std::min(a.min.y, b.min.y),
+                    std::min(a.min.z, b.min.z)),
+            Vector3(std::max(a.max.x, b.max.x), std::max(a.max.y, b.max.y),
+                    std::max(a.max.z, b.max.z))};
+  }
+};
+
+// Many boxes in structure-of-arrays form, one stream per bound component,
+// as consumed by OverlapAabbs.
+struct AabbStreams {
+  const float* minX;
+  const float* minY;
+  const float* minZ;
+  const float* maxX;
+  const float* maxY;
+  const float* maxZ;
+};
+}  // namespace math
@@ -0,0 +1,112 @@
+#include "Affine3x4.hpp"
+
+#include <cmath>
+
+// Compile-time checks for the constexpr subset; powers of two keep every
+// product exact.
+namespace {
+constexpr math::Affine3x4 scale =
+    math::Affine3x4::CreateScale(2.0f, 4.0f, 8.0f);
+constexpr math::Affine3x4 translation =
+    math::Affine3x4::CreateTranslation(1.0f, 2.0f, 3.0f);
+constexpr math::Affine3x4 scaleThenTranslate = scale * translation;
+static_assert(scaleThenTranslate.element[1][1] == 4.0f &&
+                  scaleThenTranslate.element[1][3] == 2.0f,
+              "scale then translate keeps the translation unscaled");
+constexpr math::Affine3x4 translateThenScale = translation * scale;
+static_assert(translateThenScale.element[2][3] == 24.0f,
+              "translate then scale scales the translation");
+constexpr math::Affine3x4 roundTrip =
+    scaleThenTranslate * scaleThenTranslate.Inverse();
+static_assert(roundTrip.element[0][0] == 1.0f &&
+                  roundTrip.element[2][2] == 1.0f &&
+                  roundTrip.element[0][3] == 0.0f &&
+                  roundTrip.element[2][3] == 0.0f,
+              "a * inverse(a) is the identity");
+// Quarter turn about y followed by a translation; every entry is exact.
+constexpr math::Affine3x4 quarterTurn = [] {
+  math::Affine3x4 a = math::Affine3x4::CreateTranslation(1.0f, 2.0f, 3.0f);
+  a.element[0][0] = 0.0f;
+  a.element[0][2] = 1.0f;
+  a.element[2][0] = -1.0f;
+  a.element[2][2] = 0.0f;
+  return a;
+}();
+constexpr math::Affine3x4 rigidRoundTrip =
+    quarterTurn * quarterTurn.InverseRigid();
+static_assert(rigidRoundTrip.element[0][0] == 1.0f &&
+                  rigidRoundTrip.element[0][2] == 0.0f &&
+                  rigidRoundTrip.element[0][3] == 0.0f &&
+                  rigidRoundTrip.element[2][3] == 0.0f,
+              "a * inverseRigid(a) is the identity for rigid a");
+}  // namespace
+
+math::Affine3x4 math::Affine3x4::CreateScale(const Vector3& scale) {
+  return CreateScale(scale.x, scale.y, scale.z);
+}
+
+math::Affine3x4 math::Affine3x4::CreateRotationYaw(float angle) {
+  const float c = std::cos(angle);
+  const float s = std::sin(angle);
+  Affine3x4 a;
+  a.element[0][0] = c;
+  a.element[0][2] = s;
+  a.element[2][0] = -s;
+  a.element[2][2] = c;
+  return a;
+}
+
+math::Affine3x4 math::Affine3x4::CreateTranslation(const Vector3& translation) {
+  return CreateTranslation(translation.x, translation.y, translation.z);
+}
+
+math::Affine3x4 math::Affine3x4::FromMatrix4x4(const Matrix4x4& m) {
+  Affine3x4 a;
+  for (int r = 0; r < 3; ++r) {
+    for (int c = 0; c < 4; ++c) a.element[r][c] = m.element[c][r];
+  }
+  return a;
+}
+
+math::Matrix4x4 math::Affine3x4::ToMatrix4x4() const {
+  Matrix4x4 m = Matrix4x4::CreateIdentityMatrix();
+  for (int r = 0; r < 3; ++r) {
+    for (int c = 0; c < 4; ++c) m.element[c][r] = element[r][c];
+  }
+  return m;
+}
+
+math::Matrix4x4 math::Affine3x4::operator*(const Matrix4x4& rhs) const {
+  // Row i of the 4x4 form is column i of `element` followed by 0 (or 1 for
+  // the translation row), so the last row of rhs only enters once.
+  Matrix4x4 out;
+  for (int i = 0; i < 4; ++i) {
+    for (int j = 0; j < 4; ++j) {
+      out.element[i][j] = element[0][i] * rhs.element[0][j] +
+                          element[1][i] * rhs.element[1][j] +
+                          element[2][i] * rhs.element[2][j];
+    }
+  }
+  for (int j = 0; j < 4; ++j) out.element[3][j] += rhs.element[3][j];
+  return out;
+}
+
+math::Vector3 math::Affine3x4::TransformPoint(const Vector3& p) const {
+  return Vector3(element[0][0] * p.x + element[0][1] * p.y +
+                     element[0][2] * p.z + element[0][3],
+                 element[1][0] * p.x + element[1][1] * p.y +
+                     element[1][2] * p.z + element[1][3],
+                 element[2][0] * p.x + element[2][1] * p.y +
+                     element[2][2] * p.z + element[2][3]);
+}
+
+math::Vector3 math::Affine3x4::TransformDirection(const Vector3& d) const {
+  return Vector3(
+      element[0][0] * d.x + element[0][1] * d.y + element[0][2] * d.z,
+      element[1][0] * d.x + element[1][1] * d.y + element[1][2] * d.z,
+      element[2][0] * d.x + element[2][1] * d.y + element[2][2] * d.z);
+}
+
+math::Vector3 math::Affine3x4::GetTranslation() const {
+  return Vector3(element[0][3], element[1][3], element[2][3]);
+}
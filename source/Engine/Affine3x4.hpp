@@ -0,0 +1,113 @@
+#pragma once
+
+#include <Matrix4x4.hpp>
+#include <Vector3.hpp>
+
+namespace math {
+// Affine transform stored as the three meaningful columns of a row-vector
+// Matrix4x4: element[r] holds column r, so
+//   out[r] = element[r][0] * x + element[r][1] * y + element[r][2] * z
+//            + element[r][3]
+// The implicit fourth column of the 4x4 form is always (0, 0, 0, 1).
+// Composition follows Matrix4x4: (a * b) applies a first, then b.
+// Everything that does not need trigonometry or Vector3 is constexpr, so
+// constant transforms can be folded at compile time.
+class Affine3x4 {
+ public:
+  float element[3][4];
+
+  constexpr Affine3x4()
+      : element{{1.0f, 0.0f, 0.0f, 0.0f},
+                {0.0f, 1.0f, 0.0f, 0.0f},
+                {0.0f, 0.0f, 1.0f, 0.0f}} {}
+
+  static constexpr Affine3x4 CreateIdentity() { return Affine3x4(); }
+  static constexpr Affine3x4 CreateScale(float x, float y, float z) {
+    Affine3x4 a;
+    a.element[0][0] = x;
+    a.element[1][1] = y;
+    a.element[2][2] = z;
+    return a;
+  }
+  static Affine3x4 CreateScale(const Vector3& scale);
+  // Rotation about the y axis, same layout as
+  // Matrix4x4::CreateRotationYawMatrix.
+  static Affine3x4 CreateRotationYaw(float angle);
+  static constexpr Affine3x4 CreateTranslation(float x, float y, float z) {
+    Affine3x4 a;
+    a.element[0][3] = x;
+    a.element[1][3] = y;
+    a.element[2][3] = z;
+    return a;
+  }
+  static Affine3x4 CreateTranslation(const Vector3& translation);
+  // Drops the projective column of `m`; only meaningful for affine matrices.
+  static Affine3x4 FromMatrix4x4(const Matrix4x4& m);
+
+  Matrix4x4 ToMatrix4x4() const;
+
+  constexpr Affine3x4 operator*(const Affine3x4& rhs) const {
+    // Column form: result = rhs o this, i.e. L = rhs.L * L and
+    // t = rhs.L * t + rhs.t.
+    Affine3x4 out;
+    for (int r = 0; r < 3; ++r) {
+      const float* b = rhs.element[r];
+      for (int c = 0; c < 4; ++c) {
+        out.element[r][c] = b[0] * element[0][c] + b[1] * element[1][c] +
+                            b[2] * element[2][c];
+      }
+      out.element[r][3] += b[3];
+    }
+    return out;
+  }
+  // Applies this transform, then `rhs` (typically a projection), without
+  // expanding this transform to a full 4x4 matrix first.
+  Matrix4x4 operator*(const Matrix4x4& rhs) const;
+
+  // Inverse of a rotation + translation (orthonormal linear part, no scale):
+  // transpose the rotation and rotate the negated translation.
+  constexpr Affine3x4 InverseRigid() const {
+    Affine3x4 out;
+    for (int r = 0; r < 3; ++r) {
+      for (int c = 0; c < 3; ++c) out.element[r][c] = element[c][r];
+      out.element[r][3] =
+          -(element[0][r] * element[0][3] + element[1][r] * element[1][3] +
+            element[2][r] * element[2][3]);
+    }
+    return out;
+  }
+
+  // General affine inverse. The linear part must not be singular.
+  constexpr Affine3x4 Inverse() const {
+    const float(&m)[3][4] = element;
+    // Cofactors of the linear part.
+    const float c00 = m[1][1] * m[2][2] - m[1][2] * m[2][1];
+    const float c01 = m[1][2] * m[2][0] - m[1][0] * m[2][2];
+    const float c02 = m[1][0] * m[2][1] - m[1][1] * m[2][0];
+    const float invDet =
+        1.0f / (m[0][0] * c00 + m[0][1] * c01 + m[0][2] * c02);
+
+    Affine3x4 out;
+    out.element[0][0] = c00 * invDet;
+    out.element[1][0] = c01 * invDet;
+    out.element[2][0] = c02 * invDet;
+    out.element[0][1] = (m[0][2] * m[2][1] - m[0][1] * m[2][2]) * invDet;
+    out.element[1][1] = (m[0][0] * m[2][2] - m[0][2] * m[2][0]) * invDet;
+    out.element[2][1] = (m[0][1] * m[2][0] - m[0][0] * m[2][1]) * invDet;
+    out.element[0][2] = (m[0][1] * m[1][2] - m[0][2] * m[1][1]) * invDet;
+    out.element[1][2] = (m[0][2] * m[1][0] - m[0][0] * m[1][2]) * invDet;
+    out.element[2][2] = (m[0][0] * m[1][1] - m[0][1] * m[1][0]) * invDet;
+    for (int r = 0; r < 3; ++r) {
+      out.element[r][3] =
+          -(out.element[r][0] * m[0][3] + out.element[r][1] * m[1][3] +
+            out.element[r][2] * m[2][3]);
+    }
+    return out;
+  }
+
+  Vector3 TransformPoint(const Vector3& p) const;
+  // Ignores translation.
+  Vector3 TransformDirection(const Vector3& d) const;
+  Vector3 GetTranslation() const;
+};
+}  // namespace math
@@ -0,0 +1,260 @@
+#include "BatchKernels.hpp"
+
+#include "CpuFeatures.hpp"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || \
+    defined(_M_IX86)
+#define BATCH_KERNELS_X86 1
+#include <immintrin.h>
+#endif
+
+#if defined(BATCH_KERNELS_X86) && (defined(__GNUC__) || defined(__clang__))
+#define BATCH_TARGET_SSE2 __attribute__((target("sse2")))
+#define BATCH_TARGET_AVX __attribute__((target("avx")))
+#define BATCH_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#define BATCH_TARGET_AVX512 __attribute__((target("avx512f")))
+#else
+#define BATCH_TARGET_SSE2
+#define BATCH_TARGET_AVX
+#define BATCH_TARGET_AVX2
+#define BATCH_TARGET_AVX512
+#endif
+
+namespace {
+struct Kernels {
+  void (*mulAdd)(const float* a, const float* b, float s, float* out,
+                 size_t count);
+  size_t (*overlap)(const math::Aabb& query, const math::AabbStreams& boxes,
+                    size_t begin, size_t count, uint32_t* out);
+  const char* name;
+};
+
+void MulAddScalar(const float* a, const float* b, float s, float* out,
+                  size_t count) {
+  for (size_t i = 0; i < count; ++i) out[i] = a[i] + b[i] * s;
+}
+
+// Tests boxes [begin, count) one at a time; also the tail of the SIMD paths.
+size_t OverlapScalar(const math::Aabb& q, const math::AabbStreams& b,
+                     size_t begin, size_t count, uint32_t* out) {
+  size_t n = 0;
+  for (size_t i = begin; i < count; ++i) {
+    const bool overlaps = b.minX[i] <= q.max.x && b.maxX[i] >= q.min.x &&
+                          b.minY[i] <= q.max.y && b.maxY[i] >= q.min.y &&
+                          b.minZ[i] <= q.max.z && b.maxZ[i] >= q.min.z;
+    out[n] = static_cast<uint32_t>(i);
+    n += overlaps;
+  }
+  return n;
+}
+
+#ifdef BATCH_KERNELS_X86
+inline int LowestBit(unsigned bits) {
+#ifdef _MSC_VER
+  unsigned long index;
+  _BitScanForward(&index, bits);
+  return static_cast<int>(index);
+#else
+  return __builtin_ctz(bits);
+#endif
+}
+
+inline int PopCount(unsigned bits) {
+#ifdef _MSC_VER
+  return static_cast<int>(__popcnt(bits));
+#else
+  return __builtin_popcount(bits);
+#endif
+}
+
+// Appends base + (index of each set bit) to out.
+inline size_t EmitIndices(unsigned bits, size_t base, uint32_t* out) {
+  size_t n = 0;
+  while (bits != 0) {
+    out[n++] = static_cast<uint32_t>(base + LowestBit(bits));
+    bits &= bits - 1;
+  }
+  return n;
+}
+
+BATCH_TARGET_SSE2 void MulAddSSE(const float* a, const float* b, float s,
+                                 float* out, size_t count) {
+  const __m128 vs = _mm_set1_ps(s);
+  size_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    const __m128 product = _mm_mul_ps(_mm_loadu_ps(b + i), vs);
+    _mm_storeu_ps(out + i, _mm_add_ps(_mm_loadu_ps(a + i), product));
+  }
+  MulAddScalar(a + i, b + i, s, out + i, count - i);
+}
+
+BATCH_TARGET_SSE2 size_t OverlapSSE(const math::Aabb& q,
+                                    const math::AabbStreams& b, size_t begin,
+                                    size_t count, uint32_t* out) {
+  const __m128 qMinX = _mm_set1_ps(q.min.x);
+  const __m128 qMinY = _mm_set1_ps(q.min.y);
+  const __m128 qMinZ = _mm_set1_ps(q.min.z);
+  const __m128 qMaxX = _mm_set1_ps(q.max.x);
+  const __m128 qMaxY = _mm_set1_ps(q.max.y);
+  const __m128 qMaxZ = _mm_set1_ps(q.max.z);
+  size_t n = 0;
+  size_t i = begin;
+  for (; i + 4 <= count; i += 4) {
+    __m128 m = _mm_and_ps(_mm_cmple_ps(_mm_loadu_ps(b.minX + i), qMaxX),
+                          _mm_cmpge_ps(_mm_loadu_ps(b.maxX + i), qMinX));
+    m = _mm_and_ps(m, _mm_cmple_ps(_mm_loadu_ps(b.minY + i), qMaxY));
+    m = _mm_and_ps(m, _mm_cmpge_ps(_mm_loadu_ps(b.maxY + i), qMinY));
+    m = _mm_and_ps(m, _mm_cmple_ps(_mm_loadu_ps(b.minZ + i), qMaxZ));
+    m = _mm_and_ps(m, _mm_cmpge_ps(_mm_loadu_ps(b.maxZ + i), qMinZ));
+    n += EmitIndices(_mm_movemask_ps(m), i, out + n);
+  }
+  return n + OverlapScalar(q, b, i, count, out + n);
+}
+
+BATCH_TARGET_AVX void MulAddAVX(const float* a, const float* b, float s,
+                                float* out, size_t count) {
+  const __m256 vs = _mm256_set1_ps(s);
+  size_t i = 0;
+  for (; i + 8 <= count; i += 8) {
+    const __m256 product = _mm256_mul_ps(_mm256_loadu_ps(b + i), vs);
+    _mm256_storeu_ps(out + i, _mm256_add_ps(_mm256_loadu_ps(a + i), product));
+  }
+  MulAddScalar(a + i, b + i, s, out + i, count - i);
+}
+
+BATCH_TARGET_AVX inline __m256 LessEqualAVX(const float* v, __m256 bound) {
+  return _mm256_cmp_ps(_mm256_loadu_ps(v), bound, _CMP_LE_OQ);
+}
+
+BATCH_TARGET_AVX inline __m256 GreaterEqualAVX(const float* v, __m256 bound) {
+  return _mm256_cmp_ps(_mm256_loadu_ps(v), bound, _CMP_GE_OQ);
+}
+
+BATCH_TARGET_AVX size_t OverlapAVX(const math::Aabb& q,
+                                   const math::AabbStreams& b, size_t begin,
+                                   size_t count, uint32_t* out) {
+  const __m256 qMinX = _mm256_set1_ps(q.min.x);
+  const __m256 qMinY = _mm256_set1_ps(q.min.y);
+  const __m256 qMinZ = _mm256_set1_ps(q.min.z);
+  const __m256 qMaxX = _mm256_set1_ps(q.max.x);
+  const __m256 qMaxY = _mm256_set1_ps(q.max.y);
+  const __m256 qMaxZ = _mm256_set1_ps(q.max.z);
+  size_t n = 0;
+  size_t i = begin;
+  for (; i + 8 <= count; i += 8) {
+    __m256 m = _mm256_and_ps(LessEqualAVX(b.minX + i, qMaxX),
+                             GreaterEqualAVX(b.maxX + i, qMinX));
+    m = _mm256_and_ps(m, LessEqualAVX(b.minY + i, qMaxY));
+    m = _mm256_and_ps(m, GreaterEqualAVX(b.maxY + i, qMinY));
+    m = _mm256_and_ps(m, LessEqualAVX(b.minZ + i, qMaxZ));
+    m = _mm256_and_ps(m, GreaterEqualAVX(b.maxZ + i, qMinZ));
+    n += EmitIndices(_mm256_movemask_ps(m), i, out + n);
+  }
+  return n + OverlapScalar(q, b, i, count, out + n);
+}
+
+BATCH_TARGET_AVX2 void MulAddAVX2(const float* a, const float* b, float s,
+                                  float* out, size_t count) {
+  const __m256 vs = _mm256_set1_ps(s);
+  size_t i = 0;
+  for (; i + 8 <= count; i += 8) {
+    _mm256_storeu_ps(out + i, _mm256_fmadd_ps(_mm256_loadu_ps(b + i), vs,
+                                              _mm256_loadu_ps(a + i)));
+  }
+  MulAddScalar(a + i, b + i, s, out + i, count - i);
+}
+
+BATCH_TARGET_AVX512 void MulAddAVX512(const float* a, const float* b, float s,
+                                      float* out, size_t count) {
+  const __m512 vs = _mm512_set1_ps(s);
+  size_t i = 0;
+  for (; i + 16 <= count; i += 16) {
+    _mm512_storeu_ps(out + i, _mm512_fmadd_ps(_mm512_loadu_ps(b + i), vs,
+                                              _mm512_loadu_ps(a + i)));
+  }
+  // The tail uses a masked load/store instead of a scalar loop.
+  if (i < count) {
+    const __mmask16 tail = static_cast<__mmask16>((1u << (count - i)) - 1);
+    const __m512 va = _mm512_maskz_loadu_ps(tail, a + i);
+    const __m512 vb = _mm512_maskz_loadu_ps(tail, b + i);
+    _mm512_mask_storeu_ps(out + i, tail, _mm512_fmadd_ps(vb, vs, va));
+  }
+}
+
+BATCH_TARGET_AVX512 size_t OverlapAVX512(const math::Aabb& q,
+                                         const math::AabbStreams& b,
+                                         size_t begin, size_t count,
+                                         uint32_t* out) {
+  const __m512 qMinX = _mm512_set1_ps(q.min.x);
+  const __m512 qMinY = _mm512_set1_ps(q.min.y);
+  const __m512 qMinZ = _mm512_set1_ps(q.min.z);
+  const __m512 qMaxX = _mm512_set1_ps(q.max.x);
+  const __m512 qMaxY = _mm512_set1_ps(q.max.y);
+  const __m512 qMaxZ = _mm512_set1_ps(q.max.z);
+  const __m512i lanes = _mm512_set_epi32(15, 14, 13, 12, 11, 10, 9, 8, 7, 6,
+                                         5, 4, 3, 2, 1, 0);
+  size_t n = 0;
+  size_t i = begin;
+  for (; i + 16 <= count; i += 16) {
+    __mmask16 m =
+        _mm512_cmp_ps_mask(_mm512_loadu_ps(b.minX + i), qMaxX, _CMP_LE_OQ);
+    m = _mm512_mask_cmp_ps_mask(m, _mm512_loadu_ps(b.maxX + i), qMinX,
+                                _CMP_GE_OQ);
+    m = _mm512_mask_cmp_ps_mask(m, _mm512_loadu_ps(b.minY + i), qMaxY,
+                                _CMP_LE_OQ);
+    m = _mm512_mask_cmp_ps_mask(m, _mm512_loadu_ps(b.maxY + i), qMinY,
+                                _CMP_GE_OQ);
+    m = _mm512_mask_cmp_ps_mask(m, _mm512_loadu_ps(b.minZ + i), qMaxZ,
+                                _CMP_LE_OQ);
+    m = _mm512_mask_cmp_ps_mask(m, _mm512_loadu_ps(b.maxZ + i), qMinZ,
+                                _CMP_GE_OQ);
+    // Pack the indices of the overlapping lanes without branching.
+    const __m512i indices =
+        _mm512_add_epi32(_mm512_set1_epi32(static_cast<int>(i)), lanes);
+    _mm512_mask_compressstoreu_epi32(out + n, m, indices);
+    n += PopCount(m);
+  }
+  return n + OverlapScalar(q, b, i, count, out + n);
+}
+#endif
+
+Kernels SelectKernels(math::SimdTier tier) {
+#ifdef BATCH_KERNELS_X86
+  switch (tier) {
+    case math::SimdTier::AVX512:
+      return {MulAddAVX512, OverlapAVX512, "avx512"};
+    case math::SimdTier::AVX2:
+      return {MulAddAVX2, OverlapAVX, "avx2"};
+    case math::SimdTier::AVX:
+      return {MulAddAVX, OverlapAVX, "avx"};
+    case math::SimdTier::SSE42:
+    case math::SimdTier::SSE2:
+      return {MulAddSSE, OverlapSSE, "sse"};
+    case math::SimdTier::SCALAR:
+      break;
+  }
+#endif
+  return {MulAddScalar, OverlapScalar, "scalar"};
+}
+
+Kernels& GetKernels() {
+  static Kernels kernels = SelectKernels(math::GetSimdTier());
+  return kernels;
+}
+}  // namespace
+
+void math::detail::BindBatchKernels(SimdTier tier) {
+  GetKernels() = SelectKernels(tier);
+}
+
+void math::MulAddStream(const float* a, const float* b, float s, float* out,
+                        size_t count) {
+  GetKernels().mulAdd(a, b, s, out, count);
+}
+
+size_t math::OverlapAabbs(const Aabb& query, const AabbStreams& boxes,
+                          size_t count, uint32_t* out) {
+  return GetKernels().overlap(query, boxes, 0, count, out);
+}
+
+const char* math::BatchKernelName() { return GetKernels().name; }
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <Aabb.hpp>
+#include <cstddef>
+#include <cstdint>
+
+// Streaming kernels over structure-of-arrays data, the inner loops of
+// integration and broadphase. Like MatrixKernels they are dispatched at
+// runtime (see CpuFeatures.hpp) up to AVX-512.
+namespace math {
+// out[i] = a[i] + b[i] * s. out may alias a or b. With the AVX2 tier and
+// up the multiply-add is fused, so results may differ in the last bit.
+void MulAddStream(const float* a, const float* b, float s, float* out,
+                  size_t count);
+
+// Writes the indices of the boxes overlapping `query` to `out`, in
+// increasing order, and returns how many were written. out must have room
+// for `count` indices.
+size_t OverlapAabbs(const Aabb& query, const AabbStreams& boxes, size_t count,
+                    uint32_t* out);
+
+// Name of the implementation in use ("avx512", "avx2", "avx", "sse" or
+// "scalar").
+const char* BatchKernelName();
+}  // namespace math
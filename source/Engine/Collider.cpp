@@ -0,0 +1,54 @@
+#include "Collider.hpp"
+
+Engine::Collider Engine::Collider::Sphere(float radius) {
+  Collider c;
+  c.type = ShapeType::SPHERE;
+  c.radius = radius;
+  return c;
+}
+
+Engine::Collider Engine::Collider::Capsule(float radius, float halfHeight) {
+  Collider c;
+  c.type = ShapeType::CAPSULE;
+  c.radius = radius;
+  c.halfHeight = halfHeight;
+  return c;
+}
+
+Engine::Collider Engine::Collider::Box(const math::Vector3& halfExtents) {
+  Collider c;
+  c.type = ShapeType::BOX;
+  c.halfExtents = halfExtents;
+  return c;
+}
+
+Engine::Collider Engine::Collider::Convex(const ConvexHull& hull) {
+  if (hull.Size() == 0) return Sphere(0.0f);
+  Collider c;
+  c.type = ShapeType::CONVEX;
+  c.hull = hull;
+  return c;
+}
+
+math::Aabb Engine::Collider::LocalBounds() const {
+  switch (type) {
+    case ShapeType::SPHERE:
+      return {math::Vector3(-radius, -radius, -radius),
+              math::Vector3(radius, radius, radius)};
+    case ShapeType::CAPSULE: {
+      const float y = halfHeight + radius;
+      return {math::Vector3(-radius, -y, -radius),
+              math::Vector3(radius, y, radius)};
+    }
+    case ShapeType::BOX:
+      return {halfExtents * -1.0f, halfExtents};
+    case ShapeType::CONVEX:
+      break;
+  }
+  if (hull.Size() == 0)
+    return {math::Vector3(0.0f, 0.0f, 0.0f), math::Vector3(0.0f, 0.0f, 0.0f)};
+  math::Aabb box = {hull.Point(0), hull.Point(0)};
+  for (size_t i = 1; i < hull.Size(); ++i)
+    box = math::Aabb::Merge(box, {hull.Point(i), hull.Point(i)});
+  return box;
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <Aabb.hpp>
+#include <ConvexHull.hpp>
+#include <Vector3.hpp>
+
+namespace Engine {
+enum class ShapeType { SPHERE, CAPSULE, BOX, CONVEX };
+constexpr int shapeTypeCount = 4;
+
+// Collision shape of a body, in body space and centered on the body's
+// origin. Plain data: the shape type picks the collision kernel through a
+// table, not through virtual calls.
+struct Collider {
+  ShapeType type = ShapeType::BOX;
+  // SPHERE and CAPSULE.
+  float radius = 0.0f;
+  // CAPSULE: half the length of the core segment, which runs along y.
+  float halfHeight = 0.0f;
+  // BOX.
+  math::Vector3 halfExtents = math::Vector3(0.5f, 0.5f, 0.5f);
+  // CONVEX. The points are not owned, see ConvexHull.
+  ConvexHull hull;
+  // Surface material. A pair uses the geometric mean of the frictions and
+  // the larger restitution.
+  float friction = 0.5f;
+  float restitution = 0.0f;
+
+  static Collider Sphere(float radius);
+  static Collider Capsule(float radius, float halfHeight);
+  static Collider Box(const math::Vector3& halfExtents);
+  // An empty hull, such as that of a mesh without vertices, has no
+  // support point; it becomes a point, a sphere of radius 0.
+  static Collider Convex(const ConvexHull& hull);
+
+  math::Aabb LocalBounds() const;
+};
+}  // namespace Engine
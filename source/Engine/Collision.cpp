@@ -0,0 +1,806 @@
+#include "Collision.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+using Engine::Collider;
+using Engine::ContactManifold;
+using Engine::ContactPoint;
+using Engine::GjkCache;
+using Engine::Pose;
+using math::Vector3;
+
+using CollideFunction = bool (*)(const Collider&, const Pose&,
+                                 const Collider&, const Pose&, GjkCache*,
+                                 ContactManifold&);
+
+constexpr float epsilon = 1e-6f;
+// How far apart face contact points may be and still be reported.
+constexpr float speculativeDepth = 0.02f;
+// Distance at which a ray cast against a hull counts as a hit, and the
+// most GJK queries it may take to get there.
+constexpr float rayTolerance = 1e-4f;
+constexpr int maxRayIterations = 32;
+
+const Vector3 unitAxes[3] = {Vector3(1.0f, 0.0f, 0.0f),
+                             Vector3(0.0f, 1.0f, 0.0f),
+                             Vector3(0.0f, 0.0f, 1.0f)};
+
+float Length(const Vector3& v) { return std::sqrt(math::Dot(v, v)); }
+
+float Clamp01(float value) { return std::min(1.0f, std::max(0.0f, value)); }
+
+void AddPoint(ContactManifold& m, const Vector3& surfaceA,
+              const Vector3& surfaceB, float depth, uint32_t id) {
+  ContactPoint& p = m.points[m.pointCount++];
+  p.position = (surfaceA + surfaceB) * 0.5f;
+  p.depth = depth;
+  p.id = id;
+}
+
+// Spheres, and the closest points of capsule cores. On contact, `normal`
+// points from a to b and surfaceA/surfaceB are the deepest points.
+bool CollideSpheres(const Vector3& centerA, float radiusA,
+                    const Vector3& centerB, float radiusB, Vector3& normal,
+                    float& depth, Vector3& surfaceA, Vector3& surfaceB) {
+  const Vector3 offset = centerB - centerA;
+  const float radii = radiusA + radiusB;
+  const float distanceSquared = math::Dot(offset, offset);
+  if (distanceSquared > radii * radii) return false;
+  const float distance = std::sqrt(distanceSquared);
+  normal = distance > epsilon ? offset * (1.0f / distance)
+                              : Vector3(0.0f, 1.0f, 0.0f);
+  depth = radii - distance;
+  surfaceA = math::MulAdd(centerA, normal, radiusA);
+  surfaceB = math::MulAdd(centerB, normal, -radiusB);
+  return true;
+}
+
+void CapsuleSegment(const Collider& c, const Pose& pose, Vector3& p0,
+                    Vector3& p1) {
+  const Vector3 axis =
+      pose.orientation.Rotate(Vector3(0.0f, c.halfHeight, 0.0f));
+  p0 = pose.position - axis;
+  p1 = pose.position + axis;
+}
+
+Vector3 ClosestPointOnSegment(const Vector3& p, const Vector3& a,
+                              const Vector3& b) {
+  const Vector3 ab = b - a;
+  const float lengthSquared = math::Dot(ab, ab);
+  if (lengthSquared <= epsilon) return a;
+  return math::MulAdd(a, ab, Clamp01(math::Dot(p - a, ab) / lengthSquared));
+}
+
+// Closest points of segments p1q1 and p2q2, after Ericson, Real-Time
+// Collision Detection 5.1.9.
+void ClosestSegmentPoints(const Vector3& p1, const Vector3& q1,
+                          const Vector3& p2, const Vector3& q2, Vector3& c1,
+                          Vector3& c2) {
+  const Vector3 d1 = q1 - p1;
+  const Vector3 d2 = q2 - p2;
+  const Vector3 r = p1 - p2;
+  const float a = math::Dot(d1, d1);
+  const float e = math::Dot(d2, d2);
+  const float f = math::Dot(d2, r);
+  float s = 0.0f;
+  float t = 0.0f;
+  if (a <= epsilon && e <= epsilon) {
+    // Both degenerate to points.
+  } else if (a <= epsilon) {
+    t = Clamp01(f / e);
+  } else {
+    const float c = math::Dot(d1, r);
+    if (e <= epsilon) {
+      s = Clamp01(-c / a);
+    } else {
+      const float b = math::Dot(d1, d2);
+      const float denominator = a * e - b * b;
+      s = denominator != 0.0f ? Clamp01((b * f - c * e) / denominator) : 0.0f;
+      t = (b * s + f) / e;
+      if (t < 0.0f) {
+        t = 0.0f;
+        s = Clamp01(-c / a);
+      } else if (t > 1.0f) {
+        t = 1.0f;
+        s = Clamp01((b - c) / a);
+      }
+    }
+  }
+  c1 = math::MulAdd(p1, d1, s);
+  c2 = math::MulAdd(p2, d2, t);
+}
+
+struct Obb {
+  Vector3 center;
+  Vector3 axis[3];
+  float extent[3];
+};
+
+Obb MakeObb(const Collider& c, const Pose& pose) {
+  Obb box;
+  box.center = pose.position;
+  for (int i = 0; i < 3; ++i)
+    box.axis[i] = pose.orientation.Rotate(unitAxes[i]);
+  box.extent[0] = c.halfExtents.x;
+  box.extent[1] = c.halfExtents.y;
+  box.extent[2] = c.halfExtents.z;
+  return box;
+}
+
+bool SphereSphere(const Collider& a, const Pose& poseA, const Collider& b,
+                  const Pose& poseB, GjkCache*, ContactManifold& m) {
+  Vector3 surfaceA, surfaceB;
+  float depth;
+  if (!CollideSpheres(poseA.position, a.radius, poseB.position, b.radius,
+                      m.normal, depth, surfaceA, surfaceB))
+    return false;
+  AddPoint(m, surfaceA, surfaceB, depth, 0);
+  return true;
+}
+
+bool SphereCapsule(const Collider& a, const Pose& poseA, const Collider& b,
+                   const Pose& poseB, GjkCache*, ContactManifold& m) {
+  Vector3 p0, p1;
+  CapsuleSegment(b, poseB, p0, p1);
+  const Vector3 core = ClosestPointOnSegment(poseA.position, p0, p1);
+  Vector3 surfaceA, surfaceB;
+  float depth;
+  if (!CollideSpheres(poseA.position, a.radius, core, b.radius, m.normal,
+                      depth, surfaceA, surfaceB))
+    return false;
+  AddPoint(m, surfaceA, surfaceB, depth, 0);
+  return true;
+}
+
+bool SphereBox(const Collider& a, const Pose& poseA, const Collider& b,
+               const Pose& poseB, GjkCache*, ContactManifold& m) {
+  const Obb box = MakeObb(b, poseB);
+  const Vector3 center = poseA.position;
+  const Vector3 offset = center - box.center;
+  float local[3];
+  bool inside = true;
+  for (int i = 0; i < 3; ++i) {
+    local[i] = math::Dot(offset, box.axis[i]);
+    inside &= std::fabs(local[i]) <= box.extent[i];
+  }
+
+  if (!inside) {
+    Vector3 closest = box.center;
+    for (int i = 0; i < 3; ++i) {
+      const float clamped =
+          std::min(box.extent[i], std::max(-box.extent[i], local[i]));
+      closest = math::MulAdd(closest, box.axis[i], clamped);
+    }
+    const Vector3 toBox = closest - center;
+    const float distance = Length(toBox);
+    if (distance > a.radius) return false;
+    if (distance > epsilon) {
+      m.normal = toBox * (1.0f / distance);
+      AddPoint(m, math::MulAdd(center, m.normal, a.radius), closest,
+               a.radius - distance, 0);
+      return true;
+    }
+  }
+
+  // The center is inside (or on) the box: push out through the nearest
+  // face.
+  int face = 0;
+  float faceDistance = box.extent[0] - std::fabs(local[0]);
+  for (int i = 1; i < 3; ++i) {
+    const float d = box.extent[i] - std::fabs(local[i]);
+    if (d < faceDistance) {
+      faceDistance = d;
+      face = i;
+    }
+  }
+  const Vector3 outward = box.axis[face] * (local[face] >= 0.0f ? 1.0f : -1.0f);
+  m.normal = outward * -1.0f;
+  AddPoint(m, math::MulAdd(center, outward, -a.radius),
+           math::MulAdd(center, outward, faceDistance),
+           a.radius + faceDistance, 0);
+  return true;
+}
+
+bool CapsuleCapsule(const Collider& a, const Pose& poseA, const Collider& b,
+                    const Pose& poseB, GjkCache*, ContactManifold& m) {
+  Vector3 p1, q1, p2, q2;
+  CapsuleSegment(a, poseA, p1, q1);
+  CapsuleSegment(b, poseB, p2, q2);
+  Vector3 c1, c2, surfaceA, surfaceB;
+  float depth;
+  ClosestSegmentPoints(p1, q1, p2, q2, c1, c2);
+  if (!CollideSpheres(c1, a.radius, c2, b.radius, m.normal, depth, surfaceA,
+                      surfaceB))
+    return false;
+
+  // Capsules lying side by side touch along a line: report both ends of
+  // the overlap so they do not roll about a single point.
+  const Vector3 d1 = q1 - p1;
+  const Vector3 d2 = q2 - p2;
+  const float a2 = math::Dot(d1, d1);
+  const Vector3 cross = math::Cross(d1, d2);
+  if (a2 > epsilon &&
+      math::Dot(cross, cross) <= 1e-4f * a2 * math::Dot(d2, d2)) {
+    const float t0 = math::Dot(p2 - p1, d1) / a2;
+    const float t1 = math::Dot(q2 - p1, d1) / a2;
+    const float lo = Clamp01(std::min(t0, t1));
+    const float hi = Clamp01(std::max(t0, t1));
+    if (hi - lo > 1e-3f) {
+      const float ends[2] = {lo, hi};
+      for (int i = 0; i < 2; ++i) {
+        const Vector3 onA = math::MulAdd(p1, d1, ends[i]);
+        const Vector3 onB = ClosestPointOnSegment(onA, p2, q2);
+        const float separation = math::Dot(onB - onA, m.normal);
+        const float endDepth = a.radius + b.radius - separation;
+        if (endDepth < 0.0f) continue;
+        AddPoint(m, math::MulAdd(onA, m.normal, a.radius),
+                 math::MulAdd(onB, m.normal, -b.radius), endDepth,
+                 static_cast<uint32_t>(i + 1));
+      }
+      if (m.pointCount > 0) return true;
+    }
+  }
+  AddPoint(m, surfaceA, surfaceB, depth, 0);
+  return true;
+}
+
+// Any pair through GJK/EPA on the shapes' cores: the center of a sphere,
+// the segment of a capsule, the corners of a box or a hull. The radius of
+// a sphere or capsule is added back afterwards.
+int CorePoints(const Collider& c, Vector3* points) {
+  switch (c.type) {
+    case Engine::ShapeType::SPHERE:
+      points[0] = Vector3(0.0f, 0.0f, 0.0f);
+      return 1;
+    case Engine::ShapeType::CAPSULE:
+      points[0] = Vector3(0.0f, -c.halfHeight, 0.0f);
+      points[1] = Vector3(0.0f, c.halfHeight, 0.0f);
+      return 2;
+    case Engine::ShapeType::BOX:
+      for (int i = 0; i < 8; ++i) {
+        points[i] = Vector3(i & 1 ? c.halfExtents.x : -c.halfExtents.x,
+                            i & 2 ? c.halfExtents.y : -c.halfExtents.y,
+                            i & 4 ? c.halfExtents.z : -c.halfExtents.z);
+      }
+      return 8;
+    case Engine::ShapeType::CONVEX:
+      break;
+  }
+  return 0;
+}
+
+// Reports shapes up to `margin` apart as well, with a negative depth.
+bool CoreContact(const Collider& a, const Pose& poseA, const Collider& b,
+                 const Pose& poseB, float margin, GjkCache* cache,
+                 ContactManifold& m) {
+  Vector3 pointsA[8], pointsB[8];
+  const int countA = CorePoints(a, pointsA);
+  const int countB = CorePoints(b, pointsB);
+  const Engine::ConvexHull hullA =
+      countA > 0 ? Engine::ConvexHull(pointsA, countA) : a.hull;
+  const Engine::ConvexHull hullB =
+      countB > 0 ? Engine::ConvexHull(pointsB, countB) : b.hull;
+  const float radiusA = a.type == Engine::ShapeType::SPHERE ||
+                                a.type == Engine::ShapeType::CAPSULE
+                            ? a.radius
+                            : 0.0f;
+  const float radiusB = b.type == Engine::ShapeType::SPHERE ||
+                                b.type == Engine::ShapeType::CAPSULE
+                            ? b.radius
+                            : 0.0f;
+
+  const Engine::GjkResult result =
+      Engine::GjkDistance(hullA, poseA, hullB, poseB, cache);
+  Vector3 coreA, coreB;
+  float depth;
+  if (!result.overlap) {
+    if (result.distance > radiusA + radiusB + margin) return false;
+    m.normal = (result.pointB - result.pointA) * (1.0f / result.distance);
+    depth = radiusA + radiusB - result.distance;
+    coreA = result.pointA;
+    coreB = result.pointB;
+  } else {
+    Engine::ConvexContact contact;
+    if (!Engine::CollideConvex(hullA, poseA, hullB, poseB, cache, contact))
+      return false;
+    m.normal = contact.normal;
+    depth = contact.depth + radiusA + radiusB;
+    coreA = contact.pointA;
+    coreB = contact.pointB;
+  }
+  AddPoint(m, math::MulAdd(coreA, m.normal, radiusA),
+           math::MulAdd(coreB, m.normal, -radiusB), depth, 0);
+  return true;
+}
+
+bool ConvexCore(const Collider& a, const Pose& poseA, const Collider& b,
+                const Pose& poseB, GjkCache* cache, ContactManifold& m) {
+  return CoreContact(a, poseA, b, poseB, 0.0f, cache, m);
+}
+
+// A capsule parallel to a face has a whole segment of closest points, and
+// one point off its middle would spin it. Like CapsuleBox, each end cap
+// gets a point instead when both are within `margin` along one normal.
+bool CapsuleEnds(const Collider& a, const Pose& poseA, const Collider& b,
+                 const Pose& poseB, float margin, ContactManifold& m) {
+  Vector3 ends[2];
+  CapsuleSegment(a, poseA, ends[0], ends[1]);
+  const Collider cap = Collider::Sphere(a.radius);
+  ContactManifold capContacts[2];
+  for (int i = 0; i < 2; ++i) {
+    Pose capPose;
+    capPose.position = ends[i];
+    if (!CoreContact(cap, capPose, b, poseB, margin, nullptr,
+                     capContacts[i]))
+      return false;
+  }
+  if (math::Dot(capContacts[0].normal, capContacts[1].normal) <= 0.95f)
+    return false;
+  const Vector3 sum = capContacts[0].normal + capContacts[1].normal;
+  m.normal = sum * (1.0f / Length(sum));
+  for (int i = 0; i < 2; ++i) {
+    m.points[i] = capContacts[i].points[0];
+    m.points[i].id = static_cast<uint32_t>(i + 1);
+  }
+  m.pointCount = 2;
+  return true;
+}
+
+bool CapsuleBox(const Collider& a, const Pose& poseA, const Collider& b,
+                const Pose& poseB, GjkCache* cache, ContactManifold& m) {
+  // A capsule lying on a face touches it at both end caps.
+  Vector3 ends[2];
+  CapsuleSegment(a, poseA, ends[0], ends[1]);
+  const Collider cap = Collider::Sphere(a.radius);
+  ContactManifold capContacts[2];
+  bool touching = true;
+  for (int i = 0; i < 2 && touching; ++i) {
+    Pose capPose;
+    capPose.position = ends[i];
+    touching = SphereBox(cap, capPose, b, poseB, nullptr, capContacts[i]);
+  }
+  if (touching &&
+      math::Dot(capContacts[0].normal, capContacts[1].normal) > 0.95f) {
+    const Vector3 sum = capContacts[0].normal + capContacts[1].normal;
+    m.normal = sum * (1.0f / Length(sum));
+    for (int i = 0; i < 2; ++i) {
+      m.points[i] = capContacts[i].points[0];
+      m.points[i].id = static_cast<uint32_t>(i + 1);
+    }
+    m.pointCount = 2;
+    return true;
+  }
+  return ConvexCore(a, poseA, b, poseB, cache, m);
+}
+
+struct ClipVertex {
+  Vector3 position;
+  // 0-3 for the incident face's corners, 8 and up for points made by
+  // clipping, from the segment and the plane that made them.
+  uint32_t feature;
+  // What the segment to the next vertex lies on: 0-3 the incident face's
+  // edges, 4-7 the clipping planes.
+  uint32_t edge;
+};
+
+// Sutherland-Hodgman: keeps the part of the polygon with
+// dot(normal, p) <= offset.
+int ClipPolygon(const ClipVertex* in, int count, const Vector3& normal,
+                float offset, uint32_t plane, ClipVertex* out) {
+  int n = 0;
+  for (int i = 0; i < count; ++i) {
+    const ClipVertex& a = in[i];
+    const ClipVertex& b = in[(i + 1) % count];
+    const float da = math::Dot(normal, a.position) - offset;
+    const float db = math::Dot(normal, b.position) - offset;
+    if (da <= 0.0f) out[n++] = a;
+    if ((da <= 0.0f) != (db <= 0.0f)) {
+      // Leaving, the new segment runs along the plane; entering, it
+      // continues a's.
+      const float t = da / (da - db);
+      out[n++] = {math::MulAdd(a.position, b.position - a.position, t),
+                  8 + a.edge * 4 + plane, da <= 0.0f ? 4 + plane : a.edge};
+    }
+  }
+  return n;
+}
+
+// Picks four of `count` points that keep the deepest one and span the
+// largest area, so the contact patch keeps its extent.
+void ReducePoints(const ContactPoint* points, int count, const Vector3& normal,
+                  ContactManifold& m) {
+  if (count <= ContactManifold::maxPoints) {
+    for (int i = 0; i < count; ++i) m.points[i] = points[i];
+    m.pointCount = count;
+    return;
+  }
+  int chosen[4] = {0, 0, 0, 0};
+  for (int i = 1; i < count; ++i) {
+    if (points[i].depth > points[chosen[0]].depth) chosen[0] = i;
+  }
+  const Vector3 p0 = points[chosen[0]].position;
+  float best = -1.0f;
+  for (int i = 0; i < count; ++i) {
+    const float d = math::LengthSquared(points[i].position - p0);
+    if (d > best) {
+      best = d;
+      chosen[1] = i;
+    }
+  }
+  // The points furthest to either side of the first two.
+  const Vector3 edge = points[chosen[1]].position - p0;
+  float most = -INFINITY;
+  float least = INFINITY;
+  for (int i = 0; i < count; ++i) {
+    const float side =
+        math::Dot(math::Cross(edge, points[i].position - p0), normal);
+    if (side > most) {
+      most = side;
+      chosen[2] = i;
+    }
+    if (side < least) {
+      least = side;
+      chosen[3] = i;
+    }
+  }
+  m.pointCount = 0;
+  for (int i = 0; i < 4; ++i) {
+    bool duplicate = false;
+    for (int j = 0; j < i; ++j) duplicate |= chosen[j] == chosen[i];
+    if (!duplicate) m.points[m.pointCount++] = points[chosen[i]];
+  }
+}
+
+// Box-box by the separating axis test over the 15 candidate axes. A face
+// axis clips the other box's most anti-parallel face against the
+// reference face; an edge axis gives the single closest point of the two
+// edges.
+bool BoxBox(const Collider& a, const Pose& poseA, const Collider& b,
+            const Pose& poseB, GjkCache*, ContactManifold& m) {
+  const Obb boxes[2] = {MakeObb(a, poseA), MakeObb(b, poseB)};
+  const Obb& A = boxes[0];
+  const Obb& B = boxes[1];
+  const Vector3 t = B.center - A.center;
+
+  // Separation along an axis: negative while the boxes overlap on it.
+  auto separation = [&](const Vector3& axis) {
+    float ra = 0.0f;
+    float rb = 0.0f;
+    for (int k = 0; k < 3; ++k) {
+      ra += A.extent[k] * std::fabs(math::Dot(A.axis[k], axis));
+      rb += B.extent[k] * std::fabs(math::Dot(B.axis[k], axis));
+    }
+    return std::fabs(math::Dot(t, axis)) - (ra + rb);
+  };
+  // Face axes win unless another axis is clearly shallower, which keeps
+  // the chosen feature from flickering between steps.
+  auto clearlyBetter = [](float candidate, float current) {
+    return candidate > 0.95f * current + 0.005f;
+  };
+
+  int faceBox = 0;
+  int faceAxis = 0;
+  float faceSeparation = -INFINITY;
+  for (int box = 0; box < 2; ++box) {
+    for (int i = 0; i < 3; ++i) {
+      const float s = separation(boxes[box].axis[i]);
+      if (s > 0.0f) return false;
+      const bool better = box == 0 ? s > faceSeparation
+                                   : clearlyBetter(s, faceSeparation);
+      if (better) {
+        faceSeparation = s;
+        faceBox = box;
+        faceAxis = i;
+      }
+    }
+  }
+  int edgeA = -1;
+  int edgeB = -1;
+  float edgeSeparation = -INFINITY;
+  Vector3 edgeNormal;
+  for (int i = 0; i < 3; ++i) {
+    for (int j = 0; j < 3; ++j) {
+      Vector3 axis = math::Cross(A.axis[i], B.axis[j]);
+      const float length = Length(axis);
+      // Parallel edges: the face axes already cover this direction.
+      if (length < 1e-5f) continue;
+      axis = axis * (1.0f / length);
+      const float s = separation(axis);
+      if (s > 0.0f) return false;
+      if (s > edgeSeparation) {
+        edgeSeparation = s;
+        edgeA = i;
+        edgeB = j;
+        edgeNormal = axis;
+      }
+    }
+  }
+
+  if (edgeA >= 0 && clearlyBetter(edgeSeparation, faceSeparation)) {
+    // Normal from A to B, then the edge of each box nearest the other.
+    if (math::Dot(edgeNormal, t) < 0.0f) edgeNormal = edgeNormal * -1.0f;
+    Vector3 pointA = A.center;
+    Vector3 pointB = B.center;
+    for (int k = 0; k < 3; ++k) {
+      if (k != edgeA) {
+        const float sign = math::Dot(A.axis[k], edgeNormal) > 0.0f ? 1.0f
+                                                                    : -1.0f;
+        pointA = math::MulAdd(pointA, A.axis[k], sign * A.extent[k]);
+      }
+      if (k != edgeB) {
+        const float sign = math::Dot(B.axis[k], edgeNormal) > 0.0f ? -1.0f
+                                                                    : 1.0f;
+        pointB = math::MulAdd(pointB, B.axis[k], sign * B.extent[k]);
+      }
+    }
+    Vector3 closestA, closestB;
+    ClosestSegmentPoints(
+        math::MulAdd(pointA, A.axis[edgeA], -A.extent[edgeA]),
+        math::MulAdd(pointA, A.axis[edgeA], A.extent[edgeA]),
+        math::MulAdd(pointB, B.axis[edgeB], -B.extent[edgeB]),
+        math::MulAdd(pointB, B.axis[edgeB], B.extent[edgeB]), closestA,
+        closestB);
+    m.normal = edgeNormal;
+    AddPoint(m, closestA, closestB, -edgeSeparation,
+             0x1000u | static_cast<uint32_t>(edgeA * 3 + edgeB));
+    return true;
+  }
+
+  // Reference face on `ref`, with the normal pointing at `inc`.
+  const Obb& ref = boxes[faceBox];
+  const Obb& inc = boxes[1 - faceBox];
+  const Vector3 toIncident = inc.center - ref.center;
+  const Vector3 normal =
+      ref.axis[faceAxis] *
+      (math::Dot(ref.axis[faceAxis], toIncident) >= 0.0f ? 1.0f : -1.0f);
+
+  // Incident face: the face of `inc` most anti-parallel to the normal.
+  int incAxis = 0;
+  float most = -1.0f;
+  for (int k = 0; k < 3; ++k) {
+    const float d = std::fabs(math::Dot(inc.axis[k], normal));
+    if (d > most) {
+      most = d;
+      incAxis = k;
+    }
+  }
+  const float incSign =
+      math::Dot(inc.axis[incAxis], normal) > 0.0f ? -1.0f : 1.0f;
+  const int u = (incAxis + 1) % 3;
+  const int v = (incAxis + 2) % 3;
+  const Vector3 faceCenter = math::MulAdd(inc.center, inc.axis[incAxis],
+                                          incSign * inc.extent[incAxis]);
+  const Vector3 du = inc.axis[u] * inc.extent[u];
+  const Vector3 dv = inc.axis[v] * inc.extent[v];
+  ClipVertex polygon[16] = {{faceCenter + du + dv, 0, 0},
+                            {faceCenter - du + dv, 1, 1},
+                            {faceCenter - du - dv, 2, 2},
+                            {faceCenter + du - dv, 3, 3}};
+  int count = 4;
+
+  // Clip against the four side planes of the reference face, widened a
+  // little: equal boxes stacked flush would otherwise gain or lose corners
+  // to rounding from step to step, and with them the cached impulses.
+  constexpr float clipTolerance = 1e-3f;
+  ClipVertex clipped[16];
+  uint32_t plane = 0;
+  for (int k = 0; k < 3; ++k) {
+    if (k == faceAxis) continue;
+    for (int side = 0; side < 2; ++side) {
+      const Vector3 sideNormal = ref.axis[k] * (side == 0 ? 1.0f : -1.0f);
+      const float offset =
+          math::Dot(sideNormal, ref.center) + ref.extent[k] + clipTolerance;
+      count = ClipPolygon(polygon, count, sideNormal, offset, plane++,
+                          clipped);
+      std::copy(clipped, clipped + count, polygon);
+    }
+  }
+
+  // Keep the points below the reference face, and those just above it: a
+  // slightly tilted box keeps all its corners in the manifold instead of
+  // pivoting on the ones that happen to dip below.
+  const float faceOffset =
+      math::Dot(normal, ref.center) + ref.extent[faceAxis];
+  const uint32_t faceId = static_cast<uint32_t>(
+      (faceBox << 11) | (faceAxis << 9) | (incAxis << 7) |
+      (incSign > 0.0f ? 1 << 6 : 0));
+  ContactPoint points[16];
+  int pointCount = 0;
+  for (int i = 0; i < count; ++i) {
+    const float depth = faceOffset - math::Dot(normal, polygon[i].position);
+    if (depth < -speculativeDepth) continue;
+    ContactPoint& p = points[pointCount++];
+    p.position = math::MulAdd(polygon[i].position, normal, 0.5f * depth);
+    p.depth = depth;
+    p.id = faceId | polygon[i].feature;
+  }
+  if (pointCount == 0) return false;
+
+  m.normal = faceBox == 0 ? normal : normal * -1.0f;
+  ReducePoints(points, pointCount, normal, m);
+  return true;
+}
+
+// The table holds each unordered pair once; the other order runs the same
+// kernel with the shapes swapped and the normal flipped.
+template <CollideFunction Function>
+bool Flipped(const Collider& a, const Pose& poseA, const Collider& b,
+             const Pose& poseB, GjkCache* cache, ContactManifold& m) {
+  if (!Function(b, poseB, a, poseA, cache, m)) return false;
+  m.normal = m.normal * -1.0f;
+  return true;
+}
+
+constexpr CollideFunction
+    collideTable[Engine::shapeTypeCount][Engine::shapeTypeCount] = {
+        // SPHERE
+        {SphereSphere, SphereCapsule, SphereBox, ConvexCore},
+        // CAPSULE
+        {Flipped<SphereCapsule>, CapsuleCapsule, CapsuleBox, ConvexCore},
+        // BOX
+        {Flipped<SphereBox>, Flipped<CapsuleBox>, BoxBox, ConvexCore},
+        // CONVEX
+        {ConvexCore, ConvexCore, ConvexCore, ConvexCore},
+};
+
+using RayCastFunction = bool (*)(const Collider&, const Pose&, const Vector3&,
+                                 const Vector3&, float, float&);
+
+bool RaySphere(const Vector3& center, float radius, const Vector3& origin,
+               const Vector3& direction, float maxDistance, float& distance) {
+  const Vector3 offset = origin - center;
+  const float b = math::Dot(offset, direction);
+  const float c = math::Dot(offset, offset) - radius * radius;
+  // Outside and moving away.
+  if (c > 0.0f && b > 0.0f) return false;
+  const float discriminant = b * b - c;
+  if (discriminant < 0.0f) return false;
+  const float t = std::max(0.0f, -b - std::sqrt(discriminant));
+  if (t > maxDistance) return false;
+  distance = t;
+  return true;
+}
+
+bool RayCastSphere(const Collider& c, const Pose& pose, const Vector3& origin,
+                   const Vector3& direction, float maxDistance,
+                   float& distance) {
+  return RaySphere(pose.position, c.radius, origin, direction, maxDistance,
+                   distance);
+}
+
+// In body space the side of the capsule is a cylinder around y. Its flat
+// ends lie inside the cap spheres, so a ray from outside first enters the
+// capsule through the side or one of the spheres.
+bool RayCastCapsule(const Collider& c, const Pose& pose, const Vector3& origin,
+                    const Vector3& direction, float maxDistance,
+                    float& distance) {
+  const Vector3 o = pose.DirectionToLocal(origin - pose.position);
+  const Vector3 d = pose.DirectionToLocal(direction);
+  const float h = c.halfHeight;
+  const float r = c.radius;
+  const Vector3 fromCore =
+      o - Vector3(0.0f, std::min(h, std::max(-h, o.y)), 0.0f);
+  if (math::Dot(fromCore, fromCore) <= r * r) {
+    distance = 0.0f;
+    return true;
+  }
+  bool hit = false;
+  float t;
+  for (const float end : {h, -h}) {
+    if (RaySphere(Vector3(0.0f, end, 0.0f), r, o, d, maxDistance, t)) {
+      maxDistance = t;
+      hit = true;
+    }
+  }
+  const float a = d.x * d.x + d.z * d.z;
+  if (a > epsilon) {
+    const float b = o.x * d.x + o.z * d.z;
+    const float discriminant = b * b - a * (o.x * o.x + o.z * o.z - r * r);
+    if (discriminant >= 0.0f) {
+      t = (-b - std::sqrt(discriminant)) / a;
+      const float y = o.y + t * d.y;
+      if (t >= 0.0f && t <= maxDistance && y >= -h && y <= h) {
+        maxDistance = t;
+        hit = true;
+      }
+    }
+  }
+  if (hit) distance = maxDistance;
+  return hit;
+}
+
+// Slab test in body space, where the box is axis aligned.
+bool RayCastBox(const Collider& c, const Pose& pose, const Vector3& origin,
+                const Vector3& direction, float maxDistance, float& distance) {
+  const Vector3 o = pose.DirectionToLocal(origin - pose.position);
+  const Vector3 d = pose.DirectionToLocal(direction);
+  const math::Aabb box{c.halfExtents * -1.0f, c.halfExtents};
+  return box.IntersectsRay(o, Vector3(1.0f / d.x, 1.0f / d.y, 1.0f / d.z),
+                           maxDistance, distance);
+}
+
+// GJK ray cast by conservative advancement: the plane through the closest
+// hull point, facing the current point on the ray, separates the two. The
+// ray either leaves that plane behind and misses, or can safely advance to
+// it; this converges on the hull from outside.
+bool RayCastConvex(const Collider& c, const Pose& pose, const Vector3& origin,
+                   const Vector3& direction, float maxDistance,
+                   float& distance) {
+  const Vector3 zero(0.0f, 0.0f, 0.0f);
+  const Engine::ConvexHull point(&zero, 1);
+  Pose pointPose;
+  GjkCache cache;
+  float t = 0.0f;
+  for (int i = 0; i < maxRayIterations; ++i) {
+    pointPose.position = math::MulAdd(origin, direction, t);
+    const Engine::GjkResult result =
+        Engine::GjkDistance(point, pointPose, c.hull, pose, &cache);
+    if (result.overlap || result.distance <= rayTolerance) break;
+    const Vector3 away = result.pointA - result.pointB;
+    const float approach = -math::Dot(away, direction);
+    if (approach <= 0.0f) return false;
+    t += math::Dot(away, away) / approach;
+    if (t > maxDistance) return false;
+  }
+  // A ray that grazes the hull may run out of iterations a little short of
+  // it, still within maxDistance; it counts as a hit there.
+  distance = t;
+  return true;
+}
+
+constexpr RayCastFunction rayCastTable[Engine::shapeTypeCount] = {
+    RayCastSphere, RayCastCapsule, RayCastBox, RayCastConvex};
+}  // namespace
+
+bool Engine::Collide(const Collider& a, const Pose& poseA, const Collider& b,
+                     const Pose& poseB, GjkCache* cache,
+                     ContactManifold& manifold) {
+  manifold.pointCount = 0;
+  const CollideFunction function =
+      collideTable[static_cast<int>(a.type)][static_cast<int>(b.type)];
+  if (function(a, poseA, b, poseB, cache, manifold)) return true;
+  manifold.pointCount = 0;
+  return false;
+}
+
+bool Engine::CollideSpeculative(const Collider& a, const Pose& poseA,
+                                const Collider& b, const Pose& poseB,
+                                float margin, GjkCache* cache,
+                                ContactManifold& manifold) {
+  manifold.pointCount = 0;
+  // Capsule ends first: a capsule arriving flat on a face stops with one
+  // cap barely short of it, and a single point would spin it over.
+  if (a.type == ShapeType::CAPSULE && b.type != ShapeType::SPHERE) {
+    if (CapsuleEnds(a, poseA, b, poseB, margin, manifold)) return true;
+  } else if (b.type == ShapeType::CAPSULE && a.type != ShapeType::SPHERE) {
+    if (CapsuleEnds(b, poseB, a, poseA, margin, manifold)) {
+      manifold.normal = manifold.normal * -1.0f;
+      return true;
+    }
+  }
+  if (Collide(a, poseA, b, poseB, cache, manifold)) return true;
+  // Apart: a point between the closest features. GJK on the cores serves
+  // every shape pair; the closed-form kernels only report touching shapes.
+  // The shapes go in the order the table's kernel takes them, so the GJK
+  // cache indices keep referring to the same shapes.
+  const bool flipped = a.type != ShapeType::CONVEX && b.type < a.type;
+  const bool close =
+      flipped ? CoreContact(b, poseB, a, poseA, margin, cache, manifold)
+              : CoreContact(a, poseA, b, poseB, margin, cache, manifold);
+  if (!close) {
+    manifold.pointCount = 0;
+    return false;
+  }
+  if (flipped) manifold.normal = manifold.normal * -1.0f;
+  return true;
+}
+
+bool Engine::RayCastCollider(const Collider& collider, const Pose& pose,
+                             const math::Vector3& origin,
+                             const math::Vector3& direction,
+                             float maxDistance, float& distance) {
+  return rayCastTable[static_cast<int>(collider.type)](
+      collider, pose, origin, direction, maxDistance, distance);
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <Collider.hpp>
+#include <ConvexHull.hpp>
+#include <Gjk.hpp>
+#include <Vector3.hpp>
+#include <cstdint>
+
+namespace Engine {
+struct ContactPoint {
+  // World space, halfway between the two surfaces.
+  math::Vector3 position;
+  // Penetration along the manifold normal; positive when overlapping,
+  // slightly negative for points reported just short of touching.
+  float depth;
+  // Identifies the pair of features (faces, edges, vertices) that made the
+  // point, so a point can be matched with the same one next step.
+  uint32_t id;
+};
+
+// Contact between two shapes: up to four points sharing one normal, enough
+// to hold a box resting flat on another.
+struct ContactManifold {
+  static constexpr int maxPoints = 4;
+
+  // Unit vector from A into B.
+  math::Vector3 normal;
+  ContactPoint points[maxPoints];
+  int pointCount = 0;
+};
+
+// Collides two shapes with the kernel for their type pair: closed form for
+// spheres, capsules and boxes, GJK/EPA when a convex hull is involved.
+// Returns false, leaving `manifold` empty, when they do not touch. `cache`
+// may be null; it warm-starts GJK for the convex pairs.
+bool Collide(const Collider& a, const Pose& poseA, const Collider& b,
+             const Pose& poseB, GjkCache* cache, ContactManifold& manifold);
+
+// Collide, but shapes up to `margin` apart also get speculative points
+// between their closest features, with a depth of minus the gap. The
+// solver lets them close the gap in one step and no further, which stops
+// a fast body at a surface it would otherwise pass through. The normal is
+// taken at the current poses, so a body sliding past an edge may catch on
+// it.
+bool CollideSpeculative(const Collider& a, const Pose& poseA,
+                        const Collider& b, const Pose& poseB, float margin,
+                        GjkCache* cache, ContactManifold& manifold);
+
+// Distance t, 0 <= t <= maxDistance, at which the ray origin + t * direction
+// first touches the shape; a ray starting inside hits at 0. Closed form for
+// spheres, capsules and boxes, a GJK ray cast for hulls. `direction` must
+// be normalized.
+bool RayCastCollider(const Collider& collider, const Pose& pose,
+                     const math::Vector3& origin,
+                     const math::Vector3& direction, float maxDistance,
+                     float& distance);
+}  // namespace Engine
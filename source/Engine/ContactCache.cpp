@@ -0,0 +1,54 @@
+#include "ContactCache.hpp"
+
+#include <utility>
+
+Engine::Contact& Engine::ContactCache::Acquire(RigidBodyHandle a,
+                                               RigidBodyHandle b) {
+  if (a.slot > b.slot) std::swap(a, b);
+  uint32_t index = pairs.IndexOf(a.slot, b.slot);
+  if (index == PairSet::notFound) {
+    pairs.Insert(a.slot, b.slot);
+    index = static_cast<uint32_t>(contacts.size());
+    contacts.emplace_back();
+  } else if (contacts[index].a != a || contacts[index].b != b) {
+    contacts[index] = Contact();
+  }
+  Contact& contact = contacts[index];
+  contact.a = a;
+  contact.b = b;
+  contact.step = step;
+  return contact;
+}
+
+void Engine::ContactCache::Update(Contact& contact,
+                                  const ContactManifold& manifold) {
+  ContactImpulse impulses[ContactManifold::maxPoints];
+  for (int i = 0; i < manifold.pointCount; ++i) {
+    for (int j = 0; j < contact.manifold.pointCount; ++j) {
+      if (contact.manifold.points[j].id == manifold.points[i].id) {
+        impulses[i] = contact.impulses[j];
+        break;
+      }
+    }
+  }
+  contact.manifold = manifold;
+  for (int i = 0; i < ContactManifold::maxPoints; ++i)
+    contact.impulses[i] = impulses[i];
+}
+
+void Engine::ContactCache::EndStep(std::vector<RigidBodyPair>& separated) {
+  // Walking backwards, the contact moved into a hole has been kept already.
+  for (size_t i = contacts.size(); i-- > 0;) {
+    if (contacts[i].step == step) continue;
+    if (contacts[i].manifold.pointCount > 0)
+      separated.push_back({contacts[i].a, contacts[i].b});
+    pairs.Erase(contacts[i].a.slot, contacts[i].b.slot);
+    contacts[i] = contacts.back();
+    contacts.pop_back();
+  }
+}
+
+void Engine::ContactCache::Clear() {
+  pairs.Clear();
+  contacts.clear();
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <Collision.hpp>
+#include <Gjk.hpp>
+#include <PairSet.hpp>
+#include <RigidBody.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Engine {
+// Impulses the solver accumulated on one manifold point, along the normal
+// and the two friction directions.
+struct ContactImpulse {
+  float normal = 0.0f;
+  float tangent[2] = {0.0f, 0.0f};
+};
+
+// Narrowphase state of one broadphase pair. It lives as long as the pair
+// keeps overlapping in the broadphase, touching or not, so the GJK cache
+// and the impulses survive from step to step.
+struct Contact {
+  // Ordered by slot, so the pair always collides in the same order.
+  RigidBodyHandle a;
+  RigidBodyHandle b;
+  // Empty while the shapes do not touch.
+  ContactManifold manifold;
+  // Parallel to manifold.points.
+  ContactImpulse impulses[ContactManifold::maxPoints];
+  GjkCache gjk;
+  // Step in which the pair was last seen.
+  uint32_t step = 0;
+};
+
+// Contacts keyed by body pair, stored densely for the solver to walk. A
+// point keeps its impulses when the next step's manifold has a point with
+// the same feature id, so the solver can start from last step's answer
+// instead of from zero. Memory is only allocated when the cache outgrows
+// its largest size so far.
+class ContactCache {
+ private:
+  // Keyed by body slot; contacts[i] belongs to pairs.GetPairs()[i].
+  PairSet pairs;
+  std::vector<Contact> contacts;
+  uint32_t step = 0;
+
+ public:
+  // Starts a step: pairs not passed to Acquire before EndStep are dropped.
+  void BeginStep() { ++step; }
+  // The contact for the pair, created empty if the pair is new or one of
+  // its slots now holds a different body.
+  Contact& Acquire(RigidBodyHandle a, RigidBodyHandle b);
+  // Replaces the contact's manifold, carrying over the impulses of points
+  // whose feature ids match and starting the others at zero.
+  static void Update(Contact& contact, const ContactManifold& manifold);
+  // Drops the pairs not acquired since BeginStep. Those that were touching
+  // are appended to `separated`.
+  void EndStep(std::vector<RigidBodyPair>& separated);
+  void Clear();
+
+  size_t Size() const { return contacts.size(); }
+  // In no particular order; invalidated by Acquire and EndStep.
+  std::vector<Contact>& GetContacts() { return contacts; }
+  const std::vector<Contact>& GetContacts() const { return contacts; }
+};
+}  // namespace Engine
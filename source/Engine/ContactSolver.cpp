@@ -0,0 +1,732 @@
+#include "ContactSolver.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <initializer_list>
+
+#include "CpuFeatures.hpp"
+#include "VectorOps.hpp"
+
+#if (defined(__GNUC__) || defined(__clang__)) && \
+    (defined(__x86_64__) || defined(__i386__))
+// Lanes are GCC vector types: plain arithmetic on them compiles to the
+// instruction set of the function they are inlined into.
+#define SOLVER_WIDE_LANES 1
+#define SOLVER_INLINE inline __attribute__((always_inline))
+#define SOLVER_TARGET_SSE2 __attribute__((target("sse2")))
+#define SOLVER_TARGET_AVX __attribute__((target("avx")))
+#else
+#define SOLVER_INLINE inline
+#endif
+
+namespace {
+using math::Vector3;
+
+// Fraction of the penetration beyond `slop` removed per step.
+constexpr float baumgarte = 0.2f;
+constexpr float slop = 0.005f;
+// Approach speed below which contacts do not bounce.
+constexpr float restitutionThreshold = 1.0f;
+// Fewer constraints than this are not worth spreading over threads.
+constexpr size_t minParallelConstraints = 256;
+constexpr uint8_t noColor = 0xFF;
+// ContactSolver::noBody, for the lane kernels.
+constexpr uint32_t noLane = 0xFFFFFFFFu;
+
+Vector3 Multiply(const Vector3 rows[3], const Vector3& v) {
+  return Vector3(math::Dot(rows[0], v), math::Dot(rows[1], v),
+                 math::Dot(rows[2], v));
+}
+
+// Two unit vectors perpendicular to `n` and each other, always the same
+// for the same normal so cached friction impulses keep their meaning.
+void ComputeTangents(const Vector3& n, Vector3 tangent[2]) {
+  Vector3 t = std::fabs(n.x) >= 0.57735f ? Vector3(n.y, -n.x, 0.0f)
+                                          : Vector3(0.0f, n.z, -n.y);
+  t = t * (1.0f / std::sqrt(math::LengthSquared(t)));
+  tangent[0] = t;
+  tangent[1] = math::Cross(n, t);
+}
+
+// Lane kernels, written once for a lane type F: float solves one
+// constraint, Float4 and Float8 solve four or eight side by side.
+// A single lane value is only returned through a reference: GCC warns
+// (-Wpsabi) about any function returning an AVX vector by value when it is
+// compiled without AVX, even one that is always inlined.
+#ifdef SOLVER_WIDE_LANES
+typedef float Float4 __attribute__((vector_size(16)));
+typedef float Float8 __attribute__((vector_size(32)));
+#endif
+
+template <class F>
+struct Lanes3 {
+  F x, y, z;
+};
+
+template <class F>
+SOLVER_INLINE void Load(F& v, const float* p) {
+  std::memcpy(&v, p, sizeof(F));
+}
+
+template <class F>
+SOLVER_INLINE void Store(float* p, const F& v) {
+  std::memcpy(p, &v, sizeof(F));
+}
+
+template <class F, int lanes>
+SOLVER_INLINE Lanes3<F> Load3(const float (*p)[lanes], int lane) {
+  Lanes3<F> v;
+  Load(v.x, p[0] + lane);
+  Load(v.y, p[1] + lane);
+  Load(v.z, p[2] + lane);
+  return v;
+}
+
+// v = max(v, low), lane by lane.
+template <class F>
+SOLVER_INLINE void RaiseTo(F& v, const F& low) {
+  v = low > v ? low : v;
+}
+
+// v = min(v, high), lane by lane.
+template <class F>
+SOLVER_INLINE void LowerTo(F& v, const F& high) {
+  v = high < v ? high : v;
+}
+
+template <class F>
+SOLVER_INLINE void Dot(const Lanes3<F>& a, const Lanes3<F>& b, F& out) {
+  out = a.x * b.x + a.y * b.y + a.z * b.z;
+}
+
+template <class F>
+SOLVER_INLINE Lanes3<F> Cross(const Lanes3<F>& a, const Lanes3<F>& b) {
+  return {a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z,
+          a.x * b.y - a.y * b.x};
+}
+
+// `m` holds xx, xy, xz, yy, yz, zz of a symmetric matrix.
+template <class F>
+SOLVER_INLINE Lanes3<F> MultiplySymmetric(const F m[6], const Lanes3<F>& v) {
+  return {m[0] * v.x + m[1] * v.y + m[2] * v.z,
+          m[1] * v.x + m[3] * v.y + m[4] * v.z,
+          m[2] * v.x + m[4] * v.y + m[5] * v.z};
+}
+
+template <class F>
+SOLVER_INLINE void MulAdd(Lanes3<F>& v, const Lanes3<F>& d, const F& s) {
+  v.x = v.x + d.x * s;
+  v.y = v.y + d.y * s;
+  v.z = v.z + d.z * s;
+}
+
+// The lanes' side A or B: velocities, and zero masses where there is no
+// dynamic body.
+template <class F>
+struct LaneBodies {
+  Lanes3<F> linear;
+  Lanes3<F> angular;
+  F inverseMass;
+  F inverseInertia[6];
+};
+
+template <class F, class Body>
+SOLVER_INLINE void GatherVelocities(const uint32_t* index, const Body* bodies,
+                                    LaneBodies<F>& out) {
+  constexpr int lanes = sizeof(F) / sizeof(float);
+  float v[6][lanes];
+  for (int i = 0; i < lanes; ++i) {
+    if (index[i] == noLane) {
+      for (int k = 0; k < 6; ++k) v[k][i] = 0.0f;
+      continue;
+    }
+    const Body& body = bodies[index[i]];
+    v[0][i] = body.linear.x;
+    v[1][i] = body.linear.y;
+    v[2][i] = body.linear.z;
+    v[3][i] = body.angular.x;
+    v[4][i] = body.angular.y;
+    v[5][i] = body.angular.z;
+  }
+  Load(out.linear.x, v[0]);
+  Load(out.linear.y, v[1]);
+  Load(out.linear.z, v[2]);
+  Load(out.angular.x, v[3]);
+  Load(out.angular.y, v[4]);
+  Load(out.angular.z, v[5]);
+}
+
+template <class F, class Body>
+SOLVER_INLINE void ScatterVelocities(const uint32_t* index, Body* bodies,
+                                     const LaneBodies<F>& in) {
+  constexpr int lanes = sizeof(F) / sizeof(float);
+  float v[6][lanes];
+  Store(v[0], in.linear.x);
+  Store(v[1], in.linear.y);
+  Store(v[2], in.linear.z);
+  Store(v[3], in.angular.x);
+  Store(v[4], in.angular.y);
+  Store(v[5], in.angular.z);
+  for (int i = 0; i < lanes; ++i) {
+    if (index[i] == noLane) continue;
+    Body& body = bodies[index[i]];
+    body.linear = Vector3(v[0][i], v[1][i], v[2][i]);
+    body.angular = Vector3(v[3][i], v[4][i], v[5][i]);
+  }
+}
+
+template <class F>
+SOLVER_INLINE Lanes3<F> RelativeVelocity(const LaneBodies<F>& a,
+                                         const LaneBodies<F>& b,
+                                         const Lanes3<F>& armA,
+                                         const Lanes3<F>& armB) {
+  const Lanes3<F> spinA = Cross(a.angular, armA);
+  const Lanes3<F> spinB = Cross(b.angular, armB);
+  return {b.linear.x + spinB.x - a.linear.x - spinA.x,
+          b.linear.y + spinB.y - a.linear.y - spinA.y,
+          b.linear.z + spinB.z - a.linear.z - spinA.z};
+}
+
+// Applies `impulse` along `direction` to B and its opposite to A.
+template <class F>
+SOLVER_INLINE void ApplyImpulse(LaneBodies<F>& a, LaneBodies<F>& b,
+                                const Lanes3<F>& armA, const Lanes3<F>& armB,
+                                const Lanes3<F>& direction, const F& impulse) {
+  const F negated = F{} - impulse;
+  MulAdd(a.linear, direction, a.inverseMass * negated);
+  MulAdd(b.linear, direction, b.inverseMass * impulse);
+  MulAdd(a.angular, MultiplySymmetric(a.inverseInertia, Cross(armA, direction)),
+         negated);
+  MulAdd(b.angular, MultiplySymmetric(b.inverseInertia, Cross(armB, direction)),
+         impulse);
+}
+
+// One iteration over the lanes starting at `lane`, in the same order as
+// ContactSolver::SolveConstraint takes a single constraint.
+template <class F, class Batch, class Body>
+SOLVER_INLINE void SolveLanes(Batch& batch, int lane, Body* bodies,
+                              bool reverse) {
+  constexpr int lanes = sizeof(batch.friction) / sizeof(float);
+  LaneBodies<F> a, b;
+  GatherVelocities(batch.a + lane, bodies, a);
+  GatherVelocities(batch.b + lane, bodies, b);
+  Load(a.inverseMass, batch.inverseMassA + lane);
+  Load(b.inverseMass, batch.inverseMassB + lane);
+  for (int k = 0; k < 6; ++k) {
+    Load(a.inverseInertia[k], batch.inverseInertiaA[k] + lane);
+    Load(b.inverseInertia[k], batch.inverseInertiaB[k] + lane);
+  }
+  const Lanes3<F> normal = Load3<F, lanes>(batch.normal, lane);
+  const Lanes3<F> tangent[2] = {Load3<F, lanes>(batch.tangent[0], lane),
+                                Load3<F, lanes>(batch.tangent[1], lane)};
+  F friction;
+  Load(friction, batch.friction + lane);
+
+  for (auto& p : batch.points) {
+    const Lanes3<F> armA = Load3<F, lanes>(p.armA, lane);
+    const Lanes3<F> armB = Load3<F, lanes>(p.armB, lane);
+    F limit;
+    Load(limit, p.normalImpulse + lane);
+    limit = friction * limit;
+    for (int t = 0; t < 2; ++t) {
+      F speed, previous, mass;
+      Dot(RelativeVelocity(a, b, armA, armB), tangent[t], speed);
+      Load(previous, p.tangentImpulse[t] + lane);
+      Load(mass, p.tangentMass[t] + lane);
+      F next = previous - mass * speed;
+      RaiseTo(next, F{} - limit);
+      LowerTo(next, limit);
+      Store(p.tangentImpulse[t] + lane, next);
+      ApplyImpulse(a, b, armA, armB, tangent[t], next - previous);
+    }
+  }
+  constexpr int pointCount = sizeof(batch.points) / sizeof(batch.points[0]);
+  for (int j = 0; j < pointCount; ++j) {
+    auto& p = batch.points[reverse ? pointCount - 1 - j : j];
+    const Lanes3<F> armA = Load3<F, lanes>(p.armA, lane);
+    const Lanes3<F> armB = Load3<F, lanes>(p.armB, lane);
+    F speed, previous, mass, bias;
+    Dot(RelativeVelocity(a, b, armA, armB), normal, speed);
+    Load(previous, p.normalImpulse + lane);
+    Load(mass, p.normalMass + lane);
+    Load(bias, p.bias + lane);
+    F next = previous - mass * (speed - bias);
+    RaiseTo(next, F{});
+    Store(p.normalImpulse + lane, next);
+    ApplyImpulse(a, b, armA, armB, normal, next - previous);
+  }
+
+  ScatterVelocities(batch.a + lane, bodies, a);
+  ScatterVelocities(batch.b + lane, bodies, b);
+}
+
+template <class Batch, class Body>
+void SolveBatchesScalar(Batch* begin, Batch* end, Body* bodies,
+                        bool reverse) {
+  for (Batch* batch = begin; batch != end; ++batch) {
+    for (int lane = 0; lane < batch->count; ++lane)
+      SolveLanes<float>(*batch, lane, bodies, reverse);
+  }
+}
+
+#ifdef SOLVER_WIDE_LANES
+template <class Batch, class Body>
+SOLVER_TARGET_SSE2 void SolveBatchesSSE(Batch* begin, Batch* end,
+                                        Body* bodies, bool reverse) {
+  for (Batch* batch = begin; batch != end; ++batch) {
+    for (int lane = 0; lane < batch->count; lane += 4)
+      SolveLanes<Float4>(*batch, lane, bodies, reverse);
+  }
+}
+
+template <class Batch, class Body>
+SOLVER_TARGET_AVX void SolveBatchesAVX(Batch* begin, Batch* end,
+                                       Body* bodies, bool reverse) {
+  for (Batch* batch = begin; batch != end; ++batch)
+    SolveLanes<Float8>(*batch, 0, bodies, reverse);
+}
+#endif
+}  // namespace
+
+uint32_t Engine::ContactSolver::FindRoot(uint32_t body) {
+  // Path halving.
+  while (parent[body] != body) {
+    parent[body] = parent[parent[body]];
+    body = parent[body];
+  }
+  return body;
+}
+
+void Engine::ContactSolver::Solve(PhysicsWorld& world, ContactCache& cache,
+                                  float dt) {
+  GatherConstraints(world, cache.GetContacts(), dt);
+  islands.clear();
+  colors.clear();
+  if (constraints.empty()) return;
+
+  if (mode == SolverMode::ISLANDS) {
+    BuildIslands();
+    SolveIslands();
+  } else {
+    BuildColors();
+    SolveColors();
+  }
+
+  // Write back the impulses and the bodies the constraints touched.
+  math::Vector3Batch& linear = world.GetLinearVelocities();
+  math::Vector3Batch& angular = world.GetAngularVelocities();
+  for (const Constraint& c : constraints) {
+    for (int i = 0; i < c.pointCount; ++i)
+      c.contact->impulses[i] = c.points[i].impulse;
+    for (uint32_t index : {c.a, c.b}) {
+      if (index == noBody) continue;
+      linear.Set(index, bodies[index].linear);
+      angular.Set(index, bodies[index].angular);
+    }
+  }
+}
+
+void Engine::ContactSolver::GatherConstraints(PhysicsWorld& world,
+                                              std::vector<Contact>& contacts,
+                                              float dt) {
+  // Only awake bodies are solved; they come first in the world's arrays.
+  const uint32_t bodyCount = world.GetAwakeCount();
+  const auto& inverseMasses = world.GetInverseMasses();
+  const math::Vector3Batch& linear = world.GetLinearVelocities();
+  const math::Vector3Batch& angular = world.GetAngularVelocities();
+  bodies.resize(bodyCount);
+  gathered.assign(bodyCount, 0);
+  constraints.clear();
+
+  // Static and sleeping bodies take no impulse and are left out: noBody
+  // stands in.
+  auto dynamicIndex = [&](RigidBodyHandle body) {
+    const uint32_t index = world.GetIndex(body);
+    return index < bodyCount && inverseMasses[index] > 0.0f ? index : noBody;
+  };
+  for (Contact& contact : contacts) {
+    if (contact.manifold.pointCount == 0) continue;
+    const uint32_t a = dynamicIndex(contact.a);
+    const uint32_t b = dynamicIndex(contact.b);
+    if (a == noBody && b == noBody) continue;
+    constraints.emplace_back();
+    Constraint& c = constraints.back();
+    c.a = a;
+    c.b = b;
+    // Gather each body the first time a constraint meets it.
+    for (uint32_t index : {c.a, c.b}) {
+      if (index == noBody || gathered[index]) continue;
+      Body& body = bodies[index];
+      body.linear = linear.Get(index);
+      body.angular = angular.Get(index);
+      body.inverseMass = inverseMasses[index];
+      world.GetWorldInverseInertia(index, body.inverseInertia);
+      gathered[index] = 1;
+    }
+    Prepare(c, world, contact, dt);
+  }
+}
+
+void Engine::ContactSolver::Prepare(Constraint& c, const PhysicsWorld& world,
+                                    Contact& contact, float dt) const {
+  static const Body staticBody = {Vector3(0.0f, 0.0f, 0.0f),
+                                  Vector3(0.0f, 0.0f, 0.0f),
+                                  0.0f,
+                                  {Vector3(0.0f, 0.0f, 0.0f),
+                                   Vector3(0.0f, 0.0f, 0.0f),
+                                   Vector3(0.0f, 0.0f, 0.0f)}};
+  const Body& bodyA = c.a != noBody ? bodies[c.a] : staticBody;
+  const Body& bodyB = c.b != noBody ? bodies[c.b] : staticBody;
+  const Collider& colliderA = world.GetCollider(contact.a);
+  const Collider& colliderB = world.GetCollider(contact.b);
+  const Vector3 centerA = world.GetPosition(contact.a);
+  const Vector3 centerB = world.GetPosition(contact.b);
+
+  c.contact = &contact;
+  c.normal = contact.manifold.normal;
+  ComputeTangents(c.normal, c.tangent);
+  c.friction = std::sqrt(colliderA.friction * colliderB.friction);
+  const float restitution =
+      std::max(colliderA.restitution, colliderB.restitution);
+  c.pointCount = contact.manifold.pointCount;
+
+  const float inverseMass = bodyA.inverseMass + bodyB.inverseMass;
+  for (int i = 0; i < c.pointCount; ++i) {
+    const ContactPoint& point = contact.manifold.points[i];
+    Point& p = c.points[i];
+    p.armA = point.position - centerA;
+    p.armB = point.position - centerB;
+    p.impulse = contact.impulses[i];
+
+    // 1 / (J M^-1 J^T) for a unit impulse along `direction`.
+    auto mass = [&](const Vector3& direction) {
+      const Vector3 crossA = math::Cross(p.armA, direction);
+      const Vector3 crossB = math::Cross(p.armB, direction);
+      const float k =
+          inverseMass +
+          math::Dot(crossA, Multiply(bodyA.inverseInertia, crossA)) +
+          math::Dot(crossB, Multiply(bodyB.inverseInertia, crossB));
+      return k > 0.0f ? 1.0f / k : 0.0f;
+    };
+    p.normalMass = mass(c.normal);
+    p.tangentMass[0] = mass(c.tangent[0]);
+    p.tangentMass[1] = mass(c.tangent[1]);
+
+    const Vector3 relative =
+        bodyB.linear + math::Cross(bodyB.angular, p.armB) - bodyA.linear -
+        math::Cross(bodyA.angular, p.armA);
+    const float approach = math::Dot(relative, c.normal);
+    // A point short of touching lets the bodies close the gap this step
+    // but no more.
+    p.bias = point.depth < 0.0f
+                 ? point.depth / dt
+                 : baumgarte / dt * std::max(point.depth - slop, 0.0f);
+    // A point short of touching keeps its gap bias unless the bodies
+    // bounce, and they only bounce if the gap closes this step.
+    if (restitution > 0.0f && approach < -restitutionThreshold &&
+        point.depth - approach * dt >= 0.0f)
+      p.bias = std::max(p.bias, -restitution * approach);
+  }
+}
+
+void Engine::ContactSolver::BuildIslands() {
+  const uint32_t bodyCount = static_cast<uint32_t>(bodies.size());
+  parent.resize(bodyCount);
+  for (uint32_t i = 0; i < bodyCount; ++i) parent[i] = i;
+  // Static bodies do not join islands, so a floor does not merge
+  // everything resting on it into one island.
+  for (const Constraint& c : constraints) {
+    if (c.a == noBody || c.b == noBody) continue;
+    const uint32_t rootA = FindRoot(c.a);
+    const uint32_t rootB = FindRoot(c.b);
+    if (rootA != rootB) parent[rootA] = rootB;
+  }
+
+  // Count the constraints per island, then place them island by island.
+  islandOfRoot.assign(bodyCount, noBody);
+  for (const Constraint& c : constraints) {
+    const uint32_t root = FindRoot(c.a != noBody ? c.a : c.b);
+    if (islandOfRoot[root] == noBody) {
+      islandOfRoot[root] = static_cast<uint32_t>(islands.size());
+      islands.push_back({0, 0});
+    }
+    ++islands[islandOfRoot[root]].end;
+  }
+  uint32_t offset = 0;
+  for (Island& island : islands) {
+    const uint32_t size = island.end;
+    island.begin = island.end = offset;
+    offset += size;
+  }
+  islandConstraints.resize(constraints.size());
+  for (uint32_t k = 0; k < constraints.size(); ++k) {
+    const Constraint& c = constraints[k];
+    const uint32_t root = FindRoot(c.a != noBody ? c.a : c.b);
+    islandConstraints[islands[islandOfRoot[root]].end++] = k;
+  }
+}
+
+void Engine::ContactSolver::SolveIslands() {
+  const size_t islandCount = islands.size();
+  if (jobs == nullptr || jobs->GetThreadCount() <= 1 || islandCount <= 1 ||
+      constraints.size() < minParallelConstraints) {
+    for (const Island& island : islands) SolveIsland(island);
+    return;
+  }
+  // Largest islands first, so one big pile does not start last.
+  islandOrder.resize(islandCount);
+  for (uint32_t i = 0; i < islandCount; ++i) islandOrder[i] = i;
+  std::sort(islandOrder.begin(), islandOrder.end(),
+            [&](uint32_t x, uint32_t y) {
+              return islands[x].end - islands[x].begin >
+                     islands[y].end - islands[y].begin;
+            });
+  jobs->ParallelFor(
+      0, islandCount,
+      [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i)
+          SolveIsland(islands[islandOrder[i]]);
+      },
+      1);
+}
+
+void Engine::ContactSolver::SolveIsland(const Island& island) {
+  for (uint32_t k = island.begin; k < island.end; ++k)
+    WarmStart(constraints[islandConstraints[k]]);
+  // Sweeps alternate direction: always solving the same point first
+  // hands it more than its share and sets stacks rocking.
+  const uint32_t size = island.end - island.begin;
+  for (int iteration = 0; iteration < iterations; ++iteration) {
+    const bool reverse = iteration & 1;
+    for (uint32_t n = 0; n < size; ++n) {
+      const uint32_t k = reverse ? island.end - 1 - n : island.begin + n;
+      SolveConstraint(constraints[islandConstraints[k]], reverse);
+    }
+  }
+}
+
+void Engine::ContactSolver::BuildColors() {
+  // Greedy: each constraint takes the lowest color neither of its dynamic
+  // bodies has yet. Static bodies constrain nothing, so every contact with
+  // the floor can share a color.
+  bodyColors.assign(bodies.size(), 0);
+  const uint32_t constraintCount = static_cast<uint32_t>(constraints.size());
+  colorOf.resize(constraintCount);
+  uint32_t counts[maxColors] = {};
+  overflow.clear();
+  for (uint32_t k = 0; k < constraintCount; ++k) {
+    const Constraint& c = constraints[k];
+    uint64_t used = 0;
+    if (c.a != noBody) used |= bodyColors[c.a];
+    if (c.b != noBody) used |= bodyColors[c.b];
+    int color = 0;
+    while (color < maxColors && (used >> color & 1)) ++color;
+    if (color == maxColors) {
+      colorOf[k] = noColor;
+      overflow.push_back(k);
+      continue;
+    }
+    colorOf[k] = static_cast<uint8_t>(color);
+    ++counts[color];
+    const uint64_t bit = uint64_t(1) << color;
+    if (c.a != noBody) bodyColors[c.a] |= bit;
+    if (c.b != noBody) bodyColors[c.b] |= bit;
+  }
+
+  // Sort by color, then pack each color into batches of maxLanes.
+  uint32_t offsets[maxColors];
+  uint32_t offset = 0;
+  for (int color = 0; color < maxColors; ++color) {
+    offsets[color] = offset;
+    offset += counts[color];
+  }
+  colorConstraints.resize(offset);
+  for (uint32_t k = 0; k < constraintCount; ++k) {
+    if (colorOf[k] != noColor) colorConstraints[offsets[colorOf[k]]++] = k;
+  }
+  batches.clear();
+  offset = 0;
+  for (int color = 0; color < maxColors && counts[color] > 0; ++color) {
+    const uint32_t begin = static_cast<uint32_t>(batches.size());
+    for (uint32_t n = 0; n < counts[color]; n += maxLanes) {
+      batches.emplace_back();
+      Batch& batch = batches.back();
+      batch.count = static_cast<int>(
+          std::min<uint32_t>(maxLanes, counts[color] - n));
+      for (int lane = 0; lane < maxLanes; ++lane) {
+        if (lane >= batch.count) {
+          batch.a[lane] = batch.b[lane] = batch.constraint[lane] = noBody;
+          continue;
+        }
+        const uint32_t k = colorConstraints[offset + n + lane];
+        const Constraint& c = constraints[k];
+        batch.a[lane] = c.a;
+        batch.b[lane] = c.b;
+        batch.constraint[lane] = k;
+        const Vector3* directions[3] = {&c.normal, &c.tangent[0],
+                                        &c.tangent[1]};
+        for (int d = 0; d < 3; ++d) {
+          float(&out)[3][maxLanes] =
+              d == 0 ? batch.normal : batch.tangent[d - 1];
+          out[0][lane] = directions[d]->x;
+          out[1][lane] = directions[d]->y;
+          out[2][lane] = directions[d]->z;
+        }
+        batch.friction[lane] = c.friction;
+        for (int side = 0; side < 2; ++side) {
+          const uint32_t index = side == 0 ? c.a : c.b;
+          float& inverseMass =
+              side == 0 ? batch.inverseMassA[lane] : batch.inverseMassB[lane];
+          float(&inertia)[6][maxLanes] =
+              side == 0 ? batch.inverseInertiaA : batch.inverseInertiaB;
+          if (index == noBody) continue;
+          const Body& body = bodies[index];
+          inverseMass = body.inverseMass;
+          inertia[0][lane] = body.inverseInertia[0].x;
+          inertia[1][lane] = body.inverseInertia[0].y;
+          inertia[2][lane] = body.inverseInertia[0].z;
+          inertia[3][lane] = body.inverseInertia[1].y;
+          inertia[4][lane] = body.inverseInertia[1].z;
+          inertia[5][lane] = body.inverseInertia[2].z;
+        }
+        for (int i = 0; i < c.pointCount; ++i) {
+          const Point& p = c.points[i];
+          Batch::Points& out = batch.points[i];
+          out.armA[0][lane] = p.armA.x;
+          out.armA[1][lane] = p.armA.y;
+          out.armA[2][lane] = p.armA.z;
+          out.armB[0][lane] = p.armB.x;
+          out.armB[1][lane] = p.armB.y;
+          out.armB[2][lane] = p.armB.z;
+          out.normalMass[lane] = p.normalMass;
+          out.tangentMass[0][lane] = p.tangentMass[0];
+          out.tangentMass[1][lane] = p.tangentMass[1];
+          out.bias[lane] = p.bias;
+          out.normalImpulse[lane] = p.impulse.normal;
+          out.tangentImpulse[0][lane] = p.impulse.tangent[0];
+          out.tangentImpulse[1][lane] = p.impulse.tangent[1];
+        }
+      }
+    }
+    offset += counts[color];
+    colors.push_back({begin, static_cast<uint32_t>(batches.size())});
+  }
+}
+
+void Engine::ContactSolver::SolveColors() {
+  // No two constraints of a color share a dynamic body, so their order
+  // within the color does not matter: the result is the same for any lane
+  // width and thread count.
+  void (*solveBatches)(Batch*, Batch*, Body*, bool) =
+      SolveBatchesScalar<Batch, Body>;
+#ifdef SOLVER_WIDE_LANES
+  const math::SimdTier tier = math::GetSimdTier();
+  if (tier >= math::SimdTier::AVX)
+    solveBatches = SolveBatchesAVX<Batch, Body>;
+  else if (tier >= math::SimdTier::SSE2)
+    solveBatches = SolveBatchesSSE<Batch, Body>;
+#endif
+
+  for (const Constraint& c : constraints) WarmStart(c);
+
+  const bool parallel = jobs != nullptr && jobs->GetThreadCount() > 1 &&
+                        constraints.size() >= minParallelConstraints;
+  for (int iteration = 0; iteration < iterations; ++iteration) {
+    const bool reverse = iteration & 1;
+    const size_t colorCount = colors.size();
+    for (size_t n = 0; n < colorCount; ++n) {
+      const Color& color = colors[reverse ? colorCount - 1 - n : n];
+      Batch* first = batches.data() + color.begin;
+      if (!parallel) {
+        solveBatches(first, batches.data() + color.end, bodies.data(),
+                     reverse);
+        continue;
+      }
+      // A color's batches are independent; the next color waits for all.
+      jobs->ParallelFor(0, color.end - color.begin,
+                        [&](size_t begin, size_t end) {
+                          solveBatches(first + begin, first + end,
+                                       bodies.data(), reverse);
+                        });
+    }
+    for (uint32_t k : overflow) SolveConstraint(constraints[k], reverse);
+  }
+
+  for (const Batch& batch : batches) {
+    for (int lane = 0; lane < batch.count; ++lane) {
+      Constraint& c = constraints[batch.constraint[lane]];
+      for (int i = 0; i < c.pointCount; ++i) {
+        const Batch::Points& p = batch.points[i];
+        c.points[i].impulse.normal = p.normalImpulse[lane];
+        c.points[i].impulse.tangent[0] = p.tangentImpulse[0][lane];
+        c.points[i].impulse.tangent[1] = p.tangentImpulse[1][lane];
+      }
+    }
+  }
+}
+
+void Engine::ContactSolver::Apply(const Constraint& c, const Point& p,
+                                  const Vector3& impulse) {
+  if (c.a != noBody) {
+    Body& a = bodies[c.a];
+    a.linear = math::MulAdd(a.linear, impulse, -a.inverseMass);
+    a.angular =
+        a.angular - Multiply(a.inverseInertia, math::Cross(p.armA, impulse));
+  }
+  if (c.b != noBody) {
+    Body& b = bodies[c.b];
+    b.linear = math::MulAdd(b.linear, impulse, b.inverseMass);
+    b.angular =
+        b.angular + Multiply(b.inverseInertia, math::Cross(p.armB, impulse));
+  }
+}
+
+math::Vector3 Engine::ContactSolver::RelativeVelocity(
+    const Constraint& c, const Point& p) const {
+  Vector3 v(0.0f, 0.0f, 0.0f);
+  if (c.b != noBody) {
+    const Body& b = bodies[c.b];
+    v = b.linear + math::Cross(b.angular, p.armB);
+  }
+  if (c.a != noBody) {
+    const Body& a = bodies[c.a];
+    v = v - a.linear - math::Cross(a.angular, p.armA);
+  }
+  return v;
+}
+
+// Applies last step's impulses.
+void Engine::ContactSolver::WarmStart(const Constraint& c) {
+  for (int i = 0; i < c.pointCount; ++i) {
+    const Point& p = c.points[i];
+    Vector3 impulse = c.normal * p.impulse.normal;
+    impulse = math::MulAdd(impulse, c.tangent[0], p.impulse.tangent[0]);
+    impulse = math::MulAdd(impulse, c.tangent[1], p.impulse.tangent[1]);
+    Apply(c, p, impulse);
+  }
+}
+
+void Engine::ContactSolver::SolveConstraint(Constraint& c, bool reverse) {
+  // Friction first: the normal impulses, solved last, matter more.
+  for (int i = 0; i < c.pointCount; ++i) {
+    Point& p = c.points[i];
+    const float limit = c.friction * p.impulse.normal;
+    for (int t = 0; t < 2; ++t) {
+      const float speed = math::Dot(RelativeVelocity(c, p), c.tangent[t]);
+      const float previous = p.impulse.tangent[t];
+      p.impulse.tangent[t] = std::min(
+          limit, std::max(-limit, previous - p.tangentMass[t] * speed));
+      Apply(c, p, c.tangent[t] * (p.impulse.tangent[t] - previous));
+    }
+  }
+  for (int j = 0; j < c.pointCount; ++j) {
+    Point& p = c.points[reverse ? c.pointCount - 1 - j : j];
+    const float speed = math::Dot(RelativeVelocity(c, p), c.normal);
+    const float previous = p.impulse.normal;
+    // Accumulated impulse stays non-negative: contacts only push.
+    p.impulse.normal =
+        std::max(0.0f, previous - p.normalMass * (speed - p.bias));
+    Apply(c, p, c.normal * (p.impulse.normal - previous));
+  }
+}
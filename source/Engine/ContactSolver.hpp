@@ -0,0 +1,161 @@
+#pragma once
+
+#include <ContactCache.hpp>
+#include <JobSystem.hpp>
+#include <PhysicsWorld.hpp>
+#include <Vector3.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Engine {
+// ISLANDS solves each island, a group of dynamic bodies linked by contacts,
+// in series on one thread; it suits many separate piles. GRAPH_COLORING
+// splits the constraints into colors that share no dynamic body and solves
+// a color's constraints side by side, in SIMD lanes and across threads; it
+// suits one large pile, which ISLANDS leaves to a single thread. Impulses
+// travel through a pile a little slower color by color, so wide piles may
+// want a few more iterations.
+enum class SolverMode { ISLANDS, GRAPH_COLORING };
+
+// Sequential impulses (projected Gauss-Seidel) for contacts with friction.
+// Touching contacts are split into islands with union-find. Islands share
+// no dynamic body, so they are solved as parallel jobs with the same result
+// as in series.
+class ContactSolver {
+ private:
+  static constexpr uint32_t noBody = 0xFFFFFFFFu;
+  // Constraints per batch; the widest SIMD path solves them all at once.
+  static constexpr int maxLanes = 8;
+  // Colors beyond this many go to a final group solved one at a time.
+  static constexpr int maxColors = 64;
+
+  struct Body {
+    math::Vector3 linear;
+    math::Vector3 angular;
+    float inverseMass;
+    // Rows of the world-space inverse inertia tensor.
+    math::Vector3 inverseInertia[3];
+  };
+
+  struct Point {
+    // From each body's center to the contact point.
+    math::Vector3 armA;
+    math::Vector3 armB;
+    float normalMass;
+    float tangentMass[2];
+    // Separating velocity to reach: pushes out penetration, or bounces.
+    float bias;
+    ContactImpulse impulse;
+  };
+
+  struct Constraint {
+    // PhysicsWorld array indices; noBody for a static body.
+    uint32_t a;
+    uint32_t b;
+    Contact* contact;
+    math::Vector3 normal;
+    math::Vector3 tangent[2];
+    float friction;
+    int pointCount;
+    Point points[ContactManifold::maxPoints];
+  };
+
+  struct Island {
+    // Range in `islandConstraints`.
+    uint32_t begin;
+    uint32_t end;
+  };
+
+  // Up to maxLanes constraints of one color, stored lane by lane. Unused
+  // lanes and points have no bodies and zero masses, so they take no
+  // impulse.
+  struct alignas(32) Batch {
+    struct Points {
+      float armA[3][maxLanes];
+      float armB[3][maxLanes];
+      float normalMass[maxLanes];
+      float tangentMass[2][maxLanes];
+      float bias[maxLanes];
+      float normalImpulse[maxLanes];
+      float tangentImpulse[2][maxLanes];
+    };
+    uint32_t a[maxLanes];
+    uint32_t b[maxLanes];
+    // Index in `constraints`.
+    uint32_t constraint[maxLanes];
+    int count;
+    float normal[3][maxLanes];
+    float tangent[2][3][maxLanes];
+    float friction[maxLanes];
+    float inverseMassA[maxLanes];
+    float inverseMassB[maxLanes];
+    // xx, xy, xz, yy, yz, zz of the symmetric inverse inertia tensors.
+    float inverseInertiaA[6][maxLanes];
+    float inverseInertiaB[6][maxLanes];
+    Points points[ContactManifold::maxPoints];
+  };
+
+  struct Color {
+    // Range in `batches`.
+    uint32_t begin;
+    uint32_t end;
+  };
+
+  SolverMode mode = SolverMode::ISLANDS;
+  int iterations = 8;
+  JobSystem* jobs = nullptr;
+  // Scratch, reused from step to step.
+  std::vector<Body> bodies;
+  std::vector<uint8_t> gathered;
+  std::vector<Constraint> constraints;
+  std::vector<uint32_t> parent;
+  std::vector<uint32_t> islandOfRoot;
+  std::vector<Island> islands;
+  std::vector<uint32_t> islandConstraints;
+  std::vector<uint32_t> islandOrder;
+  std::vector<uint64_t> bodyColors;
+  std::vector<uint8_t> colorOf;
+  std::vector<uint32_t> colorConstraints;
+  std::vector<Color> colors;
+  std::vector<Batch> batches;
+  // Constraints that found no free color.
+  std::vector<uint32_t> overflow;
+
+  uint32_t FindRoot(uint32_t body);
+  void GatherConstraints(PhysicsWorld& world, std::vector<Contact>& contacts,
+                         float dt);
+  void Prepare(Constraint& c, const PhysicsWorld& world, Contact& contact,
+               float dt) const;
+  void BuildIslands();
+  void SolveIslands();
+  void SolveIsland(const Island& island);
+  void BuildColors();
+  void SolveColors();
+  void Apply(const Constraint& c, const Point& p, const math::Vector3& impulse);
+  math::Vector3 RelativeVelocity(const Constraint& c, const Point& p) const;
+  void WarmStart(const Constraint& c);
+  void SolveConstraint(Constraint& c, bool reverse);
+
+ public:
+  // Velocity iterations per step. Warm starting from the cached impulses
+  // lets stacks settle with far fewer than a cold start would need.
+  void SetIterations(int count) { iterations = count; }
+  void SetMode(SolverMode solverMode) { mode = solverMode; }
+  SolverMode GetMode() const { return mode; }
+  int GetIterations() const { return iterations; }
+  // Islands, and a color's batches, are spread over the job system's
+  // threads. Null, the default, solves on the calling thread only.
+  void SetJobSystem(JobSystem* jobSystem) { jobs = jobSystem; }
+  JobSystem* GetJobSystem() const { return jobs; }
+  // Of the last Solve; each is 0 when the other mode ran.
+  size_t GetIslandCount() const { return islands.size(); }
+  size_t GetColorCount() const { return colors.size(); }
+
+  // Solves the touching contacts: changes the velocities of the world's
+  // bodies and stores the accumulated impulses back into `contacts` for
+  // the next step to warm start from. Call between
+  // PhysicsWorld::IntegrateVelocities and IntegratePositions.
+  void Solve(PhysicsWorld& world, ContactCache& contacts, float dt);
+};
+}  // namespace Engine
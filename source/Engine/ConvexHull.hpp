@@ -0,0 +1,60 @@
+#pragma once
+
+#include <Quaternion.hpp>
+#include <Vector3.hpp>
+#include <VectorOps.hpp>
+#include <cstddef>
+#include <cstdint>
+
+namespace Engine {
+// Placement of a shape in the world: rotate, then translate.
+struct Pose {
+  math::Vector3 position = math::Vector3(0.0f, 0.0f, 0.0f);
+  math::Quaternion orientation;
+
+  math::Vector3 ToWorld(const math::Vector3& local) const {
+    return position + orientation.Rotate(local);
+  }
+  math::Vector3 DirectionToLocal(const math::Vector3& direction) const {
+    return orientation.Conjugate().Rotate(direction);
+  }
+};
+
+// Convex hull of a point cloud, described only by its points: the narrow
+// phase needs nothing but the support mapping. The points are not copied;
+// they are read `stride` bytes apart, so a hull can view the positions
+// inside an array of larger vertex structs.
+class ConvexHull {
+ private:
+  const unsigned char* data = nullptr;
+  size_t count = 0;
+  size_t stride = sizeof(math::Vector3);
+
+ public:
+  ConvexHull() = default;
+  ConvexHull(const math::Vector3* first, size_t count,
+             size_t stride = sizeof(math::Vector3))
+      : data(reinterpret_cast<const unsigned char*>(first)),
+        count(count),
+        stride(stride) {}
+
+  size_t Size() const { return count; }
+  const math::Vector3& Point(size_t i) const {
+    return *reinterpret_cast<const math::Vector3*>(data + i * stride);
+  }
+
+  // Index of the point furthest along `direction` (body space).
+  uint32_t Support(const math::Vector3& direction) const {
+    uint32_t best = 0;
+    float bestDot = math::Dot(Point(0), direction);
+    for (size_t i = 1; i < count; ++i) {
+      const float d = math::Dot(Point(i), direction);
+      if (d > bestDot) {
+        bestDot = d;
+        best = static_cast<uint32_t>(i);
+      }
+    }
+    return best;
+  }
+};
+}  // namespace Engine
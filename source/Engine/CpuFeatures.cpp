@@ -0,0 +1,97 @@
+#include "CpuFeatures.hpp"
+
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || \
+    defined(_M_IX86)
+#define CPU_FEATURES_X86 1
+#ifdef _MSC_VER
+#include <immintrin.h>
+#include <intrin.h>
+#endif
+#endif
+
+namespace {
+const char* const tierNames[] = {"scalar", "sse2", "sse4.2",
+                                 "avx",    "avx2", "avx512"};
+
+math::CpuFeatures QueryCpuFeatures() {
+  math::CpuFeatures features;
+#if defined(CPU_FEATURES_X86) && defined(_MSC_VER)
+  int info[4];
+  __cpuid(info, 0);
+  const int maxLeaf = info[0];
+  __cpuid(info, 1);
+  features.sse2 = (info[3] & (1 << 26)) != 0;
+  features.sse42 = (info[2] & (1 << 20)) != 0;
+  features.fma = (info[2] & (1 << 12)) != 0;
+  const bool osxsave = (info[2] & (1 << 27)) != 0;
+  // The OS must save the ymm (and for AVX-512 the zmm and mask) registers.
+  const unsigned long long xcr0 = osxsave ? _xgetbv(0) : 0;
+  const bool osAvx = (xcr0 & 0x6) == 0x6;
+  const bool osAvx512 = (xcr0 & 0xE6) == 0xE6;
+  features.avx = osAvx && (info[2] & (1 << 28)) != 0;
+  if (maxLeaf >= 7) {
+    __cpuidex(info, 7, 0);
+    features.avx2 = features.avx && (info[1] & (1 << 5)) != 0;
+    features.avx512f = osAvx512 && (info[1] & (1 << 16)) != 0;
+  }
+  features.fma = features.fma && features.avx;
+#elif defined(CPU_FEATURES_X86)
+  __builtin_cpu_init();
+  features.sse2 = __builtin_cpu_supports("sse2");
+  features.sse42 = __builtin_cpu_supports("sse4.2");
+  features.avx = __builtin_cpu_supports("avx");
+  features.avx2 = __builtin_cpu_supports("avx2");
+  features.fma = __builtin_cpu_supports("fma");
+  features.avx512f = __builtin_cpu_supports("avx512f");
+#endif
+  return features;
+}
+
+math::SimdTier& ActiveTier() {
+  static math::SimdTier tier = math::DetectSimdTier();
+  return tier;
+}
+}  // namespace
+
+const math::CpuFeatures& math::GetCpuFeatures() {
+  static const CpuFeatures features = QueryCpuFeatures();
+  return features;
+}
+
+math::SimdTier math::DetectSimdTier() {
+  const CpuFeatures& f = GetCpuFeatures();
+  // The AVX2 kernels also use FMA; every AVX2 CPU shipped so far has it.
+  if (f.avx512f && f.avx2 && f.fma) return SimdTier::AVX512;
+  if (f.avx2 && f.fma) return SimdTier::AVX2;
+  if (f.avx) return SimdTier::AVX;
+  if (f.sse42) return SimdTier::SSE42;
+  if (f.sse2) return SimdTier::SSE2;
+  return SimdTier::SCALAR;
+}
+
+math::SimdTier math::GetSimdTier() { return ActiveTier(); }
+
+math::SimdTier math::SetSimdTier(SimdTier tier) {
+  const SimdTier detected = DetectSimdTier();
+  if (tier > detected) tier = detected;
+  ActiveTier() = tier;
+  detail::BindMatrixKernels(tier);
+  detail::BindBatchKernels(tier);
+  return tier;
+}
+
+const char* math::SimdTierName(SimdTier tier) {
+  return tierNames[static_cast<int>(tier)];
+}
+
+bool math::ParseSimdTier(const char* name, SimdTier& tier) {
+  for (int i = 0; i <= static_cast<int>(SimdTier::AVX512); ++i) {
+    if (std::strcmp(name, tierNames[i]) == 0) {
+      tier = static_cast<SimdTier>(i);
+      return true;
+    }
+  }
+  return false;
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+// Runtime CPU feature detection and kernel dispatch. One binary runs on
+// hosts with different instruction sets: the hot kernels (MatrixKernels,
+// BatchKernels) are reached through function pointers that SetSimdTier
+// binds to the widest implementation allowed by the active tier.
+namespace math {
+// Ordered from narrowest to widest; each tier implies the ones below it.
+enum class SimdTier { SCALAR, SSE2, SSE42, AVX, AVX2, AVX512 };
+
+struct CpuFeatures {
+  bool sse2 = false;
+  bool sse42 = false;
+  bool avx = false;
+  bool avx2 = false;
+  bool fma = false;
+  bool avx512f = false;
+};
+
+// Detected once, on first call. Includes the OS support check for the
+// wide registers, so avx/avx512f are false when the OS does not save them.
+const CpuFeatures& GetCpuFeatures();
+
+// Widest tier the running CPU supports.
+SimdTier DetectSimdTier();
+
+// Tier the kernels are currently bound to. Until SetSimdTier is called this
+// is DetectSimdTier().
+SimdTier GetSimdTier();
+
+// Rebinds every dispatched kernel to `tier`, clamped to DetectSimdTier(),
+// and returns the tier actually used. Forcing a lower tier is meant for
+// testing and benchmarking. Not thread safe: call it before any thread uses
+// the kernels (Engine::Initialize does).
+SimdTier SetSimdTier(SimdTier tier);
+
+// "scalar", "sse2", "sse4.2", "avx", "avx2" or "avx512".
+const char* SimdTierName(SimdTier tier);
+// Parses a name returned by SimdTierName. Returns false if unknown.
+bool ParseSimdTier(const char* name, SimdTier& tier);
+
+namespace detail {
+// Implemented next to each kernel table; called by SetSimdTier.
+void BindMatrixKernels(SimdTier tier);
+void BindBatchKernels(SimdTier tier);
+}  // namespace detail
+}  // namespace math
@@ -0,0 +1,277 @@
+#include "DynamicAabbTree.hpp"
+
+namespace {
+// Fat boxes are stretched this many times the expected displacement, so a
+// body moving steadily is reinserted every few steps rather than every one.
+constexpr float displacementMultiplier = 4.0f;
+}  // namespace
+
+Engine::DynamicAabbTree::DynamicAabbTree(float margin) : margin(margin) {}
+
+uint32_t Engine::DynamicAabbTree::AllocateNode() {
+  uint32_t id;
+  if (freeList == nullNode) {
+    id = static_cast<uint32_t>(nodes.size());
+    nodes.emplace_back();
+  } else {
+    id = freeList;
+    freeList = nodes[id].parent;
+  }
+  Node& node = nodes[id];
+  node.parent = nullNode;
+  node.child1 = nullNode;
+  node.child2 = nullNode;
+  node.userData = 0;
+  node.height = 0;
+  node.moved = false;
+  return id;
+}
+
+void Engine::DynamicAabbTree::FreeNode(uint32_t node) {
+  nodes[node].parent = freeList;
+  nodes[node].height = -1;
+  freeList = node;
+}
+
+math::Aabb Engine::DynamicAabbTree::FattenedBox(
+    const math::Aabb& box, const math::Vector3& displacement) const {
+  math::Aabb fat = box.Fattened(margin);
+  const math::Vector3 d = displacement * displacementMultiplier;
+  (d.x < 0.0f ? fat.min.x : fat.max.x) += d.x;
+  (d.y < 0.0f ? fat.min.y : fat.max.y) += d.y;
+  (d.z < 0.0f ? fat.min.z : fat.max.z) += d.z;
+  return fat;
+}
+
+uint32_t Engine::DynamicAabbTree::CreateProxy(const math::Aabb& box,
+                                              uint32_t userData) {
+  const uint32_t proxy = AllocateNode();
+  nodes[proxy].box = FattenedBox(box, math::Vector3(0.0f, 0.0f, 0.0f));
+  nodes[proxy].userData = userData;
+  nodes[proxy].moved = true;
+  InsertLeaf(proxy);
+  movedProxies.push_back(proxy);
+  ++proxyCount;
+  return proxy;
+}
+
+void Engine::DynamicAabbTree::DestroyProxy(uint32_t proxy) {
+  RemoveLeaf(proxy);
+  nodes[proxy].height = -1;
+  destroyedProxies.push_back(proxy);
+  --proxyCount;
+}
+
+bool Engine::DynamicAabbTree::MoveProxy(uint32_t proxy, const math::Aabb& box,
+                                        const math::Vector3& displacement) {
+  Node& node = nodes[proxy];
+  if (node.box.Contains(box)) {
+    // Still inside, unless the fat box has become far too large, e.g. after
+    // the body slowed down: a loose box reports pairs that are not there.
+    const math::Aabb loose =
+        FattenedBox(box, displacement).Fattened(4.0f * margin);
+    if (loose.Contains(node.box)) return false;
+  }
+
+  RemoveLeaf(proxy);
+  node.box = FattenedBox(box, displacement);
+  InsertLeaf(proxy);
+  if (!node.moved) {
+    node.moved = true;
+    movedProxies.push_back(proxy);
+  }
+  return true;
+}
+
+void Engine::DynamicAabbTree::Clear() {
+  nodes.clear();
+  root = nullNode;
+  freeList = nullNode;
+  proxyCount = 0;
+  movedProxies.clear();
+  destroyedProxies.clear();
+  pairs.Clear();
+}
+
+void Engine::DynamicAabbTree::InsertLeaf(uint32_t leaf) {
+  if (root == nullNode) {
+    root = leaf;
+    nodes[leaf].parent = nullNode;
+    return;
+  }
+
+  // Walk down towards the cheapest sibling: at each node, compare the cost
+  // of pairing the leaf with it here against the lower bound of pushing
+  // the leaf into either child. Enlarging ancestors costs their area growth.
+  const math::Aabb leafBox = nodes[leaf].box;
+  uint32_t index = root;
+  while (!nodes[index].IsLeaf()) {
+    const Node& node = nodes[index];
+    const float area = node.box.SurfaceArea();
+    const float combinedArea =
+        math::Aabb::Merge(node.box, leafBox).SurfaceArea();
+    const float cost = 2.0f * combinedArea;
+    const float inheritance = 2.0f * (combinedArea - area);
+
+    float childCost[2];
+    const uint32_t children[2] = {node.child1, node.child2};
+    for (int i = 0; i < 2; ++i) {
+      const Node& child = nodes[children[i]];
+      const float merged =
+          math::Aabb::Merge(child.box, leafBox).SurfaceArea();
+      const float growth =
+          child.IsLeaf() ? merged : merged - child.box.SurfaceArea();
+      childCost[i] = growth + inheritance;
+    }
+    if (cost < childCost[0] && cost < childCost[1]) break;
+    index = childCost[0] < childCost[1] ? node.child1 : node.child2;
+  }
+  const uint32_t sibling = index;
+
+  // A new parent takes the sibling's place.
+  const uint32_t oldParent = nodes[sibling].parent;
+  const uint32_t newParent = AllocateNode();
+  Node& parent = nodes[newParent];
+  parent.parent = oldParent;
+  parent.box = math::Aabb::Merge(leafBox, nodes[sibling].box);
+  parent.height = nodes[sibling].height + 1;
+  parent.child1 = sibling;
+  parent.child2 = leaf;
+  nodes[sibling].parent = newParent;
+  nodes[leaf].parent = newParent;
+  if (oldParent == nullNode) {
+    root = newParent;
+  } else if (nodes[oldParent].child1 == sibling) {
+    nodes[oldParent].child1 = newParent;
+  } else {
+    nodes[oldParent].child2 = newParent;
+  }
+
+  Refit(nodes[leaf].parent);
+}
+
+void Engine::DynamicAabbTree::RemoveLeaf(uint32_t leaf) {
+  if (leaf == root) {
+    root = nullNode;
+    return;
+  }
+
+  // The sibling takes the parent's place and the parent is freed.
+  const uint32_t parent = nodes[leaf].parent;
+  const uint32_t grandParent = nodes[parent].parent;
+  const uint32_t sibling = nodes[parent].child1 == leaf
+                               ? nodes[parent].child2
+                               : nodes[parent].child1;
+  FreeNode(parent);
+  nodes[sibling].parent = grandParent;
+  if (grandParent == nullNode) {
+    root = sibling;
+    return;
+  }
+  if (nodes[grandParent].child1 == parent) {
+    nodes[grandParent].child1 = sibling;
+  } else {
+    nodes[grandParent].child2 = sibling;
+  }
+  Refit(grandParent);
+}
+
+void Engine::DynamicAabbTree::Refit(uint32_t node) {
+  for (uint32_t index = node; index != nullNode;
+       index = nodes[index].parent) {
+    Rotate(index);
+    Node& n = nodes[index];
+    const Node& a = nodes[n.child1];
+    const Node& b = nodes[n.child2];
+    n.height = 1 + std::max(a.height, b.height);
+    n.box = math::Aabb::Merge(a.box, b.box);
+  }
+}
+
+void Engine::DynamicAabbTree::Rotate(uint32_t iA) {
+  if (nodes[iA].height < 2) return;
+
+  // Try swapping each child of A with a grandchild under the other child.
+  // A keeps the same leaves, so only the other child's area changes.
+  float bestGain = 0.0f;
+  uint32_t bestChild = nullNode;
+  uint32_t bestGrandchild = nullNode;
+  const uint32_t children[2] = {nodes[iA].child1, nodes[iA].child2};
+  for (int i = 0; i < 2; ++i) {
+    const uint32_t child = children[i];
+    const Node& other = nodes[children[1 - i]];
+    if (other.IsLeaf()) continue;
+    const float area = other.box.SurfaceArea();
+    const math::Aabb& box = nodes[child].box;
+    const float gain1 =
+        area - math::Aabb::Merge(box, nodes[other.child2].box).SurfaceArea();
+    const float gain2 =
+        area - math::Aabb::Merge(box, nodes[other.child1].box).SurfaceArea();
+    if (gain1 > bestGain) {
+      bestGain = gain1;
+      bestChild = child;
+      bestGrandchild = other.child1;
+    }
+    if (gain2 > bestGain) {
+      bestGain = gain2;
+      bestChild = child;
+      bestGrandchild = other.child2;
+    }
+  }
+  if (bestChild == nullNode) return;
+
+  Node& a = nodes[iA];
+  const uint32_t iOther = a.child1 == bestChild ? a.child2 : a.child1;
+  Node& other = nodes[iOther];
+  (a.child1 == bestChild ? a.child1 : a.child2) = bestGrandchild;
+  (other.child1 == bestGrandchild ? other.child1 : other.child2) = bestChild;
+  nodes[bestGrandchild].parent = iA;
+  nodes[bestChild].parent = iOther;
+  const Node& c1 = nodes[other.child1];
+  const Node& c2 = nodes[other.child2];
+  other.box = math::Aabb::Merge(c1.box, c2.box);
+  other.height = 1 + std::max(c1.height, c2.height);
+}
+
+void Engine::DynamicAabbTree::UpdatePairs() {
+  // Destroyed proxies take their pairs with them.
+  if (!destroyedProxies.empty()) {
+    stalePairs.clear();
+    for (const BroadphasePair& pair : pairs.GetPairs()) {
+      if (nodes[pair.a].height < 0 || nodes[pair.b].height < 0)
+        stalePairs.push_back(pair);
+    }
+    for (const BroadphasePair& pair : stalePairs) pairs.Erase(pair.a, pair.b);
+    for (uint32_t proxy : destroyedProxies) FreeNode(proxy);
+    destroyedProxies.clear();
+  }
+  if (movedProxies.empty()) return;
+
+  // Pairs of a moved proxy may have ended.
+  stalePairs.clear();
+  for (const BroadphasePair& pair : pairs.GetPairs()) {
+    const Node& a = nodes[pair.a];
+    const Node& b = nodes[pair.b];
+    if ((a.moved || b.moved) && !a.box.Overlaps(b.box))
+      stalePairs.push_back(pair);
+  }
+  for (const BroadphasePair& pair : stalePairs) pairs.Erase(pair.a, pair.b);
+
+  // ...and new ones may have begun.
+  for (uint32_t proxy : movedProxies) {
+    // Destroyed after it moved.
+    if (nodes[proxy].height != 0) continue;
+    Query(nodes[proxy].box, [this, proxy](uint32_t other) {
+      if (other != proxy) pairs.Insert(proxy, other);
+      return true;
+    });
+  }
+  for (uint32_t proxy : movedProxies) nodes[proxy].moved = false;
+  movedProxies.clear();
+}
+
+void Engine::DynamicAabbTree::GetOverlappingPairs(
+    std::vector<BroadphasePair>& out) const {
+  const auto& current = pairs.GetPairs();
+  out.insert(out.end(), current.begin(), current.end());
+}
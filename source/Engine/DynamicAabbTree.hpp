@@ -0,0 +1,146 @@
+#pragma once
+
+#include <Aabb.hpp>
+#include <PairSet.hpp>
+#include <Vector3.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Engine {
+// Bounding volume hierarchy over fattened boxes. Each proxy's leaf stores
+// its box grown by a margin (and stretched along its motion), so a proxy
+// whose tight box is still inside the fat one is not touched by MoveProxy.
+// Insertion picks the sibling with the lowest surface area cost, and local
+// rotations on the way back up keep the tree tight as proxies come and go.
+class DynamicAabbTree {
+ public:
+  static constexpr uint32_t nullNode = 0xFFFFFFFFu;
+
+ private:
+  struct Node {
+    math::Aabb box;
+    // Next free node while the node is on the free list.
+    uint32_t parent;
+    uint32_t child1;
+    uint32_t child2;
+    uint32_t userData;
+    // 0 for leaves, -1 for free or destroyed nodes.
+    int height;
+    bool moved;
+
+    bool IsLeaf() const { return child1 == nullNode; }
+  };
+
+  std::vector<Node> nodes;
+  uint32_t root = nullNode;
+  uint32_t freeList = nullNode;
+  size_t proxyCount = 0;
+  float margin;
+  // Proxies whose fat box changed since the last UpdatePairs.
+  std::vector<uint32_t> movedProxies;
+  // Destroyed leaves are only freed by UpdatePairs, after their pairs are
+  // gone, so a new proxy cannot inherit them.
+  std::vector<uint32_t> destroyedProxies;
+  // Pairs of proxies whose fat boxes overlap.
+  PairSet pairs;
+  // Scratch space, kept to avoid allocating every update.
+  mutable std::vector<uint32_t> stack;
+  std::vector<BroadphasePair> stalePairs;
+
+  uint32_t AllocateNode();
+  void FreeNode(uint32_t node);
+  void InsertLeaf(uint32_t leaf);
+  void RemoveLeaf(uint32_t leaf);
+  // Swaps a child of `node` with a grandchild when that shrinks the
+  // subtree's surface area.
+  void Rotate(uint32_t node);
+  void Refit(uint32_t node);
+  math::Aabb FattenedBox(const math::Aabb& box,
+                         const math::Vector3& displacement) const;
+
+ public:
+  // `margin` is how far a proxy may move before its leaf is reinserted.
+  explicit DynamicAabbTree(float margin = 0.1f);
+
+  uint32_t CreateProxy(const math::Aabb& box, uint32_t userData);
+  void DestroyProxy(uint32_t proxy);
+  // Returns false, doing nothing, while `box` still fits in the fat box.
+  // Otherwise the leaf is reinserted with a fat box stretched along
+  // `displacement`, the expected motion until the next call.
+  bool MoveProxy(uint32_t proxy, const math::Aabb& box,
+                 const math::Vector3& displacement);
+  const math::Aabb& GetFatBox(uint32_t proxy) const {
+    return nodes[proxy].box;
+  }
+  uint32_t GetUserData(uint32_t proxy) const { return nodes[proxy].userData; }
+  size_t GetProxyCount() const { return proxyCount; }
+  // 0 for an empty tree or a single leaf.
+  int GetHeight() const { return root == nullNode ? 0 : nodes[root].height; }
+  void Clear();
+
+  // Brings the pair set up to date with the proxies moved, created and
+  // destroyed since the last call. Work is proportional to the moved
+  // proxies; proxies that stayed inside their fat boxes cost nothing.
+  void UpdatePairs();
+  // Appends every pair of proxies whose fat boxes overlap, each once.
+  void GetOverlappingPairs(std::vector<BroadphasePair>& out) const;
+
+  // Calls callback(proxy) for every proxy whose fat box overlaps `box`;
+  // the walk stops early when the callback returns false.
+  template <typename Callback>
+  void Query(const math::Aabb& box, Callback&& callback) const;
+  // Walks the proxies whose fat boxes the ray origin + t * direction,
+  // 0 <= t <= maxDistance, passes through. callback(proxy, maxDistance)
+  // returns the new maximum distance: the distance of a hit to clip the
+  // ray, maxDistance to keep going, or 0 to stop.
+  template <typename Callback>
+  void RayCast(const math::Vector3& origin, const math::Vector3& direction,
+               float maxDistance, Callback&& callback) const;
+};
+
+template <typename Callback>
+void DynamicAabbTree::Query(const math::Aabb& box, Callback&& callback) const {
+  if (root == nullNode) return;
+  stack.clear();
+  stack.push_back(root);
+  while (!stack.empty()) {
+    const uint32_t id = stack.back();
+    stack.pop_back();
+    const Node& node = nodes[id];
+    if (!node.box.Overlaps(box)) continue;
+    if (node.IsLeaf()) {
+      if (!callback(id)) return;
+    } else {
+      stack.push_back(node.child1);
+      stack.push_back(node.child2);
+    }
+  }
+}
+
+template <typename Callback>
+void DynamicAabbTree::RayCast(const math::Vector3& origin,
+                              const math::Vector3& direction,
+                              float maxDistance, Callback&& callback) const {
+  if (root == nullNode) return;
+  const math::Vector3 inverse(1.0f / direction.x, 1.0f / direction.y,
+                              1.0f / direction.z);
+  stack.clear();
+  stack.push_back(root);
+  while (!stack.empty()) {
+    const uint32_t id = stack.back();
+    stack.pop_back();
+    const Node& node = nodes[id];
+    float distance;
+    if (!node.box.IntersectsRay(origin, inverse, maxDistance, distance))
+      continue;
+    if (node.IsLeaf()) {
+      maxDistance = callback(id, maxDistance);
+      if (maxDistance <= 0.0f) return;
+    } else {
+      stack.push_back(node.child1);
+      stack.push_back(node.child2);
+    }
+  }
+}
+}  // namespace Engine
@@ -1,7 +1,11 @@
 #include "Engine.hpp"
 
+#include <cmath>
+#include <cstdlib>
 #include <iostream>
 
+#include "logs.h"
+
 void InputCallback(GLFWwindow *window, int key, int scancode, int action,
                    int mods) {
   if (key == GLFW_KEY_ESCAPE && action == GLFW_PRESS)
@@ -17,6 +21,7 @@ void ErrorCallback(int error_code, const char *err_str) {
 }
 
 void Engine::Engine::AddScene(std::shared_ptr<Scene> scene) {
+  scene->SetJobSystem(&jobSystem);
   scenes.push_back(scene);
 }
 
@@ -24,9 +29,48 @@ void Engine::Engine::EnterScene(int sceneIndex) {
   if (currentScene != nullptr) currentScene->Exit();
   currentScene = scenes[sceneIndex];
   currentScene->Initialize();
+  // Time spent loading does not count as simulated time.
+  previousTime = glfwGetTime();
+  accumulator = 0.0;
+}
+
+void Engine::Engine::ForceSimdTier(math::SimdTier tier) {
+  forcedSimdTier = tier;
+}
+
+void Engine::Engine::SetWorkerThreadCount(unsigned count) {
+  workerThreadCount = count;
+}
+
+void Engine::Engine::SetPhysicsOnWorkerThread(bool enabled) {
+  physicsOnWorker = enabled;
 }
 
 bool Engine::Engine::Initialize() {
+  // Bind the math kernels to the widest SIMD tier this CPU supports, unless
+  // a lower one is forced for testing.
+  math::SimdTier simdTier = forcedSimdTier.value_or(math::DetectSimdTier());
+  if (const char* forced = std::getenv("ENGINE_SIMD_TIER")) {
+    if (!math::ParseSimdTier(forced, simdTier))
+      warning("unknown ENGINE_SIMD_TIER: " << forced);
+  }
+  simdTier = math::SetSimdTier(simdTier);
+  debug("SIMD kernels: " << math::SimdTierName(simdTier));
+
+  unsigned workers =
+      workerThreadCount.value_or(JobSystem::DefaultWorkerCount());
+  if (const char* forced = std::getenv("ENGINE_WORKER_THREADS")) {
+    char* end;
+    const unsigned long count = std::strtoul(forced, &end, 10);
+    if (end != forced && *end == '\0') {
+      workers = static_cast<unsigned>(count);
+    } else {
+      warning("invalid ENGINE_WORKER_THREADS: " << forced);
+    }
+  }
+  jobSystem.Start(workers);
+  debug("Worker threads: " << workers);
+
   glfwSetErrorCallback(ErrorCallback);
   // Initialize the lib
   if (!glfwInit()) {
@@ -72,12 +116,46 @@ bool Engine::Engine::Initialize() {
   ui = std::make_shared<UI>();
   if (ui->Initialize(this) == false) return false;
 
+  BuildFrameGraph();
+  previousTime = glfwGetTime();
   return true;
 }
 
+void Engine::Engine::BuildFrameGraph() {
+  frameGraph.Clear();
+  const uint32_t sceneState = frameGraph.GetResource("scene");
+  const uint32_t uiState = frameGraph.GetResource("ui");
+  // ImGui and GLFW must stay on the main thread. The UI reads nothing the
+  // physics step writes, so the two overlap when physics is on a worker.
+  frameGraph.AddTask(
+      "physics", {}, {sceneState}, [this] { StepPhysics(); },
+      physicsOnWorker ? TaskAffinity::ANY_THREAD : TaskAffinity::MAIN_THREAD);
+  frameGraph.AddTask(
+      "ui", {}, {uiState}, [this] { ui->Update(); }, TaskAffinity::MAIN_THREAD);
+  frameGraph.AddTask(
+      "scene update", {}, {sceneState}, [this] { currentScene->Update(); },
+      TaskAffinity::MAIN_THREAD);
+}
+
+void Engine::Engine::StepPhysics() {
+  int steps = 0;
+  while (accumulator >= fixedTimeStep && steps < maxStepsPerFrame) {
+    currentScene->FixedUpdate(static_cast<float>(fixedTimeStep));
+    accumulator -= fixedTimeStep;
+    ++steps;
+  }
+  // Could not keep up: drop the backlog rather than carry it over.
+  if (accumulator >= fixedTimeStep)
+    accumulator = std::fmod(accumulator, fixedTimeStep);
+  interpolationAlpha = static_cast<float>(accumulator / fixedTimeStep);
+  currentScene->SetInterpolationAlpha(interpolationAlpha);
+}
+
 void Engine::Engine::Update() {
-  ui->Update();
-  currentScene->Update();
+  const double now = glfwGetTime();
+  accumulator += now - previousTime;
+  previousTime = now;
+  frameGraph.Run(jobSystem);
 }
 
 void Engine::Engine::Render() {
@@ -88,6 +166,7 @@ void Engine::Engine::Render() {
 void Engine::Engine::Exit() {
   ui->Exit();
   currentScene->Exit();
+  jobSystem.Stop();
   glfwTerminate();
 }
 
@@ -95,6 +174,22 @@ bool Engine::Engine::NeedsToCloseWindow() {
   return glfwWindowShouldClose(window);
 }
 
+void Engine::Engine::SetFixedTimeStep(double seconds) {
+  fixedTimeStep = seconds;
+}
+
+void Engine::Engine::SetMaxStepsPerFrame(int steps) {
+  maxStepsPerFrame = steps;
+}
+
+double Engine::Engine::GetFixedTimeStep() { return fixedTimeStep; }
+
+Engine::JobSystem& Engine::Engine::GetJobSystem() { return jobSystem; }
+
+Engine::TaskGraph& Engine::Engine::GetFrameGraph() { return frameGraph; }
+
+float Engine::Engine::GetInterpolationAlpha() { return interpolationAlpha; }
+
 GLFWwindow *Engine::Engine::GetWindow() { return window; }
 
 size_t Engine::Engine::GetWidth() { return width; }
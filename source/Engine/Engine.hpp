@@ -1,6 +1,7 @@
 #pragma once
 
 #include <memory>
+#include <optional>
 #include <string>
 #include <vector>
 
@@ -15,7 +16,10 @@
 #include <GLFW/glfw3.h>
 #endif
 
+#include <CpuFeatures.hpp>
+#include <JobSystem.hpp>
 #include <Scene.hpp>
+#include <TaskGraph.hpp>
 
 #include "UI.hpp"
 
@@ -32,10 +36,38 @@ class Engine {
   int framebufferHeight;
   std::string window_name = "physics Engine";
   GLFWwindow* window;
+  std::optional<math::SimdTier> forcedSimdTier;
+  std::optional<unsigned> workerThreadCount;
+  JobSystem jobSystem;
+  TaskGraph frameGraph;
+  bool physicsOnWorker = false;
+
+  // Fixed-step simulation clock, in seconds.
+  double fixedTimeStep = 1.0 / 120.0;
+  int maxStepsPerFrame = 8;
+  double previousTime = 0.0;
+  double accumulator = 0.0;
+  float interpolationAlpha = 0.0f;
+
+  // Adds the engine's own stages to the frame graph.
+  void BuildFrameGraph();
+  // Runs the fixed steps the accumulated time calls for.
+  void StepPhysics();
 
  public:
   void AddScene(std::shared_ptr<Scene> scene);
   void EnterScene(int sceneIndex);
+  // Must be called before Initialize. The ENGINE_SIMD_TIER environment
+  // variable ("scalar", "sse2", ..., "avx512") overrides it.
+  void ForceSimdTier(math::SimdTier tier);
+  // Must be called before Initialize; defaults to
+  // JobSystem::DefaultWorkerCount(). The ENGINE_WORKER_THREADS environment
+  // variable overrides it.
+  void SetWorkerThreadCount(unsigned count);
+  // Must be called before Initialize. Runs the fixed steps, and with them
+  // every GameObject::FixedUpdate, on a worker thread while the UI
+  // updates. Off by default, so gameplay code stays on the main thread.
+  void SetPhysicsOnWorkerThread(bool enabled);
   bool Initialize();
   void Update();
   void Render();
@@ -43,6 +75,25 @@ class Engine {
 
   bool NeedsToCloseWindow();
 
+  // Physics runs in steps of exactly `seconds` regardless of the frame rate.
+  void SetFixedTimeStep(double seconds);
+  // Frames that would need more steps drop the excess time instead, so a
+  // slow frame cannot snowball into ever longer ones.
+  void SetMaxStepsPerFrame(int steps);
+  double GetFixedTimeStep();
+  // Fraction of a step left over after the last Update, used to blend the
+  // last two physics states when rendering.
+  float GetInterpolationAlpha();
+
+  // Shared by every subsystem, so none starts threads of its own. Started
+  // by Initialize; scenes get it from AddScene.
+  JobSystem& GetJobSystem();
+  // Stages run by Update: "physics", writing resource "scene", alongside
+  // "ui", writing "ui", then "scene update", writing "scene". All run on
+  // the main thread, except "physics" with SetPhysicsOnWorkerThread.
+  // Stages added after Initialize declare what they read and write in the
+  // same terms and run after these where they conflict.
+  TaskGraph& GetFrameGraph();
   GLFWwindow* GetWindow();
   size_t GetWidth();
   size_t GetHeight();
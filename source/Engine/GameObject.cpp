@@ -0,0 +1,13 @@
+#include "GameObject.hpp"
+
+bool Engine::GameObject::Initialize() { return true; }
+
+void Engine::GameObject::FixedUpdate(float /*dt*/) {}
+
+void Engine::GameObject::Update() {}
+
+void Engine::GameObject::UpdateDeferred(SceneCommands& /*commands*/) {
+  Update();
+}
+
+void Engine::GameObject::Render() {}
@@ -1,14 +1,36 @@
 #pragma once
 
+#include <RigidBody.hpp>
+#include <SceneCommands.hpp>
 #include <Shader.hpp>
 #include <Transform.hpp>
 
 namespace Engine {
 class GameObject {
  private:
+  // Physics state lives in the Scene's PhysicsWorld; the object only keeps
+  // the handle to it.
+  RigidBodyHandle rigidBody;
+
  public:
+  virtual ~GameObject() = default;
   virtual bool Initialize();
+  // Called once per fixed simulation step, before physics advances, on the
+  // main thread. Engine::SetPhysicsOnWorkerThread moves the steps to a
+  // worker, running while the UI updates; this must then not call GL, GLFW
+  // or ImGui, and must guard any state it shares outside the scene.
+  virtual void FixedUpdate(float dt);
+  // Called once per rendered frame, on the main thread unless the scene
+  // updates objects in parallel.
   virtual void Update();
+  // Called by the scene once per rendered frame; calls Update() unless
+  // overridden. Changes to the scene or to other objects go in `commands`,
+  // which a scene updating objects in parallel requires (see
+  // Scene::SetParallelUpdate).
+  virtual void UpdateDeferred(SceneCommands& commands);
   virtual void Render();
+
+  void SetRigidBody(RigidBodyHandle body) { rigidBody = body; }
+  RigidBodyHandle GetRigidBody() const { return rigidBody; }
 };
 }  // namespace Engine
\ No newline at end of file
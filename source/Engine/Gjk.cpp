@@ -0,0 +1,499 @@
+#include "Gjk.hpp"
+
+#include <cmath>
+
+namespace {
+using math::Vector3;
+
+constexpr int maxGjkIterations = 64;
+// GJK stops once a new support point brings the simplex less than this
+// fraction of the squared distance closer to the origin.
+constexpr float gjkRelativeTolerance = 1e-5f;
+// Squared distance under which the shapes are taken to touch.
+constexpr float touchDistanceSquared = 1e-12f;
+
+constexpr int maxPolytopeVertices = 64;
+constexpr int maxPolytopeFaces = 2 * maxPolytopeVertices;
+constexpr float epaTolerance = 1e-4f;
+
+// A point of the Minkowski difference A - B with the shape points it came
+// from.
+struct SimplexVertex {
+  Vector3 pointA;
+  Vector3 pointB;
+  Vector3 w;
+  uint32_t indexA;
+  uint32_t indexB;
+};
+
+struct Simplex {
+  SimplexVertex vertex[4];
+  // Barycentric weights of the point closest to the origin.
+  float weight[4] = {};
+  int count = 0;
+
+  Vector3 Closest() const {
+    Vector3 v = vertex[0].w * weight[0];
+    for (int i = 1; i < count; ++i)
+      v = math::MulAdd(v, vertex[i].w, weight[i]);
+    return v;
+  }
+};
+
+struct Shapes {
+  const Engine::ConvexHull& a;
+  const Engine::Pose& poseA;
+  const Engine::ConvexHull& b;
+  const Engine::Pose& poseB;
+
+  SimplexVertex Vertex(uint32_t indexA, uint32_t indexB) const {
+    SimplexVertex v;
+    v.indexA = indexA;
+    v.indexB = indexB;
+    v.pointA = poseA.ToWorld(a.Point(indexA));
+    v.pointB = poseB.ToWorld(b.Point(indexB));
+    v.w = v.pointA - v.pointB;
+    return v;
+  }
+
+  // Support point of A - B along `direction`.
+  SimplexVertex Support(const Vector3& direction) const {
+    return Vertex(a.Support(poseA.DirectionToLocal(direction)),
+                  b.Support(poseB.DirectionToLocal(direction * -1.0f)));
+  }
+};
+
+void SetVertices(Simplex& s, const SimplexVertex& a) {
+  s.vertex[0] = a;
+  s.weight[0] = 1.0f;
+  s.count = 1;
+}
+
+void SetVertices(Simplex& s, const SimplexVertex& a, const SimplexVertex& b,
+                 float t) {
+  s.vertex[0] = a;
+  s.vertex[1] = b;
+  s.weight[0] = 1.0f - t;
+  s.weight[1] = t;
+  s.count = 2;
+}
+
+void SolveSegment(Simplex& s) {
+  const SimplexVertex a = s.vertex[0];
+  const SimplexVertex b = s.vertex[1];
+  const Vector3 ab = b.w - a.w;
+  const float lengthSquared = math::Dot(ab, ab);
+  const float t = lengthSquared > 0.0f ? -math::Dot(a.w, ab) / lengthSquared
+                                       : 0.0f;
+  if (t <= 0.0f) {
+    SetVertices(s, a);
+  } else if (t >= 1.0f) {
+    SetVertices(s, b);
+  } else {
+    SetVertices(s, a, b, t);
+  }
+}
+
+// Closest point of triangle abc to the origin by Voronoi regions, after
+// Ericson, Real-Time Collision Detection 5.1.5. Writes the smallest
+// sub-simplex holding it to `s`.
+void SolveTriangle(const SimplexVertex& a, const SimplexVertex& b,
+                   const SimplexVertex& c, Simplex& s) {
+  const Vector3 ab = b.w - a.w;
+  const Vector3 ac = c.w - a.w;
+  const float d1 = -math::Dot(ab, a.w);
+  const float d2 = -math::Dot(ac, a.w);
+  if (d1 <= 0.0f && d2 <= 0.0f) return SetVertices(s, a);
+
+  const float d3 = -math::Dot(ab, b.w);
+  const float d4 = -math::Dot(ac, b.w);
+  if (d3 >= 0.0f && d4 <= d3) return SetVertices(s, b);
+
+  const float vc = d1 * d4 - d3 * d2;
+  if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f)
+    return SetVertices(s, a, b, d1 / (d1 - d3));
+
+  const float d5 = -math::Dot(ab, c.w);
+  const float d6 = -math::Dot(ac, c.w);
+  if (d6 >= 0.0f && d5 <= d6) return SetVertices(s, c);
+
+  const float vb = d5 * d2 - d1 * d6;
+  if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f)
+    return SetVertices(s, a, c, d2 / (d2 - d6));
+
+  const float va = d3 * d6 - d5 * d4;
+  if (va <= 0.0f && d4 - d3 >= 0.0f && d5 - d6 >= 0.0f)
+    return SetVertices(s, b, c, (d4 - d3) / ((d4 - d3) + (d5 - d6)));
+
+  const float sum = va + vb + vc;
+  if (sum <= 0.0f) return SetVertices(s, a);
+  s.vertex[0] = a;
+  s.vertex[1] = b;
+  s.vertex[2] = c;
+  s.weight[1] = vb / sum;
+  s.weight[2] = vc / sum;
+  s.weight[0] = 1.0f - s.weight[1] - s.weight[2];
+  s.count = 3;
+}
+
+// True if the origin lies on the other side of plane abc than d. A flat
+// tetrahedron has every face count as facing the origin.
+bool FacesOrigin(const Vector3& a, const Vector3& b, const Vector3& c,
+                 const Vector3& d) {
+  const Vector3 n = math::Cross(b - a, c - a);
+  const float signOrigin = -math::Dot(a, n);
+  const float signD = math::Dot(d - a, n);
+  return signD == 0.0f || signOrigin * signD < 0.0f;
+}
+
+// Returns true if the origin is inside the tetrahedron; otherwise reduces
+// `s` to the closest face, edge or vertex.
+bool SolveTetrahedron(Simplex& s) {
+  const SimplexVertex v[4] = {s.vertex[0], s.vertex[1], s.vertex[2],
+                              s.vertex[3]};
+  static constexpr int faces[4][4] = {
+      {0, 1, 2, 3}, {0, 2, 3, 1}, {0, 3, 1, 2}, {1, 3, 2, 0}};
+  bool inside = true;
+  float best = INFINITY;
+  for (const auto& f : faces) {
+    if (!FacesOrigin(v[f[0]].w, v[f[1]].w, v[f[2]].w, v[f[3]].w)) continue;
+    inside = false;
+    Simplex candidate;
+    SolveTriangle(v[f[0]], v[f[1]], v[f[2]], candidate);
+    const Vector3 closest = candidate.Closest();
+    const float distance = math::Dot(closest, closest);
+    if (distance < best) {
+      best = distance;
+      s = candidate;
+    }
+  }
+  return inside;
+}
+
+// Returns true if the simplex holds the origin.
+bool Solve(Simplex& s) {
+  switch (s.count) {
+    case 1:
+      s.weight[0] = 1.0f;
+      return false;
+    case 2:
+      SolveSegment(s);
+      return false;
+    case 3: {
+      const SimplexVertex a = s.vertex[0];
+      const SimplexVertex b = s.vertex[1];
+      const SimplexVertex c = s.vertex[2];
+      SolveTriangle(a, b, c, s);
+      return false;
+    }
+    default:
+      return SolveTetrahedron(s);
+  }
+}
+
+Engine::GjkResult RunGjk(const Shapes& shapes, Engine::GjkCache* cache,
+                         Simplex& s) {
+  if (cache != nullptr && cache->count > 0) {
+    s.count = static_cast<int>(cache->count);
+    for (int i = 0; i < s.count; ++i)
+      s.vertex[i] = shapes.Vertex(cache->indexA[i], cache->indexB[i]);
+  } else {
+    s.count = 1;
+    s.vertex[0] =
+        shapes.Support(shapes.poseB.position - shapes.poseA.position);
+  }
+
+  Engine::GjkResult result;
+  result.overlap = false;
+  result.iterations = 0;
+  float previousDistanceSquared = INFINITY;
+  Simplex previous;
+  while (result.iterations < maxGjkIterations) {
+    ++result.iterations;
+    if (Solve(s)) {
+      result.overlap = true;
+      break;
+    }
+    const Vector3 v = s.Closest();
+    const float distanceSquared = math::Dot(v, v);
+    if (distanceSquared < touchDistanceSquared) {
+      result.overlap = true;
+      break;
+    }
+    // Rounding can stall the tolerance test below, e.g. between parallel
+    // faces where many support points tie, or near the origin, where a
+    // last support point can even make the simplex worse; stop once
+    // nothing improves and keep the best simplex.
+    if (distanceSquared >= previousDistanceSquared) {
+      s = previous;
+      break;
+    }
+    previousDistanceSquared = distanceSquared;
+    previous = s;
+
+    const SimplexVertex next = shapes.Support(v * -1.0f);
+    bool duplicate = false;
+    for (int i = 0; i < s.count; ++i) {
+      duplicate |= s.vertex[i].indexA == next.indexA &&
+                   s.vertex[i].indexB == next.indexB;
+    }
+    // No support point gets closer to the origin than the simplex does.
+    if (duplicate || distanceSquared - math::Dot(v, next.w) <=
+                         gjkRelativeTolerance * distanceSquared)
+      break;
+    s.vertex[s.count++] = next;
+  }
+
+  if (cache != nullptr) {
+    cache->count = static_cast<uint32_t>(s.count);
+    for (int i = 0; i < s.count; ++i) {
+      cache->indexA[i] = s.vertex[i].indexA;
+      cache->indexB[i] = s.vertex[i].indexB;
+    }
+  }
+
+  if (result.overlap) {
+    result.distance = 0.0f;
+    result.pointA = s.vertex[0].pointA;
+    result.pointB = s.vertex[0].pointB;
+  } else {
+    result.pointA = s.vertex[0].pointA * s.weight[0];
+    result.pointB = s.vertex[0].pointB * s.weight[0];
+    for (int i = 1; i < s.count; ++i) {
+      result.pointA =
+          math::MulAdd(result.pointA, s.vertex[i].pointA, s.weight[i]);
+      result.pointB =
+          math::MulAdd(result.pointB, s.vertex[i].pointB, s.weight[i]);
+    }
+    result.distance =
+        std::sqrt(math::LengthSquared(result.pointA - result.pointB));
+  }
+  return result;
+}
+
+// Grows a GJK simplex that ended touching the origin into a tetrahedron
+// around it. Returns false if the Minkowski difference is flat.
+bool BlowUp(const Shapes& shapes, Simplex& s) {
+  static const Vector3 axes[6] = {
+      Vector3(1.0f, 0.0f, 0.0f), Vector3(-1.0f, 0.0f, 0.0f),
+      Vector3(0.0f, 1.0f, 0.0f), Vector3(0.0f, -1.0f, 0.0f),
+      Vector3(0.0f, 0.0f, 1.0f), Vector3(0.0f, 0.0f, -1.0f)};
+  constexpr float epsilon = 1e-6f;
+
+  if (s.count == 1) {
+    for (const Vector3& axis : axes) {
+      const SimplexVertex p = shapes.Support(axis);
+      if (math::LengthSquared(p.w - s.vertex[0].w) > epsilon) {
+        s.vertex[s.count++] = p;
+        break;
+      }
+    }
+    if (s.count == 1) return false;
+  }
+  if (s.count == 2) {
+    const Vector3 line = s.vertex[1].w - s.vertex[0].w;
+    for (const Vector3& axis : axes) {
+      const Vector3 direction = math::Cross(line, axis);
+      if (math::LengthSquared(direction) <= epsilon) continue;
+      const SimplexVertex p = shapes.Support(direction);
+      const Vector3 offset = math::Cross(p.w - s.vertex[0].w, line);
+      if (math::LengthSquared(offset) > epsilon * math::Dot(line, line)) {
+        s.vertex[s.count++] = p;
+        break;
+      }
+    }
+    if (s.count == 2) return false;
+  }
+  if (s.count == 3) {
+    const Vector3 normal = math::Cross(s.vertex[1].w - s.vertex[0].w,
+                                       s.vertex[2].w - s.vertex[0].w);
+    for (int side = 0; side < 2; ++side) {
+      const SimplexVertex p =
+          shapes.Support(normal * (side == 0 ? 1.0f : -1.0f));
+      if (std::fabs(math::Dot(p.w - s.vertex[0].w, normal)) > epsilon) {
+        s.vertex[s.count++] = p;
+        break;
+      }
+    }
+    if (s.count == 3) return false;
+  }
+  return true;
+}
+
+struct Face {
+  int v[3];
+  Vector3 normal;
+  float distance;
+  bool alive;
+};
+
+bool MakeFace(const SimplexVertex* vertices, int a, int b, int c,
+              Face& face) {
+  const Vector3 n = math::Cross(vertices[b].w - vertices[a].w,
+                                vertices[c].w - vertices[a].w);
+  const float length = std::sqrt(math::Dot(n, n));
+  if (length <= 0.0f) return false;
+  face.v[0] = a;
+  face.v[1] = b;
+  face.v[2] = c;
+  face.normal = n * (1.0f / length);
+  face.distance = math::Dot(face.normal, vertices[a].w);
+  face.alive = true;
+  return true;
+}
+
+// Barycentric coordinates of p in triangle abc.
+void Barycentric(const Vector3& p, const Vector3& a, const Vector3& b,
+                 const Vector3& c, float out[3]) {
+  const Vector3 v0 = b - a;
+  const Vector3 v1 = c - a;
+  const Vector3 v2 = p - a;
+  const float d00 = math::Dot(v0, v0);
+  const float d01 = math::Dot(v0, v1);
+  const float d11 = math::Dot(v1, v1);
+  const float d20 = math::Dot(v2, v0);
+  const float d21 = math::Dot(v2, v1);
+  const float denominator = d00 * d11 - d01 * d01;
+  if (denominator <= 0.0f) {
+    out[0] = out[1] = out[2] = 1.0f / 3.0f;
+    return;
+  }
+  out[1] = (d11 * d20 - d01 * d21) / denominator;
+  out[2] = (d00 * d21 - d01 * d20) / denominator;
+  out[0] = 1.0f - out[1] - out[2];
+}
+}  // namespace
+
+Engine::GjkResult Engine::GjkDistance(const ConvexHull& a, const Pose& poseA,
+                                      const ConvexHull& b, const Pose& poseB,
+                                      GjkCache* cache) {
+  Simplex s;
+  return RunGjk({a, poseA, b, poseB}, cache, s);
+}
+
+bool Engine::CollideConvex(const ConvexHull& a, const Pose& poseA,
+                           const ConvexHull& b, const Pose& poseB,
+                           GjkCache* cache, ConvexContact& contact) {
+  const Shapes shapes{a, poseA, b, poseB};
+  Simplex s;
+  if (!RunGjk(shapes, cache, s).overlap) return false;
+
+  if (!BlowUp(shapes, s)) {
+    // Flat Minkowski difference: the shapes touch without depth.
+    const Vector3 offset = poseB.position - poseA.position;
+    const float length = std::sqrt(math::Dot(offset, offset));
+    contact.normal = length > 0.0f ? offset * (1.0f / length)
+                                   : Vector3(0.0f, 1.0f, 0.0f);
+    contact.depth = 0.0f;
+    contact.pointA = s.vertex[0].pointA;
+    contact.pointB = s.vertex[0].pointB;
+    return true;
+  }
+
+  // Expanding polytope, in fixed-size arrays so no query allocates.
+  SimplexVertex vertices[maxPolytopeVertices];
+  Face faces[maxPolytopeFaces];
+  int vertexCount = 4;
+  int faceCount = 0;
+  for (int i = 0; i < 4; ++i) vertices[i] = s.vertex[i];
+  // Wind the faces outwards.
+  if (math::Dot(math::Cross(vertices[1].w - vertices[0].w,
+                            vertices[2].w - vertices[0].w),
+                vertices[3].w - vertices[0].w) > 0.0f) {
+    const SimplexVertex swap = vertices[0];
+    vertices[0] = vertices[1];
+    vertices[1] = swap;
+  }
+  static constexpr int initial[4][3] = {
+      {0, 1, 2}, {0, 3, 1}, {0, 2, 3}, {1, 3, 2}};
+  for (const auto& f : initial) {
+    if (MakeFace(vertices, f[0], f[1], f[2], faces[faceCount])) ++faceCount;
+  }
+
+  struct Edge {
+    int a, b;
+  };
+  Edge horizon[3 * maxPolytopeFaces];
+  auto closestFace = [&]() {
+    int closest = -1;
+    for (int i = 0; i < faceCount; ++i) {
+      if (faces[i].alive &&
+          (closest < 0 || faces[i].distance < faces[closest].distance))
+        closest = i;
+    }
+    return closest;
+  };
+  // Closest face of the last closed polytope: what is reported, even when
+  // an expansion fails part way and leaves a hole.
+  Face face;
+  while (true) {
+    const int closest = closestFace();
+    if (closest < 0) return false;
+    face = faces[closest];
+    const SimplexVertex p = shapes.Support(face.normal);
+    const float gain = math::Dot(p.w, face.normal) - face.distance;
+    if (gain <= epaTolerance * std::fmax(1.0f, face.distance) ||
+        vertexCount == maxPolytopeVertices)
+      break;
+
+    // Remove the faces the new point sees, keeping their outline.
+    const int index = vertexCount;
+    vertices[vertexCount++] = p;
+    int edgeCount = 0;
+    for (int i = 0; i < faceCount; ++i) {
+      Face& f = faces[i];
+      if (!f.alive ||
+          math::Dot(f.normal, p.w - vertices[f.v[0]].w) <= 0.0f)
+        continue;
+      f.alive = false;
+      for (int e = 0; e < 3; ++e) {
+        const Edge edge = {f.v[e], f.v[(e + 1) % 3]};
+        // An edge shared by two removed faces is not on the outline.
+        bool shared = false;
+        for (int k = 0; k < edgeCount; ++k) {
+          if (horizon[k].a == edge.b && horizon[k].b == edge.a) {
+            horizon[k] = horizon[--edgeCount];
+            shared = true;
+            break;
+          }
+        }
+        if (!shared) horizon[edgeCount++] = edge;
+      }
+    }
+
+    // Compact the face list, then close the hole with a fan to p.
+    int alive = 0;
+    for (int i = 0; i < faceCount; ++i) {
+      if (faces[i].alive) faces[alive++] = faces[i];
+    }
+    faceCount = alive;
+    // Out of room, or a degenerate fan triangle: stop with `face`.
+    if (faceCount + edgeCount > maxPolytopeFaces) break;
+    bool closed = true;
+    for (int k = 0; k < edgeCount; ++k) {
+      if (MakeFace(vertices, horizon[k].a, horizon[k].b, index,
+                   faces[faceCount])) {
+        ++faceCount;
+      } else {
+        closed = false;
+      }
+    }
+    if (!closed) break;
+  }
+
+  const Vector3 projection = face.normal * face.distance;
+  float weights[3];
+  Barycentric(projection, vertices[face.v[0]].w, vertices[face.v[1]].w,
+              vertices[face.v[2]].w, weights);
+  contact.normal = face.normal;
+  contact.depth = face.distance;
+  contact.pointA = vertices[face.v[0]].pointA * weights[0];
+  contact.pointB = vertices[face.v[0]].pointB * weights[0];
+  for (int i = 1; i < 3; ++i) {
+    contact.pointA =
+        math::MulAdd(contact.pointA, vertices[face.v[i]].pointA, weights[i]);
+    contact.pointB =
+        math::MulAdd(contact.pointB, vertices[face.v[i]].pointB, weights[i]);
+  }
+  return true;
+}
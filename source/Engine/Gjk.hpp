@@ -0,0 +1,48 @@
+#pragma once
+
+#include <ConvexHull.hpp>
+#include <Vector3.hpp>
+#include <cstdint>
+
+namespace Engine {
+// Support point indices of the simplex GJK ended with. Kept per body pair
+// between steps, it lets the next query start from last step's answer, so
+// a resting contact converges in one or two iterations.
+struct GjkCache {
+  uint32_t count = 0;
+  uint32_t indexA[4];
+  uint32_t indexB[4];
+};
+
+struct GjkResult {
+  bool overlap;
+  // Distance between the shapes and the closest points on each, in world
+  // space; zero and unspecified when they overlap.
+  float distance;
+  math::Vector3 pointA;
+  math::Vector3 pointB;
+  int iterations;
+};
+
+// Penetration of two overlapping shapes.
+struct ConvexContact {
+  // Unit vector from A into B; moving B by normal * depth separates them.
+  math::Vector3 normal;
+  float depth;
+  // Deepest points of each shape inside the other, in world space.
+  math::Vector3 pointA;
+  math::Vector3 pointB;
+};
+
+// Distance between two convex hulls with GJK. `cache` may be null; if
+// given, it seeds the initial simplex and receives the final one.
+GjkResult GjkDistance(const ConvexHull& a, const Pose& poseA,
+                      const ConvexHull& b, const Pose& poseB,
+                      GjkCache* cache);
+
+// Penetration depth and normal of two overlapping hulls with EPA, seeded
+// from the GJK simplex. Returns false if the shapes do not overlap.
+bool CollideConvex(const ConvexHull& a, const Pose& poseA,
+                   const ConvexHull& b, const Pose& poseB, GjkCache* cache,
+                   ConvexContact& contact);
+}  // namespace Engine
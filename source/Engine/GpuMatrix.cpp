@@ -0,0 +1,31 @@
+#include "GpuMatrix.hpp"
+
+#include <cstring>
+
+math::GpuMatrix math::ToGpuMatrix(const Matrix4x4& m) {
+  GpuMatrix out;
+  std::memcpy(out.element, &m.element[0][0], sizeof(out.element));
+  return out;
+}
+
+math::GpuMatrix math::ToGpuMatrix(const Affine3x4& a) {
+  // Column c of the GL matrix is (a[0][c], a[1][c], a[2][c], c == 3).
+  GpuMatrix out;
+  for (int c = 0; c < 4; ++c) {
+    out.element[c * 4 + 0] = a.element[0][c];
+    out.element[c * 4 + 1] = a.element[1][c];
+    out.element[c * 4 + 2] = a.element[2][c];
+    out.element[c * 4 + 3] = c == 3 ? 1.0f : 0.0f;
+  }
+  return out;
+}
+
+void math::ToGpuMatrices(const Matrix4x4* in, GpuMatrix* out, size_t count) {
+  for (size_t i = 0; i < count; ++i) {
+    std::memcpy(out[i].element, &in[i].element[0][0], sizeof(out[i].element));
+  }
+}
+
+void math::ToGpuMatrices(const Affine3x4* in, GpuMatrix* out, size_t count) {
+  for (size_t i = 0; i < count; ++i) out[i] = ToGpuMatrix(in[i]);
+}
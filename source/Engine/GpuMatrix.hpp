@@ -0,0 +1,29 @@
+#pragma once
+
+#include <Affine3x4.hpp>
+#include <Matrix4x4.hpp>
+#include <cstddef>
+
+namespace math {
+// 4x4 matrix in the layout OpenGL consumes without transposing: column-major
+// storage for column-vector shaders (`transform * v`), as expected by
+// glUniformMatrix4fv(..., GL_FALSE, ...) and by std140/instance buffers.
+//
+// A Matrix4x4 is row-major and applied to row vectors (v * M). Reading its
+// memory column-major yields M^T, and M^T * v == v * M, so a Matrix4x4 can
+// be uploaded as-is; GpuMatrix exists to name that layout and to write
+// Affine3x4 transforms into it directly.
+struct alignas(16) GpuMatrix {
+  float element[16];
+};
+static_assert(sizeof(GpuMatrix) == 16 * sizeof(float),
+              "GpuMatrix must be memcpy-compatible with a GLSL mat4");
+
+// Plain copy; see above.
+GpuMatrix ToGpuMatrix(const Matrix4x4& m);
+GpuMatrix ToGpuMatrix(const Affine3x4& a);
+
+// Fill instance buffers; out may point straight into a mapped GL buffer.
+void ToGpuMatrices(const Matrix4x4* in, GpuMatrix* out, size_t count);
+void ToGpuMatrices(const Affine3x4* in, GpuMatrix* out, size_t count);
+}  // namespace math
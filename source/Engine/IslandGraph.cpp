@@ -0,0 +1,191 @@
+#include "IslandGraph.hpp"
+
+#include <algorithm>
+#include <utility>
+
+uint32_t Engine::IslandGraph::CreateIsland() {
+  uint32_t island;
+  if (freeIslands.empty()) {
+    island = static_cast<uint32_t>(islands.size());
+    islands.emplace_back();
+  } else {
+    island = freeIslands.back();
+    freeIslands.pop_back();
+  }
+  islands[island] = {island, noSlot, 0, false, 0.0f, 0.0f, 0};
+  return island;
+}
+
+uint32_t Engine::IslandGraph::FindRoot(uint32_t island) {
+  // Path halving.
+  while (islands[island].parent != island) {
+    islands[island].parent = islands[islands[island].parent].parent;
+    island = islands[island].parent;
+  }
+  return island;
+}
+
+uint32_t Engine::IslandGraph::FindSplitRoot(uint32_t slot) {
+  while (splitParent[slot] != slot) {
+    splitParent[slot] = splitParent[splitParent[slot]];
+    slot = splitParent[slot];
+  }
+  return slot;
+}
+
+void Engine::IslandGraph::Insert(uint32_t island, uint32_t slot) {
+  Island& target = islands[island];
+  islandOfSlot[slot] = island;
+  previousOfSlot[slot] = noSlot;
+  nextOfSlot[slot] = target.head;
+  if (target.head != noSlot) previousOfSlot[target.head] = slot;
+  target.head = slot;
+  ++target.size;
+}
+
+void Engine::IslandGraph::Detach(uint32_t slot) {
+  Island& island = islands[islandOfSlot[slot]];
+  const uint32_t previous = previousOfSlot[slot];
+  const uint32_t next = nextOfSlot[slot];
+  if (previous != noSlot) {
+    nextOfSlot[previous] = next;
+  } else {
+    island.head = next;
+  }
+  if (next != noSlot) previousOfSlot[next] = previous;
+  --island.size;
+  islandOfSlot[slot] = noIsland;
+}
+
+bool Engine::IslandGraph::IsMember(RigidBodyHandle body) const {
+  return body.slot < bodyOfSlot.size() && bodyOfSlot[body.slot] == body &&
+         islandOfSlot[body.slot] != noIsland;
+}
+
+void Engine::IslandGraph::AddBody(RigidBodyHandle body) {
+  if (bodyOfSlot.size() <= body.slot) {
+    const size_t size = body.slot + 1;
+    bodyOfSlot.resize(size);
+    islandOfSlot.resize(size, noIsland);
+    nextOfSlot.resize(size, noSlot);
+    previousOfSlot.resize(size, noSlot);
+    splitParent.resize(size);
+    splitIsland.resize(size);
+  }
+  bodyOfSlot[body.slot] = body;
+  Insert(CreateIsland(), body.slot);
+}
+
+void Engine::IslandGraph::RemoveBody(RigidBodyHandle body) {
+  if (!IsMember(body)) return;
+  // Islands must be roots before one can be freed.
+  MergeLinks();
+  const uint32_t island = islandOfSlot[body.slot];
+  Detach(body.slot);
+  bodyOfSlot[body.slot] = RigidBodyHandle();
+  if (islands[island].size == 0) {
+    freeIslands.push_back(island);
+  } else {
+    islands[island].needsSplit = true;
+  }
+}
+
+void Engine::IslandGraph::Clear() {
+  islands.clear();
+  freeIslands.clear();
+  linkedIslands.clear();
+  bodyOfSlot.clear();
+  islandOfSlot.clear();
+  nextOfSlot.clear();
+  previousOfSlot.clear();
+  splitParent.clear();
+  splitIsland.clear();
+}
+
+void Engine::IslandGraph::Link(RigidBodyHandle a, RigidBodyHandle b) {
+  if (!IsMember(a) || !IsMember(b)) return;
+  const uint32_t islandA = islandOfSlot[a.slot];
+  const uint32_t islandB = islandOfSlot[b.slot];
+  if (islandA == islandB) return;
+  uint32_t rootA = FindRoot(islandA);
+  uint32_t rootB = FindRoot(islandB);
+  if (rootA == rootB) return;
+  // The larger island stays the root, so fewer bodies move when merging.
+  if (islands[rootA].size < islands[rootB].size) std::swap(rootA, rootB);
+  islands[rootB].parent = rootA;
+  linkedIslands.push_back(rootB);
+}
+
+void Engine::IslandGraph::Unlink(RigidBodyHandle a, RigidBodyHandle b) {
+  if (!IsMember(a) || !IsMember(b)) return;
+  islands[islandOfSlot[a.slot]].needsSplit = true;
+}
+
+void Engine::IslandGraph::MergeLinks() {
+  // Resolve every root before any island is freed.
+  for (uint32_t island : linkedIslands)
+    islands[island].parent = FindRoot(island);
+  for (uint32_t island : linkedIslands) {
+    const uint32_t root = islands[island].parent;
+    for (uint32_t slot = islands[island].head; slot != noSlot;) {
+      const uint32_t next = nextOfSlot[slot];
+      Insert(root, slot);
+      slot = next;
+    }
+    islands[root].needsSplit |= islands[island].needsSplit;
+    freeIslands.push_back(island);
+  }
+  linkedIslands.clear();
+}
+
+uint32_t Engine::IslandGraph::GetIsland(RigidBodyHandle body) const {
+  return IsMember(body) ? islandOfSlot[body.slot] : noIsland;
+}
+
+void Engine::IslandGraph::Split(uint32_t island,
+                                const std::vector<Contact>& contacts) {
+  members.clear();
+  for (uint32_t slot = islands[island].head; slot != noSlot;
+       slot = nextOfSlot[slot]) {
+    members.push_back(slot);
+    splitParent[slot] = slot;
+    splitIsland[slot] = noIsland;
+  }
+  for (const Contact& contact : contacts) {
+    if (contact.manifold.pointCount == 0) continue;
+    const uint32_t a = contact.a.slot;
+    const uint32_t b = contact.b.slot;
+    if (!IsMember(contact.a) || !IsMember(contact.b) ||
+        islandOfSlot[a] != island || islandOfSlot[b] != island)
+      continue;
+    const uint32_t rootA = FindSplitRoot(a);
+    const uint32_t rootB = FindSplitRoot(b);
+    if (rootA != rootB) splitParent[rootA] = rootB;
+  }
+
+  // The first piece keeps the island; the others get new ones.
+  islands[island].head = noSlot;
+  islands[island].size = 0;
+  islands[island].needsSplit = false;
+  bool first = true;
+  for (uint32_t slot : members) {
+    const uint32_t root = FindSplitRoot(slot);
+    if (splitIsland[root] == noIsland) {
+      splitIsland[root] = first ? island : CreateIsland();
+      first = false;
+    }
+    Insert(splitIsland[root], slot);
+  }
+}
+
+bool Engine::IslandGraph::ReportSleepTime(uint32_t island, float seconds) {
+  Island& target = islands[island];
+  if (target.sleepCheck != sleepCheck) {
+    target.sleepCheck = sleepCheck;
+    target.minSleepTime = target.maxSleepTime = seconds;
+    return true;
+  }
+  target.minSleepTime = std::min(target.minSleepTime, seconds);
+  target.maxSleepTime = std::max(target.maxSleepTime, seconds);
+  return false;
+}
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <ContactCache.hpp>
+#include <RigidBody.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Engine {
+// Islands of dynamic bodies linked by touching contacts, kept from step to
+// step so that a pile falls asleep and wakes as a whole. Static bodies
+// belong to no island. New links merge islands incrementally, with
+// union-find over island ids resolved once per step by MergeLinks. Lost
+// links only flag the island; it is split when one of its bodies is ready
+// to sleep, so the cost is paid once instead of every step.
+class IslandGraph {
+ public:
+  static constexpr uint32_t noIsland = 0xFFFFFFFFu;
+
+ private:
+  static constexpr uint32_t noSlot = 0xFFFFFFFFu;
+
+  struct Island {
+    // Union-find parent, the island itself for a root.
+    uint32_t parent;
+    // First member; the rest follow through nextOfSlot.
+    uint32_t head;
+    uint32_t size;
+    // Some link inside was lost, so the island may be in pieces.
+    bool needsSplit;
+    // Over the awake members, gathered by ReportSleepTime.
+    float minSleepTime;
+    float maxSleepTime;
+    uint32_t sleepCheck;
+  };
+
+  std::vector<Island> islands;
+  std::vector<uint32_t> freeIslands;
+  // Islands given a parent since the last MergeLinks.
+  std::vector<uint32_t> linkedIslands;
+  // Per body slot; a slot holds no body while its handle is invalid.
+  std::vector<RigidBodyHandle> bodyOfSlot;
+  std::vector<uint32_t> islandOfSlot;
+  std::vector<uint32_t> nextOfSlot;
+  std::vector<uint32_t> previousOfSlot;
+  // Scratch for Split, per slot.
+  std::vector<uint32_t> splitParent;
+  std::vector<uint32_t> splitIsland;
+  std::vector<uint32_t> members;
+  uint32_t sleepCheck = 0;
+
+  uint32_t CreateIsland();
+  uint32_t FindRoot(uint32_t island);
+  uint32_t FindSplitRoot(uint32_t slot);
+  void Insert(uint32_t island, uint32_t slot);
+  void Detach(uint32_t slot);
+  bool IsMember(RigidBodyHandle body) const;
+
+ public:
+  // Adds a dynamic body as an island of its own.
+  void AddBody(RigidBodyHandle body);
+  // Does nothing for bodies that are not members.
+  void RemoveBody(RigidBodyHandle body);
+  void Clear();
+
+  // A touching contact between two members. Their islands are merged by
+  // the next MergeLinks.
+  void Link(RigidBodyHandle a, RigidBodyHandle b);
+  // A contact between two members stopped touching.
+  void Unlink(RigidBodyHandle a, RigidBodyHandle b);
+  void MergeLinks();
+
+  // noIsland for bodies that are not members.
+  uint32_t GetIsland(RigidBodyHandle body) const;
+  bool NeedsSplit(uint32_t island) const {
+    return islands[island].needsSplit;
+  }
+  template <typename Visit>
+  void ForEachBody(uint32_t island, Visit&& visit) const {
+    for (uint32_t slot = islands[island].head; slot != noSlot;
+         slot = nextOfSlot[slot])
+      visit(bodyOfSlot[slot]);
+  }
+  // Rebuilds the island from the touching contacts among its members; each
+  // connected piece becomes an island. Walks all of `contacts`.
+  void Split(uint32_t island, const std::vector<Contact>& contacts);
+
+  // Starts gathering sleep times; islands not reported to since hold stale
+  // values.
+  void BeginSleepCheck() { ++sleepCheck; }
+  // Folds one awake member's sleep time into its island. Returns true the
+  // first time the island is reported in this check.
+  bool ReportSleepTime(uint32_t island, float seconds);
+  // Of the awake members reported in this check.
+  float GetMinSleepTime(uint32_t island) const {
+    return islands[island].minSleepTime;
+  }
+  float GetMaxSleepTime(uint32_t island) const {
+    return islands[island].maxSleepTime;
+  }
+  size_t GetIslandCount() const { return islands.size() - freeIslands.size(); }
+};
+}  // namespace Engine
@@ -0,0 +1,199 @@
+#include "JobSystem.hpp"
+
+#include <utility>
+
+namespace {
+// The pool the current thread works for, and its deque there.
+thread_local const Engine::JobSystem* currentSystem = nullptr;
+thread_local unsigned currentQueue = 0;
+
+// Failed attempts to find a job before a worker goes to sleep.
+constexpr int spinCount = 64;
+}  // namespace
+
+Engine::JobSystem::JobSystem() { queues.push_back(std::make_unique<Queue>()); }
+
+void Engine::JobSystem::Start(unsigned workerCount) {
+  Stop();
+  for (unsigned i = 0; i < workerCount; ++i)
+    queues.push_back(std::make_unique<Queue>());
+  currentSystem = this;
+  currentQueue = 0;
+  workers.reserve(workerCount);
+  for (unsigned i = 1; i <= workerCount; ++i)
+    workers.emplace_back(&JobSystem::WorkerLoop, this, i);
+}
+
+void Engine::JobSystem::Stop() {
+  if (workers.empty()) return;
+  {
+    std::lock_guard<std::mutex> lock(sleepMutex);
+    stopping = true;
+  }
+  wake.notify_all();
+  for (std::thread& worker : workers) worker.join();
+  workers.clear();
+  // Keep jobs the workers left behind, so their counters can still reach
+  // zero: the next Wait runs them on this thread.
+  std::deque<Job>& own = queues[0]->jobs;
+  for (size_t i = 1; i < queues.size(); ++i) {
+    for (Job& job : queues[i]->jobs) own.push_back(std::move(job));
+  }
+  queues.resize(1);
+  stopping = false;
+}
+
+unsigned Engine::JobSystem::DefaultWorkerCount() {
+  const unsigned hardware = std::thread::hardware_concurrency();
+  return hardware > 1 ? hardware - 1 : 0;
+}
+
+unsigned Engine::JobSystem::CurrentQueue() const {
+  return currentSystem == this ? currentQueue : 0;
+}
+
+void Engine::JobSystem::Push(unsigned queue, Job job) {
+  // Counted first, so the count is never below the jobs a thief can find.
+  ++queuedJobs;
+  {
+    std::lock_guard<std::mutex> lock(queues[queue]->mutex);
+    queues[queue]->jobs.push_back(std::move(job));
+  }
+  // Taking the lock orders this with a worker between checking for jobs
+  // and going to sleep, so the wake-up is not lost.
+  if (sleepingWorkers > 0) {
+    { std::lock_guard<std::mutex> lock(sleepMutex); }
+    wake.notify_one();
+  }
+}
+
+bool Engine::JobSystem::Pop(unsigned queue, Job& job) {
+  Queue& own = *queues[queue];
+  std::lock_guard<std::mutex> lock(own.mutex);
+  if (own.jobs.empty()) return false;
+  job = std::move(own.jobs.back());
+  own.jobs.pop_back();
+  --queuedJobs;
+  return true;
+}
+
+bool Engine::JobSystem::Steal(unsigned thief, Job& job) {
+  const unsigned count = static_cast<unsigned>(queues.size());
+  for (unsigned i = 1; i < count; ++i) {
+    Queue& victim = *queues[(thief + i) % count];
+    std::lock_guard<std::mutex> lock(victim.mutex);
+    if (victim.jobs.empty()) continue;
+    job = std::move(victim.jobs.front());
+    victim.jobs.pop_front();
+    --queuedJobs;
+    return true;
+  }
+  return false;
+}
+
+bool Engine::JobSystem::RunOne(unsigned queue) {
+  if (queuedJobs == 0) return false;
+  Job job;
+  if (!Pop(queue, job) && !Steal(queue, job)) return false;
+  Execute(queue, job);
+  return true;
+}
+
+void Engine::JobSystem::Execute(unsigned queue, Job& job) {
+  if (job.loop != nullptr) {
+    RunRange(queue, *job.loop, job.begin, job.end, *job.counter);
+  } else {
+    job.function();
+  }
+  Finish(job.counter);
+}
+
+void Engine::JobSystem::Finish(JobCounter* counter) {
+  if (counter == nullptr) return;
+  std::vector<Job> ready;
+  {
+    std::lock_guard<std::mutex> lock(counter->mutex);
+    if (counter->pending.fetch_sub(1, std::memory_order_acq_rel) == 1)
+      ready.swap(counter->continuations);
+  }
+  // The counter may be gone from here on.
+  const unsigned queue = CurrentQueue();
+  for (Job& job : ready) Push(queue, std::move(job));
+}
+
+void Engine::JobSystem::RunRange(unsigned queue, const RangeLoop& loop,
+                                 size_t begin, size_t end,
+                                 JobCounter& counter) {
+  // Hand the upper half to the deque until the rest is one grain, so
+  // thieves take big slices and the owner keeps the small ones.
+  while (end - begin > loop.grain) {
+    const size_t middle = begin + (end - begin) / 2;
+    Job half;
+    half.loop = &loop;
+    half.begin = middle;
+    half.end = end;
+    half.counter = &counter;
+    counter.pending.fetch_add(1, std::memory_order_relaxed);
+    Push(queue, std::move(half));
+    end = middle;
+  }
+  loop.invoke(loop.body, begin, end);
+}
+
+void Engine::JobSystem::Run(std::function<void()> job, JobCounter* counter) {
+  if (counter != nullptr)
+    counter->pending.fetch_add(1, std::memory_order_relaxed);
+  Job queued;
+  queued.function = std::move(job);
+  queued.counter = counter;
+  Push(CurrentQueue(), std::move(queued));
+}
+
+void Engine::JobSystem::ContinueWith(JobCounter& after,
+                                     std::function<void()> job,
+                                     JobCounter* counter) {
+  if (counter != nullptr)
+    counter->pending.fetch_add(1, std::memory_order_relaxed);
+  Job queued;
+  queued.function = std::move(job);
+  queued.counter = counter;
+  {
+    std::lock_guard<std::mutex> lock(after.mutex);
+    if (after.pending.load(std::memory_order_acquire) > 0) {
+      after.continuations.push_back(std::move(queued));
+      return;
+    }
+  }
+  Push(CurrentQueue(), std::move(queued));
+}
+
+void Engine::JobSystem::Wait(JobCounter& counter) {
+  const unsigned queue = CurrentQueue();
+  while (!counter.IsDone()) {
+    if (!RunOne(queue)) std::this_thread::yield();
+  }
+  // The last job lowers the counter under its lock; once we hold it, that
+  // job is done with the counter and the caller may destroy it.
+  std::lock_guard<std::mutex> lock(counter.mutex);
+}
+
+void Engine::JobSystem::WorkerLoop(unsigned queue) {
+  currentSystem = this;
+  currentQueue = queue;
+  int idle = 0;
+  while (!stopping) {
+    if (RunOne(queue)) {
+      idle = 0;
+      continue;
+    }
+    if (++idle < spinCount) {
+      std::this_thread::yield();
+      continue;
+    }
+    idle = 0;
+    std::unique_lock<std::mutex> lock(sleepMutex);
+    ++sleepingWorkers;
+    wake.wait(lock, [&] { return stopping || queuedJobs > 0; });
+    --sleepingWorkers;
+  }
+}
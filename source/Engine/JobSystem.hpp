@@ -0,0 +1,156 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace Engine {
+class JobCounter;
+
+// One ParallelFor call: the loop body, type-erased, and the size below
+// which a range is not split further.
+struct RangeLoop {
+  void (*invoke)(void* body, size_t begin, size_t end);
+  void* body;
+  size_t grain;
+};
+
+// A queued unit of work: a plain function, or a slice of a ParallelFor.
+struct Job {
+  std::function<void()> function;
+  const RangeLoop* loop = nullptr;
+  size_t begin = 0;
+  size_t end = 0;
+  // Lowered when the job is done; may be null.
+  JobCounter* counter = nullptr;
+};
+
+// Counts the unfinished jobs of a group. Jobs given a counter raise it
+// when queued and lower it when done; continuations added with
+// JobSystem::ContinueWith are queued once it drops to zero. A counter must
+// outlive its jobs and continuations: wait on it before it goes away.
+class JobCounter {
+ private:
+  friend class JobSystem;
+
+  std::atomic<uint32_t> pending{0};
+  // Taken to lower `pending` and to add continuations, so none is lost
+  // and Wait can tell when the last job is done with the counter.
+  std::mutex mutex;
+  std::vector<Job> continuations;
+
+ public:
+  bool IsDone() const { return pending.load(std::memory_order_acquire) == 0; }
+};
+
+// Work-stealing thread pool, one per Engine, shared by every subsystem so
+// none has to start threads of its own. Each thread has a deque of jobs:
+// it takes its newest job first, while idle threads steal the oldest ones
+// of others, which for a ParallelFor are the largest slices. Deques are
+// guarded by a mutex each, so a lock is only contended when a thread
+// steals. Idle workers spin briefly, then sleep until a job is queued.
+//
+// The thread that calls Start is thread 0 and joins in while it waits;
+// other threads may queue jobs and wait too, through thread 0's deque.
+// Without workers, jobs run on the waiting thread and ParallelFor runs
+// the whole range in place.
+class JobSystem {
+ private:
+  struct Queue {
+    std::mutex mutex;
+    std::deque<Job> jobs;
+  };
+
+  // Slices per thread that ParallelFor aims for when no grain is given:
+  // enough for stealing to even out uneven work.
+  static constexpr size_t slicesPerThread = 8;
+
+  std::vector<std::unique_ptr<Queue>> queues;
+  std::vector<std::thread> workers;
+  std::atomic<size_t> queuedJobs{0};
+  std::atomic<unsigned> sleepingWorkers{0};
+  std::atomic<bool> stopping{false};
+  std::mutex sleepMutex;
+  std::condition_variable wake;
+
+  unsigned CurrentQueue() const;
+  void Push(unsigned queue, Job job);
+  bool Pop(unsigned queue, Job& job);
+  bool Steal(unsigned thief, Job& job);
+  // Runs one job from the thread's own deque or stolen from another.
+  // Returns false if there was none.
+  bool RunOne(unsigned queue);
+  void Execute(unsigned queue, Job& job);
+  void Finish(JobCounter* counter);
+  void RunRange(unsigned queue, const RangeLoop& loop, size_t begin,
+                size_t end, JobCounter& counter);
+  void WorkerLoop(unsigned queue);
+
+ public:
+  JobSystem();
+  JobSystem(const JobSystem&) = delete;
+  JobSystem& operator=(const JobSystem&) = delete;
+  ~JobSystem() { Stop(); }
+
+  // Starts `workerCount` threads besides the calling one.
+  void Start(unsigned workerCount);
+  // Joins the workers. Jobs still queued move to the calling thread's
+  // deque and run when it next waits.
+  void Stop();
+  // Hardware threads less the caller's, so the pool does not
+  // oversubscribe the machine.
+  static unsigned DefaultWorkerCount();
+  // Workers plus the thread that waits.
+  unsigned GetThreadCount() const {
+    return static_cast<unsigned>(workers.size()) + 1;
+  }
+
+  // Queues `job`. `counter`, if given, is raised now and lowered when the
+  // job is done.
+  void Run(std::function<void()> job, JobCounter* counter = nullptr);
+  // Queues `job` once `after` drops to zero, or now if it is zero already.
+  // `counter` is raised now, so waiting on it waits for the continuation.
+  void ContinueWith(JobCounter& after, std::function<void()> job,
+                    JobCounter* counter = nullptr);
+  // Returns once `counter` is zero, running queued jobs meanwhile.
+  void Wait(JobCounter& counter);
+
+  // Calls body(first, last) on disjoint slices covering [begin, end), in
+  // parallel, and returns when all are done. Ranges are halved on demand
+  // down to `grain` elements; 0 picks a grain that gives each thread
+  // about slicesPerThread slices.
+  template <typename Body>
+  void ParallelFor(size_t begin, size_t end, Body&& body, size_t grain = 0);
+};
+
+template <typename Body>
+void JobSystem::ParallelFor(size_t begin, size_t end, Body&& body,
+                            size_t grain) {
+  if (begin >= end) return;
+  const size_t count = end - begin;
+  if (grain == 0)
+    grain = std::max<size_t>(1, count / (slicesPerThread * GetThreadCount()));
+  if (workers.empty() || count <= grain) {
+    body(begin, end);
+    return;
+  }
+  using Function = std::remove_reference_t<Body>;
+  const RangeLoop loop = {
+      [](void* function, size_t first, size_t last) {
+        (*static_cast<Function*>(function))(first, last);
+      },
+      const_cast<void*>(static_cast<const void*>(&body)), grain};
+  JobCounter counter;
+  RunRange(CurrentQueue(), loop, begin, end, counter);
+  Wait(counter);
+}
+}  // namespace Engine
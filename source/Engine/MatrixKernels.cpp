@@ -0,0 +1,467 @@
+#include "MatrixKernels.hpp"
+
+#include "CpuFeatures.hpp"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || \
+    defined(_M_IX86)
+#define MATH_KERNELS_X86 1
+#include <immintrin.h>
+#endif
+
+#if defined(MATH_KERNELS_X86) && (defined(__GNUC__) || defined(__clang__))
+#define MATH_TARGET_AVX __attribute__((target("avx")))
+#else
+#define MATH_TARGET_AVX
+#endif
+
+namespace {
+struct Kernels {
+  void (*multiply)(const float* lhs, const float* rhs, float* out);
+  void (*transpose)(const float* m, float* out);
+  void (*transformVectors)(const float* m, const float* in, float* out,
+                           size_t count);
+  void (*inverse)(const float* m, float* out);
+  void (*inverseAffine)(const float* m, float* out);
+  void (*inverseRigid)(const float* m, float* out);
+  const char* name;
+};
+
+void MultiplyScalar(const float* lhs, const float* rhs, float* out) {
+  float result[16];
+  for (int i = 0; i < 4; ++i) {
+    for (int j = 0; j < 4; ++j) {
+      result[i * 4 + j] = lhs[i * 4 + 0] * rhs[0 * 4 + j] +
+                          lhs[i * 4 + 1] * rhs[1 * 4 + j] +
+                          lhs[i * 4 + 2] * rhs[2 * 4 + j] +
+                          lhs[i * 4 + 3] * rhs[3 * 4 + j];
+    }
+  }
+  for (int i = 0; i < 16; ++i) out[i] = result[i];
+}
+
+void TransposeScalar(const float* m, float* out) {
+  float result[16];
+  for (int i = 0; i < 4; ++i) {
+    for (int j = 0; j < 4; ++j) result[j * 4 + i] = m[i * 4 + j];
+  }
+  for (int i = 0; i < 16; ++i) out[i] = result[i];
+}
+
+void TransformVectorsScalar(const float* m, const float* in, float* out,
+                            size_t count) {
+  for (size_t n = 0; n < count; ++n) {
+    const float x = in[n * 4 + 0], y = in[n * 4 + 1], z = in[n * 4 + 2],
+                w = in[n * 4 + 3];
+    for (int j = 0; j < 4; ++j) {
+      out[n * 4 + j] = x * m[0 * 4 + j] + y * m[1 * 4 + j] +
+                       z * m[2 * 4 + j] + w * m[3 * 4 + j];
+    }
+  }
+}
+
+void InverseScalar(const float* m, float* out) {
+  // 2x2 sub-determinants of the top two and bottom two rows.
+  const float s0 = m[0] * m[5] - m[4] * m[1];
+  const float s1 = m[0] * m[6] - m[4] * m[2];
+  const float s2 = m[0] * m[7] - m[4] * m[3];
+  const float s3 = m[1] * m[6] - m[5] * m[2];
+  const float s4 = m[1] * m[7] - m[5] * m[3];
+  const float s5 = m[2] * m[7] - m[6] * m[3];
+  const float c5 = m[10] * m[15] - m[14] * m[11];
+  const float c4 = m[9] * m[15] - m[13] * m[11];
+  const float c3 = m[9] * m[14] - m[13] * m[10];
+  const float c2 = m[8] * m[15] - m[12] * m[11];
+  const float c1 = m[8] * m[14] - m[12] * m[10];
+  const float c0 = m[8] * m[13] - m[12] * m[9];
+  const float invDet =
+      1.0f / (s0 * c5 - s1 * c4 + s2 * c3 + s3 * c2 - s4 * c1 + s5 * c0);
+
+  float result[16];
+  result[0] = (m[5] * c5 - m[6] * c4 + m[7] * c3) * invDet;
+  result[1] = (-m[1] * c5 + m[2] * c4 - m[3] * c3) * invDet;
+  result[2] = (m[13] * s5 - m[14] * s4 + m[15] * s3) * invDet;
+  result[3] = (-m[9] * s5 + m[10] * s4 - m[11] * s3) * invDet;
+  result[4] = (-m[4] * c5 + m[6] * c2 - m[7] * c1) * invDet;
+  result[5] = (m[0] * c5 - m[2] * c2 + m[3] * c1) * invDet;
+  result[6] = (-m[12] * s5 + m[14] * s2 - m[15] * s1) * invDet;
+  result[7] = (m[8] * s5 - m[10] * s2 + m[11] * s1) * invDet;
+  result[8] = (m[4] * c4 - m[5] * c2 + m[7] * c0) * invDet;
+  result[9] = (-m[0] * c4 + m[1] * c2 - m[3] * c0) * invDet;
+  result[10] = (m[12] * s4 - m[13] * s2 + m[15] * s0) * invDet;
+  result[11] = (-m[8] * s4 + m[9] * s2 - m[11] * s0) * invDet;
+  result[12] = (-m[4] * c3 + m[5] * c1 - m[6] * c0) * invDet;
+  result[13] = (m[0] * c3 - m[1] * c1 + m[2] * c0) * invDet;
+  result[14] = (-m[12] * s3 + m[13] * s1 - m[14] * s0) * invDet;
+  result[15] = (m[8] * s3 - m[9] * s1 + m[10] * s0) * invDet;
+  for (int i = 0; i < 16; ++i) out[i] = result[i];
+}
+
+void InverseAffineScalar(const float* m, float* out) {
+  // Inverse of the linear block by cofactors...
+  const float c00 = m[5] * m[10] - m[6] * m[9];
+  const float c01 = m[6] * m[8] - m[4] * m[10];
+  const float c02 = m[4] * m[9] - m[5] * m[8];
+  const float invDet = 1.0f / (m[0] * c00 + m[1] * c01 + m[2] * c02);
+
+  float result[16];
+  result[0] = c00 * invDet;
+  result[4] = c01 * invDet;
+  result[8] = c02 * invDet;
+  result[1] = (m[2] * m[9] - m[1] * m[10]) * invDet;
+  result[5] = (m[0] * m[10] - m[2] * m[8]) * invDet;
+  result[9] = (m[1] * m[8] - m[0] * m[9]) * invDet;
+  result[2] = (m[1] * m[6] - m[2] * m[5]) * invDet;
+  result[6] = (m[2] * m[4] - m[0] * m[6]) * invDet;
+  result[10] = (m[0] * m[5] - m[1] * m[4]) * invDet;
+  // ...and the translation row becomes -t * inverse(linear).
+  for (int c = 0; c < 3; ++c) {
+    result[12 + c] = -(m[12] * result[c] + m[13] * result[4 + c] +
+                       m[14] * result[8 + c]);
+  }
+  result[3] = result[7] = result[11] = 0.0f;
+  result[15] = 1.0f;
+  for (int i = 0; i < 16; ++i) out[i] = result[i];
+}
+
+void InverseRigidScalar(const float* m, float* out) {
+  float result[16];
+  for (int r = 0; r < 3; ++r) {
+    for (int c = 0; c < 3; ++c) result[r * 4 + c] = m[c * 4 + r];
+    result[r * 4 + 3] = 0.0f;
+  }
+  for (int c = 0; c < 3; ++c) {
+    result[12 + c] =
+        -(m[12] * m[c * 4] + m[13] * m[c * 4 + 1] + m[14] * m[c * 4 + 2]);
+  }
+  result[15] = 1.0f;
+  for (int i = 0; i < 16; ++i) out[i] = result[i];
+}
+
+#ifdef MATH_KERNELS_X86
+// Row i of the product is lhs[i][0] * rhs.row0 + ... + lhs[i][3] * rhs.row3,
+// so every row is four broadcasts and four multiply-adds.
+inline __m128 CombineRowsSSE(__m128 a, __m128 b0, __m128 b1, __m128 b2,
+                             __m128 b3) {
+  __m128 r = _mm_mul_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(0, 0, 0, 0)), b0);
+  r = _mm_add_ps(r, _mm_mul_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(1, 1, 1, 1)),
+                               b1));
+  r = _mm_add_ps(r, _mm_mul_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(2, 2, 2, 2)),
+                               b2));
+  r = _mm_add_ps(r, _mm_mul_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 3, 3, 3)),
+                               b3));
+  return r;
+}
+
+void MultiplySSE(const float* lhs, const float* rhs, float* out) {
+  const __m128 b0 = _mm_loadu_ps(rhs + 0);
+  const __m128 b1 = _mm_loadu_ps(rhs + 4);
+  const __m128 b2 = _mm_loadu_ps(rhs + 8);
+  const __m128 b3 = _mm_loadu_ps(rhs + 12);
+  for (int i = 0; i < 4; ++i) {
+    _mm_storeu_ps(out + i * 4,
+                  CombineRowsSSE(_mm_loadu_ps(lhs + i * 4), b0, b1, b2, b3));
+  }
+}
+
+void TransposeSSE(const float* m, float* out) {
+  __m128 r0 = _mm_loadu_ps(m + 0);
+  __m128 r1 = _mm_loadu_ps(m + 4);
+  __m128 r2 = _mm_loadu_ps(m + 8);
+  __m128 r3 = _mm_loadu_ps(m + 12);
+  _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+  _mm_storeu_ps(out + 0, r0);
+  _mm_storeu_ps(out + 4, r1);
+  _mm_storeu_ps(out + 8, r2);
+  _mm_storeu_ps(out + 12, r3);
+}
+
+void TransformVectorsSSE(const float* m, const float* in, float* out,
+                         size_t count) {
+  const __m128 m0 = _mm_loadu_ps(m + 0);
+  const __m128 m1 = _mm_loadu_ps(m + 4);
+  const __m128 m2 = _mm_loadu_ps(m + 8);
+  const __m128 m3 = _mm_loadu_ps(m + 12);
+  for (size_t n = 0; n < count; ++n) {
+    _mm_storeu_ps(out + n * 4,
+                  CombineRowsSSE(_mm_loadu_ps(in + n * 4), m0, m1, m2, m3));
+  }
+}
+
+// Shuffle helpers for the inverse kernels, written in lane order (x, y, z, w).
+#define KERNEL_MASK(x, y, z, w) _MM_SHUFFLE(w, z, y, x)
+#define KERNEL_SWIZZLE(v, x, y, z, w) \
+  _mm_shuffle_ps(v, v, KERNEL_MASK(x, y, z, w))
+
+// Each 2x2 block is packed row-major into one register: (m00, m01, m10, m11).
+// A * B
+inline __m128 Mat2Mul(__m128 a, __m128 b) {
+  return _mm_add_ps(
+      _mm_mul_ps(a, KERNEL_SWIZZLE(b, 0, 3, 0, 3)),
+      _mm_mul_ps(KERNEL_SWIZZLE(a, 1, 0, 3, 2), KERNEL_SWIZZLE(b, 2, 1, 2, 1)));
+}
+
+// adj(A) * B
+inline __m128 Mat2AdjMul(__m128 a, __m128 b) {
+  return _mm_sub_ps(
+      _mm_mul_ps(KERNEL_SWIZZLE(a, 3, 3, 0, 0), b),
+      _mm_mul_ps(KERNEL_SWIZZLE(a, 1, 1, 2, 2), KERNEL_SWIZZLE(b, 2, 3, 0, 1)));
+}
+
+// A * adj(B)
+inline __m128 Mat2MulAdj(__m128 a, __m128 b) {
+  return _mm_sub_ps(
+      _mm_mul_ps(a, KERNEL_SWIZZLE(b, 3, 0, 3, 0)),
+      _mm_mul_ps(KERNEL_SWIZZLE(a, 1, 0, 3, 2), KERNEL_SWIZZLE(b, 2, 1, 2, 1)));
+}
+
+// Block inverse of M = [A B; C D] with 2x2 blocks, entirely in registers:
+// the adjugate blocks are
+//   X = |D|A - B adj(D)C,    W = |A|D - C adj(A)B,
+//   Y = |B|C - D adj(adj(A)B),  Z = |C|B - A adj(adj(D)C),
+// and |M| = |A||D| + |B||C| - tr(adj(A)B adj(D)C).
+void InverseSSE(const float* m, float* out) {
+  const __m128 r0 = _mm_loadu_ps(m + 0);
+  const __m128 r1 = _mm_loadu_ps(m + 4);
+  const __m128 r2 = _mm_loadu_ps(m + 8);
+  const __m128 r3 = _mm_loadu_ps(m + 12);
+
+  const __m128 a = _mm_movelh_ps(r0, r1);
+  const __m128 b = _mm_movehl_ps(r1, r0);
+  const __m128 c = _mm_movelh_ps(r2, r3);
+  const __m128 d = _mm_movehl_ps(r3, r2);
+
+  // (|A|, |B|, |C|, |D|)
+  const __m128 detSub = _mm_sub_ps(
+      _mm_mul_ps(_mm_shuffle_ps(r0, r2, KERNEL_MASK(0, 2, 0, 2)),
+                 _mm_shuffle_ps(r1, r3, KERNEL_MASK(1, 3, 1, 3))),
+      _mm_mul_ps(_mm_shuffle_ps(r0, r2, KERNEL_MASK(1, 3, 1, 3)),
+                 _mm_shuffle_ps(r1, r3, KERNEL_MASK(0, 2, 0, 2))));
+  const __m128 detA = KERNEL_SWIZZLE(detSub, 0, 0, 0, 0);
+  const __m128 detB = KERNEL_SWIZZLE(detSub, 1, 1, 1, 1);
+  const __m128 detC = KERNEL_SWIZZLE(detSub, 2, 2, 2, 2);
+  const __m128 detD = KERNEL_SWIZZLE(detSub, 3, 3, 3, 3);
+
+  const __m128 dc = Mat2AdjMul(d, c);
+  const __m128 ab = Mat2AdjMul(a, b);
+  __m128 x = _mm_sub_ps(_mm_mul_ps(detD, a), Mat2Mul(b, dc));
+  __m128 w = _mm_sub_ps(_mm_mul_ps(detA, d), Mat2Mul(c, ab));
+  __m128 y = _mm_sub_ps(_mm_mul_ps(detB, c), Mat2MulAdj(d, ab));
+  __m128 z = _mm_sub_ps(_mm_mul_ps(detC, b), Mat2MulAdj(a, dc));
+
+  __m128 trace = _mm_mul_ps(ab, KERNEL_SWIZZLE(dc, 0, 2, 1, 3));
+  trace = _mm_add_ps(trace, KERNEL_SWIZZLE(trace, 2, 3, 0, 1));
+  trace = _mm_add_ps(trace, KERNEL_SWIZZLE(trace, 1, 0, 3, 2));
+  const __m128 detM = _mm_sub_ps(
+      _mm_add_ps(_mm_mul_ps(detA, detD), _mm_mul_ps(detB, detC)), trace);
+
+  // The adjugate of a 2x2 block swaps the diagonal and negates the rest;
+  // the swap is folded into the final shuffles, the sign into 1/|M|.
+  const __m128 invDet = _mm_div_ps(_mm_setr_ps(1.0f, -1.0f, -1.0f, 1.0f), detM);
+  x = _mm_mul_ps(x, invDet);
+  y = _mm_mul_ps(y, invDet);
+  z = _mm_mul_ps(z, invDet);
+  w = _mm_mul_ps(w, invDet);
+
+  _mm_storeu_ps(out + 0, _mm_shuffle_ps(x, y, KERNEL_MASK(3, 1, 3, 1)));
+  _mm_storeu_ps(out + 4, _mm_shuffle_ps(x, y, KERNEL_MASK(2, 0, 2, 0)));
+  _mm_storeu_ps(out + 8, _mm_shuffle_ps(z, w, KERNEL_MASK(3, 1, 3, 1)));
+  _mm_storeu_ps(out + 12, _mm_shuffle_ps(z, w, KERNEL_MASK(2, 0, 2, 0)));
+}
+
+// Both affine inverses share the tail: the inverse linear block is the
+// transpose of `l0..l2` (whose w lanes are dropped), and the translation row
+// is (0, 0, 0, 1) - t * inverse(linear).
+inline void StoreAffineInverseSSE(__m128 l0, __m128 l1, __m128 l2, __m128 t,
+                                  float* out) {
+  __m128 l3 = _mm_setzero_ps();
+  _MM_TRANSPOSE4_PS(l0, l1, l2, l3);
+  __m128 translation = _mm_mul_ps(KERNEL_SWIZZLE(t, 0, 0, 0, 0), l0);
+  translation = _mm_add_ps(
+      translation, _mm_mul_ps(KERNEL_SWIZZLE(t, 1, 1, 1, 1), l1));
+  translation = _mm_add_ps(
+      translation, _mm_mul_ps(KERNEL_SWIZZLE(t, 2, 2, 2, 2), l2));
+  _mm_storeu_ps(out + 0, l0);
+  _mm_storeu_ps(out + 4, l1);
+  _mm_storeu_ps(out + 8, l2);
+  _mm_storeu_ps(out + 12,
+                _mm_sub_ps(_mm_setr_ps(0.0f, 0.0f, 0.0f, 1.0f), translation));
+}
+
+// a x b in the xyz lanes; w is zero when both w lanes are.
+inline __m128 CrossSSE(__m128 a, __m128 b) {
+  return _mm_sub_ps(
+      _mm_mul_ps(KERNEL_SWIZZLE(a, 1, 2, 0, 3), KERNEL_SWIZZLE(b, 2, 0, 1, 3)),
+      _mm_mul_ps(KERNEL_SWIZZLE(a, 2, 0, 1, 3), KERNEL_SWIZZLE(b, 1, 2, 0, 3)));
+}
+
+// With linear rows a, b, c the columns of the inverse are b x c, c x a and
+// a x b over a . (b x c), so the cofactors are three cross products. The w
+// lanes are cleared so that they stay out of the determinant.
+void InverseAffineSSE(const float* m, float* out) {
+  const __m128 xyz = _mm_castsi128_ps(_mm_setr_epi32(-1, -1, -1, 0));
+  const __m128 a = _mm_and_ps(_mm_loadu_ps(m + 0), xyz);
+  const __m128 b = _mm_and_ps(_mm_loadu_ps(m + 4), xyz);
+  const __m128 c = _mm_and_ps(_mm_loadu_ps(m + 8), xyz);
+  const __m128 bc = CrossSSE(b, c);
+  const __m128 ca = CrossSSE(c, a);
+  const __m128 ab = CrossSSE(a, b);
+
+  __m128 det = _mm_mul_ps(a, bc);
+  det = _mm_add_ps(det, KERNEL_SWIZZLE(det, 1, 0, 3, 2));
+  det = _mm_add_ps(det, KERNEL_SWIZZLE(det, 2, 3, 0, 1));
+  const __m128 invDet = _mm_div_ps(_mm_set1_ps(1.0f), det);
+  StoreAffineInverseSSE(_mm_mul_ps(bc, invDet), _mm_mul_ps(ca, invDet),
+                        _mm_mul_ps(ab, invDet), _mm_loadu_ps(m + 12), out);
+}
+
+// The inverse of an orthonormal block is its transpose, so the only
+// arithmetic left is -t * R^T.
+void InverseRigidSSE(const float* m, float* out) {
+  StoreAffineInverseSSE(_mm_loadu_ps(m + 0), _mm_loadu_ps(m + 4),
+                        _mm_loadu_ps(m + 8), _mm_loadu_ps(m + 12), out);
+}
+
+#undef KERNEL_SWIZZLE
+#undef KERNEL_MASK
+
+// The AVX versions work on two rows (or two vectors) per register: the rhs
+// rows are duplicated into both 128-bit lanes and _mm256_shuffle_ps
+// broadcasts within each lane independently.
+MATH_TARGET_AVX inline __m256 LoadRowTwiceAVX(const float* row) {
+  return _mm256_broadcast_ps(reinterpret_cast<const __m128*>(row));
+}
+
+MATH_TARGET_AVX inline __m256 CombineRowsAVX(__m256 a, __m256 b0, __m256 b1,
+                                             __m256 b2, __m256 b3) {
+  __m256 r = _mm256_mul_ps(_mm256_shuffle_ps(a, a, 0x00), b0);
+  r = _mm256_add_ps(r, _mm256_mul_ps(_mm256_shuffle_ps(a, a, 0x55), b1));
+  r = _mm256_add_ps(r, _mm256_mul_ps(_mm256_shuffle_ps(a, a, 0xAA), b2));
+  r = _mm256_add_ps(r, _mm256_mul_ps(_mm256_shuffle_ps(a, a, 0xFF), b3));
+  return r;
+}
+
+MATH_TARGET_AVX void MultiplyAVX(const float* lhs, const float* rhs,
+                                 float* out) {
+  const __m256 b0 = LoadRowTwiceAVX(rhs + 0);
+  const __m256 b1 = LoadRowTwiceAVX(rhs + 4);
+  const __m256 b2 = LoadRowTwiceAVX(rhs + 8);
+  const __m256 b3 = LoadRowTwiceAVX(rhs + 12);
+  const __m256 r01 = CombineRowsAVX(_mm256_loadu_ps(lhs + 0), b0, b1, b2, b3);
+  const __m256 r23 = CombineRowsAVX(_mm256_loadu_ps(lhs + 8), b0, b1, b2, b3);
+  _mm256_storeu_ps(out + 0, r01);
+  _mm256_storeu_ps(out + 8, r23);
+}
+
+MATH_TARGET_AVX void TransformVectorsAVX(const float* m, const float* in,
+                                         float* out, size_t count) {
+  const __m256 m0 = LoadRowTwiceAVX(m + 0);
+  const __m256 m1 = LoadRowTwiceAVX(m + 4);
+  const __m256 m2 = LoadRowTwiceAVX(m + 8);
+  const __m256 m3 = LoadRowTwiceAVX(m + 12);
+  size_t n = 0;
+  for (; n + 2 <= count; n += 2) {
+    _mm256_storeu_ps(out + n * 4, CombineRowsAVX(_mm256_loadu_ps(in + n * 4),
+                                                 m0, m1, m2, m3));
+  }
+  if (n < count) TransformVectorsSSE(m, in + n * 4, out + n * 4, count - n);
+}
+
+#endif
+
+Kernels SelectKernels(math::SimdTier tier) {
+#ifdef MATH_KERNELS_X86
+  // There are no kernels wider than AVX; AVX2 and AVX-512 hosts use them.
+  if (tier >= math::SimdTier::AVX)
+    return {MultiplyAVX, TransposeSSE, TransformVectorsAVX, InverseSSE,
+            InverseAffineSSE, InverseRigidSSE, "avx"};
+  if (tier >= math::SimdTier::SSE2)
+    return {MultiplySSE, TransposeSSE, TransformVectorsSSE, InverseSSE,
+            InverseAffineSSE, InverseRigidSSE, "sse"};
+#endif
+  return {MultiplyScalar, TransposeScalar, TransformVectorsScalar,
+          InverseScalar, InverseAffineScalar, InverseRigidScalar, "scalar"};
+}
+
+Kernels& GetKernels() {
+  static Kernels kernels = SelectKernels(math::GetSimdTier());
+  return kernels;
+}
+}  // namespace
+
+void math::detail::BindMatrixKernels(SimdTier tier) {
+  GetKernels() = SelectKernels(tier);
+}
+
+void math::Multiply(const Matrix4x4& lhs, const Matrix4x4& rhs,
+                    Matrix4x4& out) {
+  GetKernels().multiply(&lhs.element[0][0], &rhs.element[0][0],
+                        &out.element[0][0]);
+}
+
+math::Matrix4x4 math::Multiply(const Matrix4x4& lhs, const Matrix4x4& rhs) {
+  Matrix4x4 out;
+  Multiply(lhs, rhs, out);
+  return out;
+}
+
+void math::Transpose(const Matrix4x4& m, Matrix4x4& out) {
+  GetKernels().transpose(&m.element[0][0], &out.element[0][0]);
+}
+
+math::Matrix4x4 math::Transpose(const Matrix4x4& m) {
+  Matrix4x4 out;
+  Transpose(m, out);
+  return out;
+}
+
+void math::TransformVectors(const Matrix4x4& m, const float* in, float* out,
+                            size_t count) {
+  GetKernels().transformVectors(&m.element[0][0], in, out, count);
+}
+
+void math::TransformPoints(const Matrix4x4& m, const Vector3* in, Vector3* out,
+                           size_t count) {
+  // Points are staged through a small xyzw buffer so the packed kernel can
+  // be reused without assuming anything about Vector3's padding.
+  constexpr size_t batch = 64;
+  float staging[batch * 4];
+  const auto& kernels = GetKernels();
+  for (size_t base = 0; base < count; base += batch) {
+    const size_t n = count - base < batch ? count - base : batch;
+    for (size_t i = 0; i < n; ++i) {
+      staging[i * 4 + 0] = in[base + i].x;
+      staging[i * 4 + 1] = in[base + i].y;
+      staging[i * 4 + 2] = in[base + i].z;
+      staging[i * 4 + 3] = 1.0f;
+    }
+    kernels.transformVectors(&m.element[0][0], staging, staging, n);
+    for (size_t i = 0; i < n; ++i) {
+      out[base + i] =
+          Vector3(staging[i * 4 + 0], staging[i * 4 + 1], staging[i * 4 + 2]);
+    }
+  }
+}
+
+void math::Inverse(const Matrix4x4& m, Matrix4x4& out) {
+  GetKernels().inverse(&m.element[0][0], &out.element[0][0]);
+}
+
+math::Matrix4x4 math::Inverse(const Matrix4x4& m) {
+  Matrix4x4 out;
+  Inverse(m, out);
+  return out;
+}
+
+math::Matrix4x4 math::InverseAffine(const Matrix4x4& m) {
+  Matrix4x4 out;
+  GetKernels().inverseAffine(&m.element[0][0], &out.element[0][0]);
+  return out;
+}
+
+math::Matrix4x4 math::InverseRigid(const Matrix4x4& m) {
+  Matrix4x4 out;
+  GetKernels().inverseRigid(&m.element[0][0], &out.element[0][0]);
+  return out;
+}
+
+const char* math::MatrixKernelName() { return GetKernels().name; }
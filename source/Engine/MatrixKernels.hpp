@@ -0,0 +1,44 @@
+#pragma once
+
+#include <Matrix4x4.hpp>
+#include <Vector3.hpp>
+#include <cstddef>
+
+// SIMD versions of the hot Matrix4x4 operations. Matrices are row-major and
+// vectors are row vectors (v * M), exactly like Matrix4x4::operator*, so the
+// results are interchangeable with the scalar path. The implementation (AVX,
+// SSE or plain scalar) follows the active SIMD tier, see CpuFeatures.hpp.
+namespace math {
+// out = lhs * rhs. out may alias lhs or rhs.
+void Multiply(const Matrix4x4& lhs, const Matrix4x4& rhs, Matrix4x4& out);
+Matrix4x4 Multiply(const Matrix4x4& lhs, const Matrix4x4& rhs);
+
+// out = transpose(m). out may alias m.
+void Transpose(const Matrix4x4& m, Matrix4x4& out);
+Matrix4x4 Transpose(const Matrix4x4& m);
+
+// Transforms `count` packed (x, y, z, w) vectors: out[i] = in[i] * m.
+// in and out may be the same buffer.
+void TransformVectors(const Matrix4x4& m, const float* in, float* out,
+                      size_t count);
+
+// Transforms `count` points with an implicit w = 1 and keeps xyz of the
+// result (no perspective divide). in and out may be the same buffer.
+void TransformPoints(const Matrix4x4& m, const Vector3* in, Vector3* out,
+                     size_t count);
+
+// out = inverse(m) for any invertible m (cofactors in 2x2 blocks with SSE).
+// out may alias m. A singular m yields non-finite values.
+void Inverse(const Matrix4x4& m, Matrix4x4& out);
+Matrix4x4 Inverse(const Matrix4x4& m);
+
+// Inverses for matrices whose last column is (0, 0, 0, 1). They only invert
+// the 3x3 linear block, which keeps them accurate for large translations.
+// InverseAffine handles any invertible linear block; InverseRigid only
+// rotation + translation and just transposes the rotation.
+Matrix4x4 InverseAffine(const Matrix4x4& m);
+Matrix4x4 InverseRigid(const Matrix4x4& m);
+
+// Name of the implementation in use ("avx", "sse" or "scalar").
+const char* MatrixKernelName();
+}  // namespace math
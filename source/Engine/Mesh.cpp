@@ -1,15 +1,26 @@
 #include "Mesh.hpp"
 
 #include <iostream>
+#include <iterator>
+
+namespace {
+// Unit cube used until model loading exists.
+constexpr float cubePositions[8][3] = {
+    {-.5f, -.5f, .5f},  {-.5f, .5f, .5f},  {.5f, .5f, .5f},
+    {.5f, -.5f, .5f},   {-.5f, -.5f, -.5f}, {-.5f, .5f, -.5f},
+    {.5f, .5f, -.5f},   {.5f, -.5f, -.5f}};
+static_assert(sizeof(cubePositions) == 8 * 3 * sizeof(float),
+              "the vertex buffer is uploaded as tightly packed xyz");
+constexpr unsigned int cubeIndices[] = {0, 2, 1, 0, 3, 2, 4, 3, 0, 4, 7, 3,
+                                        4, 1, 5, 4, 0, 1, 3, 6, 2, 3, 7, 6,
+                                        1, 6, 5, 1, 2, 6, 7, 5, 6, 7, 4, 5};
+static_assert(std::size(cubeIndices) % 3 == 0,
+              "cube indices must describe whole triangles");
+}  // namespace
+
 bool Engine::Mesh::Initialize(const std::string& fileName) {
-  vertices.push_back({math::Vector3(-.5f, -.5f, .5f)});
-  vertices.push_back({math::Vector3(-.5f, .5f, .5f)});
-  vertices.push_back({math::Vector3(.5f, .5f, .5f)});
-  vertices.push_back({math::Vector3(.5f, -.5f, .5f)});
-  vertices.push_back({math::Vector3(-.5f, -.5f, -.5f)});
-  vertices.push_back({math::Vector3(-.5f, .5f, -.5f)});
-  vertices.push_back({math::Vector3(.5f, .5f, -.5f)});
-  vertices.push_back({math::Vector3(.5f, -.5f, -.5f)});
+  for (const auto& p : cubePositions)
+    vertices.push_back({math::Vector3(p[0], p[1], p[2])});
 
   // Vertex Buffer Object = VBO
   glGenBuffers(1, &vertexBufferObject);
@@ -21,7 +32,7 @@ bool Engine::Mesh::Initialize(const std::string& fileName) {
     return false;
   }
   glBindBuffer(GL_ARRAY_BUFFER, vertexBufferObject);
-  glBufferData(GL_ARRAY_BUFFER, 8 * 3 * sizeof(float), vertices.data(),
+  glBufferData(GL_ARRAY_BUFFER, sizeof(cubePositions), vertices.data(),
                GL_STATIC_DRAW | GL_MAP_READ_BIT);
 
   // Vertex Arrays Object = VAO
@@ -35,14 +46,12 @@ bool Engine::Mesh::Initialize(const std::string& fileName) {
 
   glBindBuffer(GL_ARRAY_BUFFER, 0);
 
-  indices = std::vector<unsigned int>({0, 2, 1, 0, 3, 2, 4, 3, 0, 4, 7, 3,
-                                       4, 1, 5, 4, 0, 1, 3, 6, 2, 3, 7, 6,
-                                       1, 6, 5, 1, 2, 6, 7, 5, 6, 7, 4, 5});
+  indices.assign(std::begin(cubeIndices), std::end(cubeIndices));
 
   glGenBuffers(1, &elementBuffer);
   glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, elementBuffer);
-  glBufferData(GL_ELEMENT_ARRAY_BUFFER, 36 * sizeof(unsigned int),
-               indices.data(), GL_STATIC_DRAW);
+  glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(cubeIndices), indices.data(),
+               GL_STATIC_DRAW);
   /* END OF DRAWING */
 
   return true;
@@ -60,4 +69,9 @@ void Engine::Mesh::Exit() {
   glDeleteBuffers(1, &vertexBufferObject);
   glDeleteVertexArrays(1, &vertexArraysObject);
   glDeleteBuffers(1, &elementBuffer);
+}
+
+Engine::ConvexHull Engine::Mesh::GetConvexHull() const {
+  if (vertices.empty()) return ConvexHull();
+  return ConvexHull(&vertices[0].position, vertices.size(), sizeof(Vertex));
 }
\ No newline at end of file
@@ -11,6 +11,7 @@
 #include <GLFW/glfw3.h>
 #endif
 
+#include <ConvexHull.hpp>
 #include <Vector3.hpp>
 #include <string>
 #include <vector>
@@ -33,5 +34,9 @@ class Mesh {
   bool Initialize(const std::string& fileName);
   void Render();
   void Exit();
+
+  // Collision view of the vertices kept after upload. It points into the
+  // mesh, so it is valid until the mesh is initialized again or destroyed.
+  ConvexHull GetConvexHull() const;
 };
 }  // namespace Engine
\ No newline at end of file
@@ -0,0 +1,99 @@
+#include "PairSet.hpp"
+
+#include <utility>
+
+namespace {
+constexpr uint64_t emptyKey = ~uint64_t(0);
+constexpr size_t noSlot = ~size_t(0);
+
+uint64_t MakeKey(uint32_t a, uint32_t b) {
+  if (a > b) std::swap(a, b);
+  return (uint64_t(a) << 32) | b;
+}
+
+// splitmix64 finalizer: consecutive ids land far apart.
+size_t Hash(uint64_t key) {
+  key ^= key >> 30;
+  key *= 0xBF58476D1CE4E5B9ull;
+  key ^= key >> 27;
+  key *= 0x94D049BB133111EBull;
+  key ^= key >> 31;
+  return static_cast<size_t>(key);
+}
+}  // namespace
+
+size_t Engine::PairSet::Find(uint64_t key) const {
+  if (slots.empty()) return noSlot;
+  for (size_t i = Hash(key) & mask;; i = (i + 1) & mask) {
+    if (slots[i].key == key) return i;
+    if (slots[i].key == emptyKey) return noSlot;
+  }
+}
+
+void Engine::PairSet::Grow() {
+  const size_t capacity = slots.empty() ? 64 : slots.size() * 2;
+  slots.assign(capacity, Slot{emptyKey, 0});
+  mask = capacity - 1;
+  for (uint32_t index = 0; index < pairs.size(); ++index) {
+    const uint64_t key = MakeKey(pairs[index].a, pairs[index].b);
+    size_t i = Hash(key) & mask;
+    while (slots[i].key != emptyKey) i = (i + 1) & mask;
+    slots[i] = {key, index};
+  }
+}
+
+bool Engine::PairSet::Insert(uint32_t a, uint32_t b) {
+  // Keep the load factor at or below one half.
+  if ((pairs.size() + 1) * 2 > slots.size()) Grow();
+  const uint64_t key = MakeKey(a, b);
+  size_t i = Hash(key) & mask;
+  for (; slots[i].key != emptyKey; i = (i + 1) & mask) {
+    if (slots[i].key == key) return false;
+  }
+  slots[i] = {key, static_cast<uint32_t>(pairs.size())};
+  pairs.push_back(
+      {static_cast<uint32_t>(key >> 32), static_cast<uint32_t>(key)});
+  return true;
+}
+
+bool Engine::PairSet::Erase(uint32_t a, uint32_t b) {
+  size_t hole = Find(MakeKey(a, b));
+  if (hole == noSlot) return false;
+
+  // Swap-remove from the dense array and repoint the moved pair's slot.
+  const uint32_t index = slots[hole].index;
+  const BroadphasePair last = pairs.back();
+  pairs[index] = last;
+  pairs.pop_back();
+  if (index < pairs.size()) slots[Find(MakeKey(last.a, last.b))].index = index;
+
+  // Backward-shift deletion: pull later members of the probe run into the
+  // hole so lookups never need tombstones.
+  for (size_t i = (hole + 1) & mask; slots[i].key != emptyKey;
+       i = (i + 1) & mask) {
+    const size_t home = Hash(slots[i].key) & mask;
+    // Move the entry unless its home lies cyclically in (hole, i].
+    const bool movable = hole <= i ? (home <= hole || home > i)
+                                   : (home <= hole && home > i);
+    if (movable) {
+      slots[hole] = slots[i];
+      hole = i;
+    }
+  }
+  slots[hole].key = emptyKey;
+  return true;
+}
+
+bool Engine::PairSet::Contains(uint32_t a, uint32_t b) const {
+  return Find(MakeKey(a, b)) != noSlot;
+}
+
+uint32_t Engine::PairSet::IndexOf(uint32_t a, uint32_t b) const {
+  const size_t i = Find(MakeKey(a, b));
+  return i == noSlot ? notFound : slots[i].index;
+}
+
+void Engine::PairSet::Clear() {
+  for (Slot& slot : slots) slot.key = emptyKey;
+  pairs.clear();
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Engine {
+// Unordered pair of broadphase proxies, stored with a < b.
+struct BroadphasePair {
+  uint32_t a;
+  uint32_t b;
+};
+
+// Set of proxy pairs with O(1) insert, erase and lookup, plus a dense array
+// of its members for iteration. Open addressing with linear probing and
+// backward-shift deletion; memory is only allocated when the set outgrows
+// its largest size so far.
+class PairSet {
+ private:
+  struct Slot {
+    uint64_t key;
+    // Position of the pair in `pairs`.
+    uint32_t index;
+  };
+
+  std::vector<Slot> slots;
+  std::vector<BroadphasePair> pairs;
+  size_t mask = 0;
+
+  size_t Find(uint64_t key) const;
+  void Grow();
+
+ public:
+  // Both return false if nothing changed. The order of a and b is ignored.
+  bool Insert(uint32_t a, uint32_t b);
+  bool Erase(uint32_t a, uint32_t b);
+  bool Contains(uint32_t a, uint32_t b) const;
+  // Position of the pair in GetPairs(), or notFound. Insert appends and
+  // Erase moves the last pair into the hole, so callers can keep arrays
+  // parallel to GetPairs().
+  static constexpr uint32_t notFound = 0xFFFFFFFFu;
+  uint32_t IndexOf(uint32_t a, uint32_t b) const;
+  void Clear();
+
+  size_t Size() const { return pairs.size(); }
+  // In no particular order; invalidated by Insert and Erase.
+  const std::vector<BroadphasePair>& GetPairs() const { return pairs; }
+};
+}  // namespace Engine
@@ -0,0 +1,548 @@
+#include "PhysicsWorld.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+#include "BatchKernels.hpp"
+#include "VectorOps.hpp"
+
+namespace {
+using Buffer = math::Vector3Batch::Buffer;
+
+float Reciprocal(float value) { return value > 0.0f ? 1.0f / value : 0.0f; }
+
+template <typename Array>
+void SwapRemove(Array& buffer, size_t i) {
+  buffer[i] = buffer.back();
+  buffer.pop_back();
+}
+
+template <typename Array>
+void Swap(Array& buffer, size_t i, size_t j) {
+  std::swap(buffer[i], buffer[j]);
+}
+
+void Swap(math::Vector3Batch& batch, size_t i, size_t j) {
+  const math::Vector3 v = batch.Get(i);
+  batch.Set(i, batch.Get(j));
+  batch.Set(j, v);
+}
+
+// The first `count` vectors.
+void Zero(math::Vector3Batch& batch, size_t count) {
+  std::fill_n(batch.X(), count, 0.0f);
+  std::fill_n(batch.Y(), count, 0.0f);
+  std::fill_n(batch.Z(), count, 0.0f);
+}
+
+void Scale(math::Vector3Batch& batch, float s, size_t count) {
+  float* x = batch.X();
+  float* y = batch.Y();
+  float* z = batch.Z();
+  for (size_t i = 0; i < count; ++i) {
+    x[i] *= s;
+    y[i] *= s;
+    z[i] *= s;
+  }
+}
+
+// v[i] += (g * hasMass[i] + f[i] * invMass[i]) * dt for one component.
+void AccumulateForces(float* v, const float* f, const float* inverseMasses,
+                      float g, float dt, size_t count) {
+  for (size_t i = 0; i < count; ++i) {
+    const float gravity = inverseMasses[i] > 0.0f ? g : 0.0f;
+    v[i] += (gravity + f[i] * inverseMasses[i]) * dt;
+  }
+}
+
+// Box around a rotated box: the rotated center plus the extents projected
+// through the absolute rotation matrix.
+math::Aabb TransformBounds(const math::Quaternion& q,
+                           const math::Vector3& position,
+                           const math::Vector3& center,
+                           const math::Vector3& extents) {
+  const float xx = q.x * q.x, yy = q.y * q.y, zz = q.z * q.z;
+  const float xy = q.x * q.y, xz = q.x * q.z, yz = q.y * q.z;
+  const float wx = q.w * q.x, wy = q.w * q.y, wz = q.w * q.z;
+  const math::Vector3 half(
+      std::fabs(1.0f - 2.0f * (yy + zz)) * extents.x +
+          std::fabs(2.0f * (xy - wz)) * extents.y +
+          std::fabs(2.0f * (xz + wy)) * extents.z,
+      std::fabs(2.0f * (xy + wz)) * extents.x +
+          std::fabs(1.0f - 2.0f * (xx + zz)) * extents.y +
+          std::fabs(2.0f * (yz - wx)) * extents.z,
+      std::fabs(2.0f * (xz - wy)) * extents.x +
+          std::fabs(2.0f * (yz + wx)) * extents.y +
+          std::fabs(1.0f - 2.0f * (xx + yy)) * extents.z);
+  const math::Vector3 c = position + q.Rotate(center);
+  return {c - half, c + half};
+}
+}  // namespace
+
+Engine::RigidBodyHandle Engine::PhysicsWorld::CreateBody(
+    const RigidBodyDesc& desc) {
+  const uint32_t index = static_cast<uint32_t>(positions.Size());
+  uint32_t slot;
+  if (freeSlots.empty()) {
+    slot = static_cast<uint32_t>(indexOfSlot.size());
+    indexOfSlot.push_back(index);
+    generationOfSlot.push_back(1);
+  } else {
+    slot = freeSlots.back();
+    freeSlots.pop_back();
+    indexOfSlot[slot] = index;
+  }
+  slotOfIndex.push_back(slot);
+
+  const math::Quaternion q = desc.orientation.Normalized();
+  positions.PushBack(desc.position);
+  orientationX.push_back(q.x);
+  orientationY.push_back(q.y);
+  orientationZ.push_back(q.z);
+  orientationW.push_back(q.w);
+  previousPositions.PushBack(desc.position);
+  previousX.push_back(q.x);
+  previousY.push_back(q.y);
+  previousZ.push_back(q.z);
+  previousW.push_back(q.w);
+  const float inverseMass = Reciprocal(desc.mass);
+  const bool dynamic = inverseMass > 0.0f;
+  const math::Vector3 zero(0.0f, 0.0f, 0.0f);
+  linearVelocities.PushBack(dynamic ? desc.linearVelocity : zero);
+  angularVelocities.PushBack(dynamic ? desc.angularVelocity : zero);
+  forces.PushBack(zero);
+  torques.PushBack(zero);
+  inverseMasses.push_back(inverseMass);
+  inverseInertias.PushBack(
+      dynamic ? math::Vector3(Reciprocal(desc.inertia.x),
+                              Reciprocal(desc.inertia.y),
+                              Reciprocal(desc.inertia.z))
+              : zero);
+  const math::Aabb bounds = desc.collider.LocalBounds();
+  localCenters.PushBack(bounds.Center());
+  localExtents.PushBack(bounds.Extents());
+  colliders.push_back(desc.collider);
+  sleepTimes.push_back(0.0f);
+  SwapBodies(index, awakeCount++);
+  const RigidBodyHandle body = {slot, generationOfSlot[slot]};
+  if (desc.continuous && dynamic) continuousBodies.push_back(body);
+  return body;
+}
+
+void Engine::PhysicsWorld::DestroyBody(RigidBodyHandle body) {
+  if (!IsAlive(body)) return;
+  uint32_t index = indexOfSlot[body.slot];
+  const uint32_t last = static_cast<uint32_t>(positions.Size() - 1);
+  // Keep the awake bodies in front: the last awake one fills the hole.
+  if (index < awakeCount) {
+    SwapBodies(index, --awakeCount);
+    index = awakeCount;
+  }
+
+  positions.SwapRemove(index);
+  SwapRemove(orientationX, index);
+  SwapRemove(orientationY, index);
+  SwapRemove(orientationZ, index);
+  SwapRemove(orientationW, index);
+  previousPositions.SwapRemove(index);
+  SwapRemove(previousX, index);
+  SwapRemove(previousY, index);
+  SwapRemove(previousZ, index);
+  SwapRemove(previousW, index);
+  linearVelocities.SwapRemove(index);
+  angularVelocities.SwapRemove(index);
+  forces.SwapRemove(index);
+  torques.SwapRemove(index);
+  SwapRemove(inverseMasses, index);
+  inverseInertias.SwapRemove(index);
+  localCenters.SwapRemove(index);
+  localExtents.SwapRemove(index);
+  SwapRemove(colliders, index);
+  SwapRemove(sleepTimes, index);
+  SetContinuous(body, false);
+
+  // The last body now lives at `index`.
+  const uint32_t movedSlot = slotOfIndex[last];
+  slotOfIndex[index] = movedSlot;
+  indexOfSlot[movedSlot] = index;
+  slotOfIndex.pop_back();
+
+  indexOfSlot[body.slot] = RigidBodyHandle::invalidSlot;
+  ++generationOfSlot[body.slot];
+  freeSlots.push_back(body.slot);
+}
+
+bool Engine::PhysicsWorld::IsAlive(RigidBodyHandle body) const {
+  return body.slot < indexOfSlot.size() &&
+         generationOfSlot[body.slot] == body.generation &&
+         indexOfSlot[body.slot] != RigidBodyHandle::invalidSlot;
+}
+
+void Engine::PhysicsWorld::SwapBodies(uint32_t i, uint32_t j) {
+  if (i == j) return;
+  Swap(positions, i, j);
+  Swap(orientationX, i, j);
+  Swap(orientationY, i, j);
+  Swap(orientationZ, i, j);
+  Swap(orientationW, i, j);
+  Swap(previousPositions, i, j);
+  Swap(previousX, i, j);
+  Swap(previousY, i, j);
+  Swap(previousZ, i, j);
+  Swap(previousW, i, j);
+  Swap(linearVelocities, i, j);
+  Swap(angularVelocities, i, j);
+  Swap(forces, i, j);
+  Swap(torques, i, j);
+  Swap(inverseMasses, i, j);
+  Swap(inverseInertias, i, j);
+  Swap(localCenters, i, j);
+  Swap(localExtents, i, j);
+  Swap(colliders, i, j);
+  Swap(sleepTimes, i, j);
+  Swap(slotOfIndex, i, j);
+  indexOfSlot[slotOfIndex[i]] = i;
+  indexOfSlot[slotOfIndex[j]] = j;
+}
+
+bool Engine::PhysicsWorld::IsAwake(RigidBodyHandle body) const {
+  return GetIndex(body) < awakeCount;
+}
+
+void Engine::PhysicsWorld::SetAwake(RigidBodyHandle body, bool awake) {
+  if (awake) {
+    Wake(body);
+    return;
+  }
+  const uint32_t index = GetIndex(body);
+  if (index >= awakeCount) return;
+  SwapBodies(index, --awakeCount);
+  const uint32_t i = awakeCount;
+  const math::Vector3 zero(0.0f, 0.0f, 0.0f);
+  linearVelocities.Set(i, zero);
+  angularVelocities.Set(i, zero);
+  forces.Set(i, zero);
+  torques.Set(i, zero);
+  // Rendered at rest, not replaying the last step.
+  previousPositions.Set(i, positions.Get(i));
+  previousX[i] = orientationX[i];
+  previousY[i] = orientationY[i];
+  previousZ[i] = orientationZ[i];
+  previousW[i] = orientationW[i];
+}
+
+void Engine::PhysicsWorld::SetContinuous(RigidBodyHandle body,
+                                         bool continuous) {
+  const auto it =
+      std::find(continuousBodies.begin(), continuousBodies.end(), body);
+  if (!continuous) {
+    if (it == continuousBodies.end()) return;
+    *it = continuousBodies.back();
+    continuousBodies.pop_back();
+  } else if (it == continuousBodies.end() && GetInverseMass(body) > 0.0f) {
+    continuousBodies.push_back(body);
+  }
+}
+
+bool Engine::PhysicsWorld::IsContinuous(RigidBodyHandle body) const {
+  return std::find(continuousBodies.begin(), continuousBodies.end(), body) !=
+         continuousBodies.end();
+}
+
+bool Engine::PhysicsWorld::ComputeSweep(RigidBodyHandle body, float dt,
+                                        math::Vector3& displacement) const {
+  const uint32_t i = GetIndex(body);
+  displacement = linearVelocities.Get(i) * dt;
+  const math::Vector3 extents = localExtents.Get(i);
+  const float thickness = std::min(extents.x, std::min(extents.y, extents.z));
+  return math::LengthSquared(displacement) > thickness * thickness;
+}
+
+uint32_t Engine::PhysicsWorld::Wake(RigidBodyHandle body) {
+  const uint32_t index = GetIndex(body);
+  if (index < awakeCount) return index;
+  SwapBodies(index, awakeCount);
+  sleepTimes[awakeCount] = 0.0f;
+  return awakeCount++;
+}
+
+void Engine::PhysicsWorld::Clear() {
+  // Destroying every body keeps the generations, so old handles stay dead.
+  while (!slotOfIndex.empty()) DestroyBody(GetHandle(0));
+}
+
+math::Vector3 Engine::PhysicsWorld::GetPosition(RigidBodyHandle body) const {
+  return positions.Get(GetIndex(body));
+}
+
+void Engine::PhysicsWorld::SetPosition(RigidBodyHandle body,
+                                       const math::Vector3& position) {
+  const uint32_t i = Wake(body);
+  positions.Set(i, position);
+  previousPositions.Set(i, position);
+}
+
+math::Quaternion Engine::PhysicsWorld::GetOrientation(
+    RigidBodyHandle body) const {
+  const uint32_t i = GetIndex(body);
+  return math::Quaternion(orientationX[i], orientationY[i], orientationZ[i],
+                          orientationW[i]);
+}
+
+void Engine::PhysicsWorld::SetOrientation(RigidBodyHandle body,
+                                          const math::Quaternion& q) {
+  const uint32_t i = Wake(body);
+  const math::Quaternion n = q.Normalized();
+  orientationX[i] = n.x;
+  orientationY[i] = n.y;
+  orientationZ[i] = n.z;
+  orientationW[i] = n.w;
+  previousX[i] = n.x;
+  previousY[i] = n.y;
+  previousZ[i] = n.z;
+  previousW[i] = n.w;
+}
+
+math::Vector3 Engine::PhysicsWorld::GetLinearVelocity(
+    RigidBodyHandle body) const {
+  return linearVelocities.Get(GetIndex(body));
+}
+
+void Engine::PhysicsWorld::SetLinearVelocity(RigidBodyHandle body,
+                                             const math::Vector3& v) {
+  linearVelocities.Set(Wake(body), v);
+}
+
+math::Vector3 Engine::PhysicsWorld::GetAngularVelocity(
+    RigidBodyHandle body) const {
+  return angularVelocities.Get(GetIndex(body));
+}
+
+void Engine::PhysicsWorld::SetAngularVelocity(RigidBodyHandle body,
+                                              const math::Vector3& w) {
+  angularVelocities.Set(Wake(body), w);
+}
+
+float Engine::PhysicsWorld::GetInverseMass(RigidBodyHandle body) const {
+  return inverseMasses[GetIndex(body)];
+}
+
+math::Affine3x4 Engine::PhysicsWorld::GetTransform(RigidBodyHandle body) const {
+  return GetOrientation(body).ToAffine3x4(GetPosition(body));
+}
+
+const Engine::Collider& Engine::PhysicsWorld::GetCollider(
+    RigidBodyHandle body) const {
+  return colliders[GetIndex(body)];
+}
+
+Engine::Pose Engine::PhysicsWorld::GetPose(RigidBodyHandle body) const {
+  Pose pose;
+  pose.position = GetPosition(body);
+  pose.orientation = GetOrientation(body);
+  return pose;
+}
+
+math::Aabb Engine::PhysicsWorld::GetWorldBounds(RigidBodyHandle body) const {
+  const uint32_t i = GetIndex(body);
+  return TransformBounds(GetOrientation(body), positions.Get(i),
+                         localCenters.Get(i), localExtents.Get(i));
+}
+
+void Engine::PhysicsWorld::ComputeWorldBounds(math::Aabb* out,
+                                              size_t count) const {
+  for (size_t i = 0; i < count; ++i) {
+    const math::Quaternion q(orientationX[i], orientationY[i],
+                             orientationZ[i], orientationW[i]);
+    out[i] = TransformBounds(q, positions.Get(i), localCenters.Get(i),
+                             localExtents.Get(i));
+  }
+}
+
+math::Affine3x4 Engine::PhysicsWorld::GetInterpolatedTransform(
+    RigidBodyHandle body, float alpha) const {
+  const uint32_t i = GetIndex(body);
+  const math::Quaternion from(previousX[i], previousY[i], previousZ[i],
+                              previousW[i]);
+  const math::Quaternion to(orientationX[i], orientationY[i],
+                            orientationZ[i], orientationW[i]);
+  const math::Vector3 start = previousPositions.Get(i);
+  const math::Vector3 position =
+      math::MulAdd(start, positions.Get(i) - start, alpha);
+  return math::Quaternion::Nlerp(from, to, alpha).ToAffine3x4(position);
+}
+
+void Engine::PhysicsWorld::GetInterpolatedTransforms(
+    float alpha, math::Affine3x4* out) const {
+  // Blended poses are staged in small AoS chunks for the batched converter.
+  constexpr size_t chunk = 64;
+  math::Quaternion rotations[chunk];
+  math::Vector3 translations[chunk];
+  const size_t count = positions.Size();
+  for (size_t base = 0; base < count; base += chunk) {
+    const size_t n = std::min(chunk, count - base);
+    for (size_t k = 0; k < n; ++k) {
+      const size_t i = base + k;
+      const math::Quaternion from(previousX[i], previousY[i], previousZ[i],
+                                  previousW[i]);
+      const math::Quaternion to(orientationX[i], orientationY[i],
+                                orientationZ[i], orientationW[i]);
+      rotations[k] = math::Quaternion::Nlerp(from, to, alpha);
+      const math::Vector3 start = previousPositions.Get(i);
+      translations[k] = math::MulAdd(start, positions.Get(i) - start, alpha);
+    }
+    math::QuaternionsToAffines(rotations, translations, out + base, n);
+  }
+}
+
+void Engine::PhysicsWorld::ApplyForce(RigidBodyHandle body,
+                                      const math::Vector3& force) {
+  const uint32_t i = Wake(body);
+  forces.Set(i, forces.Get(i) + force);
+}
+
+void Engine::PhysicsWorld::ApplyTorque(RigidBodyHandle body,
+                                       const math::Vector3& torque) {
+  const uint32_t i = Wake(body);
+  torques.Set(i, torques.Get(i) + torque);
+}
+
+void Engine::PhysicsWorld::ApplyImpulse(RigidBodyHandle body,
+                                        const math::Vector3& impulse,
+                                        const math::Vector3& point) {
+  if (GetInverseMass(body) == 0.0f) return;
+  const uint32_t i = Wake(body);
+  linearVelocities.Set(
+      i, math::MulAdd(linearVelocities.Get(i), impulse, inverseMasses[i]));
+  const math::Vector3 arm = point - positions.Get(i);
+  angularVelocities.Set(i, angularVelocities.Get(i) +
+                               ApplyInverseInertia(
+                                   i, math::Cross(arm, impulse)));
+}
+
+void Engine::PhysicsWorld::SetDamping(float linear, float angular) {
+  linearDamping = linear;
+  angularDamping = angular;
+}
+
+void Engine::PhysicsWorld::SetSleepThresholds(float linear, float angular) {
+  sleepLinearSpeed = linear;
+  sleepAngularSpeed = angular;
+}
+
+void Engine::PhysicsWorld::Step(float dt) {
+  IntegrateVelocities(dt);
+  IntegratePositions(dt);
+}
+
+void Engine::PhysicsWorld::IntegrateVelocities(float dt) {
+  const size_t count = awakeCount;
+  if (count == 0) return;
+  const float* inverseMass = inverseMasses.data();
+
+  // Forces and gravity into linear velocity.
+  AccumulateForces(linearVelocities.X(), forces.X(), inverseMass, gravity.x,
+                   dt, count);
+  AccumulateForces(linearVelocities.Y(), forces.Y(), inverseMass, gravity.y,
+                   dt, count);
+  AccumulateForces(linearVelocities.Z(), forces.Z(), inverseMass, gravity.z,
+                   dt, count);
+
+  // Torques into angular velocity through the world-space inverse inertia
+  // R * diag(invI) * R^T.
+  float* wx = angularVelocities.X();
+  float* wy = angularVelocities.Y();
+  float* wz = angularVelocities.Z();
+  const float* tx = torques.X();
+  const float* ty = torques.Y();
+  const float* tz = torques.Z();
+  for (size_t i = 0; i < count; ++i) {
+    if (tx[i] == 0.0f && ty[i] == 0.0f && tz[i] == 0.0f) continue;
+    const math::Vector3 dw = ApplyInverseInertia(
+        static_cast<uint32_t>(i), math::Vector3(tx[i], ty[i], tz[i]));
+    wx[i] += dw.x * dt;
+    wy[i] += dw.y * dt;
+    wz[i] += dw.z * dt;
+  }
+
+  Scale(linearVelocities, 1.0f / (1.0f + dt * linearDamping), count);
+  Scale(angularVelocities, 1.0f / (1.0f + dt * angularDamping), count);
+}
+
+void Engine::PhysicsWorld::IntegratePositions(float dt) {
+  const size_t count = awakeCount;
+  if (count == 0) return;
+
+  std::copy_n(positions.X(), count, previousPositions.X());
+  std::copy_n(positions.Y(), count, previousPositions.Y());
+  std::copy_n(positions.Z(), count, previousPositions.Z());
+  std::copy_n(orientationX.begin(), count, previousX.begin());
+  std::copy_n(orientationY.begin(), count, previousY.begin());
+  std::copy_n(orientationZ.begin(), count, previousZ.begin());
+  std::copy_n(orientationW.begin(), count, previousW.begin());
+
+  // Semi-implicit Euler: the new velocities move the bodies.
+  math::MulAddStream(positions.X(), linearVelocities.X(), dt, positions.X(),
+                     count);
+  math::MulAddStream(positions.Y(), linearVelocities.Y(), dt, positions.Y(),
+                     count);
+  math::MulAddStream(positions.Z(), linearVelocities.Z(), dt, positions.Z(),
+                     count);
+  math::IntegrateQuaternions(orientationX.data(), orientationY.data(),
+                             orientationZ.data(), orientationW.data(),
+                             angularVelocities.X(), angularVelocities.Y(),
+                             angularVelocities.Z(), dt, count);
+
+  Zero(forces, count);
+  Zero(torques, count);
+}
+
+void Engine::PhysicsWorld::UpdateSleepTimes(float dt) {
+  const float linear2 = sleepLinearSpeed * sleepLinearSpeed;
+  const float angular2 = sleepAngularSpeed * sleepAngularSpeed;
+  for (uint32_t i = 0; i < awakeCount; ++i) {
+    const bool resting =
+        math::LengthSquared(linearVelocities.Get(i)) < linear2 &&
+        math::LengthSquared(angularVelocities.Get(i)) < angular2;
+    sleepTimes[i] = resting ? sleepTimes[i] + dt : 0.0f;
+  }
+}
+
+uint32_t Engine::PhysicsWorld::GetIndex(RigidBodyHandle body) const {
+  return indexOfSlot[body.slot];
+}
+
+Engine::RigidBodyHandle Engine::PhysicsWorld::GetHandle(uint32_t index) const {
+  const uint32_t slot = slotOfIndex[index];
+  return {slot, generationOfSlot[slot]};
+}
+
+math::Vector3 Engine::PhysicsWorld::ApplyInverseInertia(
+    uint32_t index, const math::Vector3& v) const {
+  const math::Quaternion q(orientationX[index], orientationY[index],
+                           orientationZ[index], orientationW[index]);
+  const math::Vector3 local = q.Conjugate().Rotate(v);
+  const math::Vector3 inverseInertia = inverseInertias.Get(index);
+  return q.Rotate(math::Vector3(local.x * inverseInertia.x,
+                                local.y * inverseInertia.y,
+                                local.z * inverseInertia.z));
+}
+
+void Engine::PhysicsWorld::GetWorldInverseInertia(
+    uint32_t index, math::Vector3 rows[3]) const {
+  const math::Quaternion q(orientationX[index], orientationY[index],
+                           orientationZ[index], orientationW[index]);
+  // Columns of R are the rotated axes: row i is the sum over k of
+  // invI_k * R_ik * column k.
+  const math::Vector3 inverseInertia = inverseInertias.Get(index);
+  const math::Vector3 c0 = q.Rotate(math::Vector3(1.0f, 0.0f, 0.0f));
+  const math::Vector3 c1 = q.Rotate(math::Vector3(0.0f, 1.0f, 0.0f));
+  const math::Vector3 c2 = q.Rotate(math::Vector3(0.0f, 0.0f, 1.0f));
+  const math::Vector3 s0 = c0 * inverseInertia.x;
+  const math::Vector3 s1 = c1 * inverseInertia.y;
+  const math::Vector3 s2 = c2 * inverseInertia.z;
+  rows[0] = s0 * c0.x + s1 * c1.x + s2 * c2.x;
+  rows[1] = s0 * c0.y + s1 * c1.y + s2 * c2.y;
+  rows[2] = s0 * c0.z + s1 * c1.z + s2 * c2.z;
+}
@@ -0,0 +1,169 @@
+#pragma once
+
+#include <Aabb.hpp>
+#include <Affine3x4.hpp>
+#include <Collider.hpp>
+#include <ConvexHull.hpp>
+#include <Quaternion.hpp>
+#include <RigidBody.hpp>
+#include <Vector3.hpp>
+#include <Vector3Batch.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Engine {
+// Rigid-body state in structure-of-arrays form. Body i's position,
+// orientation, velocities, inverse mass and inverse inertia live at index i
+// of contiguous per-component arrays, with no gaps: destroying a body moves
+// the last body into its place. Awake bodies come first, sleeping ones
+// after them, and Step integrates only the awake ones with tight loops over
+// those arrays; handles map to the current array index.
+class PhysicsWorld {
+ private:
+  using Buffer = math::Vector3Batch::Buffer;
+
+  math::Vector3Batch positions;
+  Buffer orientationX, orientationY, orientationZ, orientationW;
+  // Pose before the last Step, for render interpolation.
+  math::Vector3Batch previousPositions;
+  Buffer previousX, previousY, previousZ, previousW;
+  math::Vector3Batch linearVelocities;
+  math::Vector3Batch angularVelocities;
+  math::Vector3Batch forces;
+  math::Vector3Batch torques;
+  Buffer inverseMasses;
+  // Body space, the reciprocals of RigidBodyDesc::inertia.
+  math::Vector3Batch inverseInertias;
+  // Body space, the bounds of RigidBodyDesc::collider.
+  math::Vector3Batch localCenters;
+  math::Vector3Batch localExtents;
+  // Read by the narrow phase only, so kept out of the hot arrays.
+  std::vector<Collider> colliders;
+  // Seconds each body has stayed below the sleep thresholds.
+  Buffer sleepTimes;
+  // Bodies [0, awakeCount) are awake.
+  uint32_t awakeCount = 0;
+  // Dynamic bodies with continuous collision, in no particular order.
+  std::vector<RigidBodyHandle> continuousBodies;
+
+  // slot -> index for handles, index -> slot for moving bodies around.
+  std::vector<uint32_t> indexOfSlot;
+  std::vector<uint32_t> generationOfSlot;
+  std::vector<uint32_t> slotOfIndex;
+  std::vector<uint32_t> freeSlots;
+
+  math::Vector3 gravity = math::Vector3(0.0f, -9.81f, 0.0f);
+  float linearDamping = 0.0f;
+  float angularDamping = 0.05f;
+  float sleepLinearSpeed = 0.05f;
+  float sleepAngularSpeed = 0.05f;
+  float timeToSleep = 0.5f;
+
+  math::Vector3 ApplyInverseInertia(uint32_t index,
+                                    const math::Vector3& v) const;
+  void SwapBodies(uint32_t i, uint32_t j);
+  // Wakes the body and returns its array index.
+  uint32_t Wake(RigidBodyHandle body);
+
+ public:
+  RigidBodyHandle CreateBody(const RigidBodyDesc& desc);
+  // Does nothing for handles that are not alive.
+  void DestroyBody(RigidBodyHandle body);
+  bool IsAlive(RigidBodyHandle body) const;
+  size_t GetBodyCount() const { return positions.Size(); }
+  void Clear();
+
+  // A sleeping body keeps its pose, has zero velocity and is skipped by
+  // Step. Setting its pose or velocity, or applying a force or impulse,
+  // wakes it; so does SetAwake. Putting a body to sleep zeroes its
+  // velocities and forces. New bodies start awake.
+  bool IsAwake(RigidBodyHandle body) const;
+  void SetAwake(RigidBodyHandle body, bool awake);
+  // Awake bodies are at array indices [0, GetAwakeCount()).
+  uint32_t GetAwakeCount() const { return awakeCount; }
+
+  // Continuous bodies get speculative contacts in Scene, and those that
+  // move further than their own extent in a step are swept through the
+  // broadphase, so they stop at thin bodies instead of passing through
+  // them. Only linear motion is swept. Meant for a handful of bodies: the list
+  // is searched linearly. Static bodies are never continuous.
+  void SetContinuous(RigidBodyHandle body, bool continuous);
+  bool IsContinuous(RigidBodyHandle body) const;
+  const std::vector<RigidBodyHandle>& GetContinuousBodies() const {
+    return continuousBodies;
+  }
+  // Motion of the body over dt at its current velocity. Returns true when
+  // it exceeds the smallest half extent of the body's local bounds, the
+  // distance beyond which it could skip over a body as thin as itself.
+  bool ComputeSweep(RigidBodyHandle body, float dt,
+                    math::Vector3& displacement) const;
+
+  // Accessors take live handles only. Setting the position or orientation
+  // teleports the body: interpolation does not blend from the old pose.
+  math::Vector3 GetPosition(RigidBodyHandle body) const;
+  void SetPosition(RigidBodyHandle body, const math::Vector3& position);
+  math::Quaternion GetOrientation(RigidBodyHandle body) const;
+  void SetOrientation(RigidBodyHandle body, const math::Quaternion& q);
+  math::Vector3 GetLinearVelocity(RigidBodyHandle body) const;
+  void SetLinearVelocity(RigidBodyHandle body, const math::Vector3& v);
+  math::Vector3 GetAngularVelocity(RigidBodyHandle body) const;
+  void SetAngularVelocity(RigidBodyHandle body, const math::Vector3& w);
+  float GetInverseMass(RigidBodyHandle body) const;
+  math::Affine3x4 GetTransform(RigidBodyHandle body) const;
+  const Collider& GetCollider(RigidBodyHandle body) const;
+  // Position and orientation, in the form the narrow phase takes.
+  Pose GetPose(RigidBodyHandle body) const;
+  // World-space box around the body's rotated local bounds.
+  math::Aabb GetWorldBounds(RigidBodyHandle body) const;
+  // The same for the first `count` bodies in array order, awake ones first.
+  void ComputeWorldBounds(math::Aabb* out, size_t count) const;
+  // Pose between the last two steps: alpha 0 is the pose before the last
+  // Step, 1 the current one.
+  math::Affine3x4 GetInterpolatedTransform(RigidBodyHandle body,
+                                           float alpha) const;
+  // The same for every body in array order; out holds GetBodyCount().
+  void GetInterpolatedTransforms(float alpha, math::Affine3x4* out) const;
+
+  // Forces and torques accumulate until the next Step.
+  void ApplyForce(RigidBodyHandle body, const math::Vector3& force);
+  void ApplyTorque(RigidBodyHandle body, const math::Vector3& torque);
+  // Instant velocity change from an impulse at a world-space point.
+  void ApplyImpulse(RigidBodyHandle body, const math::Vector3& impulse,
+                    const math::Vector3& point);
+
+  void SetGravity(const math::Vector3& g) { gravity = g; }
+  math::Vector3 GetGravity() const { return gravity; }
+  // Fraction of velocity lost per second.
+  void SetDamping(float linear, float angular);
+  // Speeds, in m/s and rad/s, below which a body counts as at rest.
+  void SetSleepThresholds(float linear, float angular);
+  // Seconds at rest before a body may sleep; infinity disables sleeping.
+  // PhysicsWorld only keeps the time: Scene puts whole islands to sleep.
+  void SetTimeToSleep(float seconds) { timeToSleep = seconds; }
+  float GetTimeToSleep() const { return timeToSleep; }
+
+  // Advances every awake body by dt with semi-implicit Euler and clears the
+  // accumulated forces. Gyroscopic torque is not modelled.
+  void Step(float dt);
+  // Step in two halves, so a contact solver can adjust the velocities in
+  // between: forces, gravity and damping first, then the move.
+  void IntegrateVelocities(float dt);
+  void IntegratePositions(float dt);
+  // Adds dt to the sleep time of each awake body at rest, and resets it for
+  // the others.
+  void UpdateSleepTimes(float dt);
+  float GetSleepTime(uint32_t index) const { return sleepTimes[index]; }
+
+  // Array index of a live body, for systems that walk the arrays directly.
+  uint32_t GetIndex(RigidBodyHandle body) const;
+  RigidBodyHandle GetHandle(uint32_t index) const;
+  // Per-index state for the contact solver.
+  const math::Vector3Batch& GetPositions() const { return positions; }
+  math::Vector3Batch& GetLinearVelocities() { return linearVelocities; }
+  math::Vector3Batch& GetAngularVelocities() { return angularVelocities; }
+  const Buffer& GetInverseMasses() const { return inverseMasses; }
+  // Rows of the world-space inverse inertia tensor R * diag(invI) * R^T.
+  void GetWorldInverseInertia(uint32_t index, math::Vector3 rows[3]) const;
+};
+}  // namespace Engine
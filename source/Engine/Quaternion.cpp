@@ -0,0 +1,322 @@
+#include "Quaternion.hpp"
+
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define QUATERNION_SSE 1
+#include <immintrin.h>
+#endif
+
+static_assert(sizeof(math::Quaternion) == 4 * sizeof(float),
+              "batched kernels load quaternions as packed float4");
+
+// Compile-time checks for the constexpr subset. (0, 0, 1, 0) is a half turn
+// about z, so every product below is exact.
+namespace {
+constexpr math::Quaternion halfTurnZ(0.0f, 0.0f, 1.0f, 0.0f);
+constexpr math::Quaternion fullTurnZ = halfTurnZ * halfTurnZ;
+static_assert(fullTurnZ.w == -1.0f && fullTurnZ.z == 0.0f,
+              "two half turns are a full turn (-identity)");
+static_assert((halfTurnZ * halfTurnZ.Conjugate()).w == 1.0f,
+              "q * conjugate(q) is the identity for unit q");
+static_assert(math::Quaternion::CreateIdentity().Dot(halfTurnZ) == 0.0f,
+              "identity is orthogonal to a half turn");
+}  // namespace
+
+math::Quaternion math::Quaternion::CreateFromAxisAngle(const Vector3& axis,
+                                                       float angle) {
+  const float s = std::sin(angle * 0.5f);
+  return Quaternion(axis.x * s, axis.y * s, axis.z * s,
+                    std::cos(angle * 0.5f));
+}
+
+math::Quaternion math::Quaternion::CreateRotationYaw(float angle) {
+  return Quaternion(0.0f, std::sin(angle * 0.5f), 0.0f,
+                    std::cos(angle * 0.5f));
+}
+
+float math::Quaternion::Length() const { return std::sqrt(Dot(*this)); }
+
+void math::Quaternion::Normalize() {
+  const float invLength = 1.0f / Length();
+  x *= invLength;
+  y *= invLength;
+  z *= invLength;
+  w *= invLength;
+}
+
+math::Quaternion math::Quaternion::Normalized() const {
+  Quaternion q = *this;
+  q.Normalize();
+  return q;
+}
+
+math::Vector3 math::Quaternion::Rotate(const Vector3& v) const {
+  // v + w * t + q.xyz x t, with t = 2 * (q.xyz x v).
+  const float tx = 2.0f * (y * v.z - z * v.y);
+  const float ty = 2.0f * (z * v.x - x * v.z);
+  const float tz = 2.0f * (x * v.y - y * v.x);
+  return Vector3(v.x + w * tx + (y * tz - z * ty),
+                 v.y + w * ty + (z * tx - x * tz),
+                 v.z + w * tz + (x * ty - y * tx));
+}
+
+math::Quaternion math::Quaternion::Integrate(const Vector3& angularVelocity,
+                                             float dt) const {
+  // q' = q + dt / 2 * (omega, 0) * q
+  const float h = 0.5f * dt;
+  const float ox = angularVelocity.x * h;
+  const float oy = angularVelocity.y * h;
+  const float oz = angularVelocity.z * h;
+  Quaternion q(x + ox * w + (oy * z - oz * y), y + oy * w + (oz * x - ox * z),
+               z + oz * w + (ox * y - oy * x),
+               w - (ox * x + oy * y + oz * z));
+  q.Normalize();
+  return q;
+}
+
+math::Matrix4x4 math::Quaternion::ToMatrix4x4() const {
+  return ToAffine3x4(Vector3(0.0f, 0.0f, 0.0f)).ToMatrix4x4();
+}
+
+math::Affine3x4 math::Quaternion::ToAffine3x4(
+    const Vector3& translation) const {
+  Affine3x4 a;
+  const float xx = x * x, yy = y * y, zz = z * z;
+  const float xy = x * y, xz = x * z, yz = y * z;
+  const float wx = w * x, wy = w * y, wz = w * z;
+  a.element[0][0] = 1.0f - 2.0f * (yy + zz);
+  a.element[0][1] = 2.0f * (xy - wz);
+  a.element[0][2] = 2.0f * (xz + wy);
+  a.element[0][3] = translation.x;
+  a.element[1][0] = 2.0f * (xy + wz);
+  a.element[1][1] = 1.0f - 2.0f * (xx + zz);
+  a.element[1][2] = 2.0f * (yz - wx);
+  a.element[1][3] = translation.y;
+  a.element[2][0] = 2.0f * (xz - wy);
+  a.element[2][1] = 2.0f * (yz + wx);
+  a.element[2][2] = 1.0f - 2.0f * (xx + yy);
+  a.element[2][3] = translation.z;
+  return a;
+}
+
+math::Quaternion math::Quaternion::Nlerp(const Quaternion& a,
+                                         const Quaternion& b, float t) {
+  const float sign = a.Dot(b) < 0.0f ? -1.0f : 1.0f;
+  const float s = 1.0f - t;
+  const float u = t * sign;
+  return Quaternion(a.x * s + b.x * u, a.y * s + b.y * u, a.z * s + b.z * u,
+                    a.w * s + b.w * u)
+      .Normalized();
+}
+
+math::Quaternion math::Quaternion::Slerp(const Quaternion& a,
+                                         const Quaternion& b, float t) {
+  float cosTheta = a.Dot(b);
+  const float sign = cosTheta < 0.0f ? -1.0f : 1.0f;
+  cosTheta *= sign;
+  if (cosTheta > 0.9995f) return Nlerp(a, b, t);
+
+  const float theta = std::acos(cosTheta);
+  const float invSin = 1.0f / std::sin(theta);
+  const float s = std::sin((1.0f - t) * theta) * invSin;
+  const float u = std::sin(t * theta) * invSin * sign;
+  return Quaternion(a.x * s + b.x * u, a.y * s + b.y * u, a.z * s + b.z * u,
+                    a.w * s + b.w * u);
+}
+
+#ifdef QUATERNION_SSE
+namespace {
+// Rotation part of four quaternions at once: r[row * 3 + column][lane], in
+// the column-vector layout of Affine3x4.
+struct Rotations4 {
+  alignas(16) float r[9][4];
+};
+
+void ComputeRotations4(const math::Quaternion* q, Rotations4& out) {
+  __m128 x = _mm_loadu_ps(&q[0].x);
+  __m128 y = _mm_loadu_ps(&q[1].x);
+  __m128 z = _mm_loadu_ps(&q[2].x);
+  __m128 w = _mm_loadu_ps(&q[3].x);
+  _MM_TRANSPOSE4_PS(x, y, z, w);
+
+  const __m128 one = _mm_set1_ps(1.0f);
+  const __m128 two = _mm_set1_ps(2.0f);
+  const __m128 x2 = _mm_mul_ps(x, two), y2 = _mm_mul_ps(y, two),
+               z2 = _mm_mul_ps(z, two);
+  const __m128 xx = _mm_mul_ps(x, x2), yy = _mm_mul_ps(y, y2),
+               zz = _mm_mul_ps(z, z2);
+  const __m128 xy = _mm_mul_ps(x, y2), xz = _mm_mul_ps(x, z2),
+               yz = _mm_mul_ps(y, z2);
+  const __m128 wx = _mm_mul_ps(w, x2), wy = _mm_mul_ps(w, y2),
+               wz = _mm_mul_ps(w, z2);
+
+  _mm_store_ps(out.r[0], _mm_sub_ps(one, _mm_add_ps(yy, zz)));
+  _mm_store_ps(out.r[1], _mm_sub_ps(xy, wz));
+  _mm_store_ps(out.r[2], _mm_add_ps(xz, wy));
+  _mm_store_ps(out.r[3], _mm_add_ps(xy, wz));
+  _mm_store_ps(out.r[4], _mm_sub_ps(one, _mm_add_ps(xx, zz)));
+  _mm_store_ps(out.r[5], _mm_sub_ps(yz, wx));
+  _mm_store_ps(out.r[6], _mm_sub_ps(xz, wy));
+  _mm_store_ps(out.r[7], _mm_add_ps(yz, wx));
+  _mm_store_ps(out.r[8], _mm_sub_ps(one, _mm_add_ps(xx, yy)));
+}
+}  // namespace
+#endif
+
+void math::IntegrateQuaternions(const Quaternion* in,
+                                const Vector3* angularVelocities, float dt,
+                                Quaternion* out, size_t count) {
+  size_t i = 0;
+#ifdef QUATERNION_SSE
+  const __m128 h = _mm_set1_ps(0.5f * dt);
+  for (; i + 4 <= count; i += 4) {
+    __m128 x = _mm_loadu_ps(&in[i + 0].x);
+    __m128 y = _mm_loadu_ps(&in[i + 1].x);
+    __m128 z = _mm_loadu_ps(&in[i + 2].x);
+    __m128 w = _mm_loadu_ps(&in[i + 3].x);
+    _MM_TRANSPOSE4_PS(x, y, z, w);
+
+    const Vector3* v = angularVelocities + i;
+    const __m128 ox =
+        _mm_mul_ps(h, _mm_setr_ps(v[0].x, v[1].x, v[2].x, v[3].x));
+    const __m128 oy =
+        _mm_mul_ps(h, _mm_setr_ps(v[0].y, v[1].y, v[2].y, v[3].y));
+    const __m128 oz =
+        _mm_mul_ps(h, _mm_setr_ps(v[0].z, v[1].z, v[2].z, v[3].z));
+
+    __m128 nx = _mm_add_ps(x, _mm_add_ps(_mm_mul_ps(ox, w),
+                                         _mm_sub_ps(_mm_mul_ps(oy, z),
+                                                    _mm_mul_ps(oz, y))));
+    __m128 ny = _mm_add_ps(y, _mm_add_ps(_mm_mul_ps(oy, w),
+                                         _mm_sub_ps(_mm_mul_ps(oz, x),
+                                                    _mm_mul_ps(ox, z))));
+    __m128 nz = _mm_add_ps(z, _mm_add_ps(_mm_mul_ps(oz, w),
+                                         _mm_sub_ps(_mm_mul_ps(ox, y),
+                                                    _mm_mul_ps(oy, x))));
+    __m128 nw = _mm_sub_ps(
+        w, _mm_add_ps(_mm_mul_ps(ox, x),
+                      _mm_add_ps(_mm_mul_ps(oy, y), _mm_mul_ps(oz, z))));
+
+    const __m128 lengthSq = _mm_add_ps(
+        _mm_add_ps(_mm_mul_ps(nx, nx), _mm_mul_ps(ny, ny)),
+        _mm_add_ps(_mm_mul_ps(nz, nz), _mm_mul_ps(nw, nw)));
+    const __m128 invLength =
+        _mm_div_ps(_mm_set1_ps(1.0f), _mm_sqrt_ps(lengthSq));
+    nx = _mm_mul_ps(nx, invLength);
+    ny = _mm_mul_ps(ny, invLength);
+    nz = _mm_mul_ps(nz, invLength);
+    nw = _mm_mul_ps(nw, invLength);
+
+    _MM_TRANSPOSE4_PS(nx, ny, nz, nw);
+    _mm_storeu_ps(&out[i + 0].x, nx);
+    _mm_storeu_ps(&out[i + 1].x, ny);
+    _mm_storeu_ps(&out[i + 2].x, nz);
+    _mm_storeu_ps(&out[i + 3].x, nw);
+  }
+#endif
+  for (; i < count; ++i) out[i] = in[i].Integrate(angularVelocities[i], dt);
+}
+
+void math::IntegrateQuaternions(float* x, float* y, float* z, float* w,
+                                const float* omegaX, const float* omegaY,
+                                const float* omegaZ, float dt, size_t count) {
+  // Same update as Quaternion::Integrate.
+  const float h = 0.5f * dt;
+  size_t i = 0;
+#ifdef QUATERNION_SSE
+  // std::sqrt may set errno, which keeps the compiler from vectorizing the
+  // plain loop below, so the four-wide path is spelled out.
+  const __m128 vh = _mm_set1_ps(h);
+  const __m128 one = _mm_set1_ps(1.0f);
+  for (; i + 4 <= count; i += 4) {
+    const __m128 ox = _mm_mul_ps(_mm_loadu_ps(omegaX + i), vh);
+    const __m128 oy = _mm_mul_ps(_mm_loadu_ps(omegaY + i), vh);
+    const __m128 oz = _mm_mul_ps(_mm_loadu_ps(omegaZ + i), vh);
+    const __m128 qx = _mm_loadu_ps(x + i);
+    const __m128 qy = _mm_loadu_ps(y + i);
+    const __m128 qz = _mm_loadu_ps(z + i);
+    const __m128 qw = _mm_loadu_ps(w + i);
+    const __m128 nx = _mm_add_ps(
+        qx, _mm_add_ps(_mm_mul_ps(ox, qw),
+                       _mm_sub_ps(_mm_mul_ps(oy, qz), _mm_mul_ps(oz, qy))));
+    const __m128 ny = _mm_add_ps(
+        qy, _mm_add_ps(_mm_mul_ps(oy, qw),
+                       _mm_sub_ps(_mm_mul_ps(oz, qx), _mm_mul_ps(ox, qz))));
+    const __m128 nz = _mm_add_ps(
+        qz, _mm_add_ps(_mm_mul_ps(oz, qw),
+                       _mm_sub_ps(_mm_mul_ps(ox, qy), _mm_mul_ps(oy, qx))));
+    const __m128 nw = _mm_sub_ps(
+        qw, _mm_add_ps(_mm_mul_ps(ox, qx),
+                       _mm_add_ps(_mm_mul_ps(oy, qy), _mm_mul_ps(oz, qz))));
+    const __m128 lengthSq =
+        _mm_add_ps(_mm_add_ps(_mm_mul_ps(nx, nx), _mm_mul_ps(ny, ny)),
+                   _mm_add_ps(_mm_mul_ps(nz, nz), _mm_mul_ps(nw, nw)));
+    const __m128 invLength = _mm_div_ps(one, _mm_sqrt_ps(lengthSq));
+    _mm_storeu_ps(x + i, _mm_mul_ps(nx, invLength));
+    _mm_storeu_ps(y + i, _mm_mul_ps(ny, invLength));
+    _mm_storeu_ps(z + i, _mm_mul_ps(nz, invLength));
+    _mm_storeu_ps(w + i, _mm_mul_ps(nw, invLength));
+  }
+#endif
+  for (; i < count; ++i) {
+    const Quaternion q = Quaternion(x[i], y[i], z[i], w[i]).Integrate(
+        Vector3(omegaX[i], omegaY[i], omegaZ[i]), dt);
+    x[i] = q.x;
+    y[i] = q.y;
+    z[i] = q.z;
+    w[i] = q.w;
+  }
+}
+
+void math::QuaternionsToAffines(const Quaternion* rotations,
+                                const Vector3* translations, Affine3x4* out,
+                                size_t count) {
+  size_t i = 0;
+#ifdef QUATERNION_SSE
+  for (; i + 4 <= count; i += 4) {
+    Rotations4 r;
+    ComputeRotations4(rotations + i, r);
+    for (int lane = 0; lane < 4; ++lane) {
+      Affine3x4& a = out[i + lane];
+      for (int row = 0; row < 3; ++row) {
+        for (int column = 0; column < 3; ++column)
+          a.element[row][column] = r.r[row * 3 + column][lane];
+      }
+      a.element[0][3] = translations[i + lane].x;
+      a.element[1][3] = translations[i + lane].y;
+      a.element[2][3] = translations[i + lane].z;
+    }
+  }
+#endif
+  for (; i < count; ++i) out[i] = rotations[i].ToAffine3x4(translations[i]);
+}
+
+void math::QuaternionsToMatrices(const Quaternion* rotations,
+                                 const Vector3* translations, Matrix4x4* out,
+                                 size_t count) {
+  size_t i = 0;
+#ifdef QUATERNION_SSE
+  for (; i + 4 <= count; i += 4) {
+    Rotations4 r;
+    ComputeRotations4(rotations + i, r);
+    for (int lane = 0; lane < 4; ++lane) {
+      // Row-vector layout: entry (row, column) of the rotation lands at
+      // element[column][row].
+      Matrix4x4& m = out[i + lane];
+      for (int row = 0; row < 3; ++row) {
+        for (int column = 0; column < 3; ++column)
+          m.element[column][row] = r.r[row * 3 + column][lane];
+        m.element[row][3] = 0.0f;
+      }
+      m.element[3][0] = translations[i + lane].x;
+      m.element[3][1] = translations[i + lane].y;
+      m.element[3][2] = translations[i + lane].z;
+      m.element[3][3] = 1.0f;
+    }
+  }
+#endif
+  for (; i < count; ++i)
+    out[i] = rotations[i].ToAffine3x4(translations[i]).ToMatrix4x4();
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <Affine3x4.hpp>
+#include <Matrix4x4.hpp>
+#include <Vector3.hpp>
+#include <cstddef>
+
+namespace math {
+// Rotation quaternion (x, y, z) + w. The product is the usual Hamilton
+// product, so (a * b) rotates by b first and then by a -- the opposite of
+// the Matrix4x4/Affine3x4 composition order.
+class Quaternion {
+ public:
+  float x, y, z, w;
+
+  constexpr Quaternion() : x(0.0f), y(0.0f), z(0.0f), w(1.0f) {}
+  constexpr Quaternion(float x, float y, float z, float w)
+      : x(x), y(y), z(z), w(w) {}
+
+  static constexpr Quaternion CreateIdentity() { return Quaternion(); }
+  // `axis` must be normalized.
+  static Quaternion CreateFromAxisAngle(const Vector3& axis, float angle);
+  // Rotation about the y axis, matching Affine3x4::CreateRotationYaw.
+  static Quaternion CreateRotationYaw(float angle);
+
+  constexpr Quaternion operator*(const Quaternion& rhs) const {
+    return Quaternion(w * rhs.x + x * rhs.w + y * rhs.z - z * rhs.y,
+                      w * rhs.y - x * rhs.z + y * rhs.w + z * rhs.x,
+                      w * rhs.z + x * rhs.y - y * rhs.x + z * rhs.w,
+                      w * rhs.w - x * rhs.x - y * rhs.y - z * rhs.z);
+  }
+
+  constexpr float Dot(const Quaternion& rhs) const {
+    return x * rhs.x + y * rhs.y + z * rhs.z + w * rhs.w;
+  }
+  float Length() const;
+  void Normalize();
+  Quaternion Normalized() const;
+  constexpr Quaternion Conjugate() const { return Quaternion(-x, -y, -z, w); }
+
+  Vector3 Rotate(const Vector3& v) const;
+
+  // Advances the orientation by a world-space angular velocity over dt
+  // (first order, renormalized). Accurate for the small angles of a
+  // physics step and much cheaper than building an axis-angle rotation.
+  Quaternion Integrate(const Vector3& angularVelocity, float dt) const;
+
+  Matrix4x4 ToMatrix4x4() const;
+  Affine3x4 ToAffine3x4(const Vector3& translation) const;
+
+  // Normalized linear interpolation; takes the shortest arc.
+  static Quaternion Nlerp(const Quaternion& a, const Quaternion& b, float t);
+  // Constant angular speed interpolation; takes the shortest arc and falls
+  // back to Nlerp for nearly identical rotations.
+  static Quaternion Slerp(const Quaternion& a, const Quaternion& b, float t);
+};
+
+// Batched versions of the per-body hot paths. On x86 they process four
+// quaternions per iteration with SSE; elsewhere they loop over the scalar
+// versions. in and out may be the same buffer.
+void IntegrateQuaternions(const Quaternion* in,
+                          const Vector3* angularVelocities, float dt,
+                          Quaternion* out, size_t count);
+// Structure-of-arrays variant, updating (x, y, z, w) in place from the
+// separate angular velocity streams.
+void IntegrateQuaternions(float* x, float* y, float* z, float* w,
+                          const float* omegaX, const float* omegaY,
+                          const float* omegaZ, float dt, size_t count);
+void QuaternionsToAffines(const Quaternion* rotations,
+                          const Vector3* translations, Affine3x4* out,
+                          size_t count);
+void QuaternionsToMatrices(const Quaternion* rotations,
+                           const Vector3* translations, Matrix4x4* out,
+                           size_t count);
+}  // namespace math
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <Collider.hpp>
+#include <Quaternion.hpp>
+#include <Vector3.hpp>
+#include <cstdint>
+
+namespace Engine {
+// Refers to a body in a PhysicsWorld. Bodies move around in the world's
+// arrays as others are destroyed; the handle stays valid until its own body
+// is destroyed, after which PhysicsWorld::IsAlive reports false.
+struct RigidBodyHandle {
+  static constexpr uint32_t invalidSlot = 0xFFFFFFFFu;
+
+  uint32_t slot = invalidSlot;
+  uint32_t generation = 0;
+
+  bool IsValid() const { return slot != invalidSlot; }
+  bool operator==(const RigidBodyHandle& other) const {
+    return slot == other.slot && generation == other.generation;
+  }
+  bool operator!=(const RigidBodyHandle& other) const {
+    return !(*this == other);
+  }
+};
+
+struct RigidBodyDesc {
+  math::Vector3 position = math::Vector3(0.0f, 0.0f, 0.0f);
+  math::Quaternion orientation;
+  math::Vector3 linearVelocity = math::Vector3(0.0f, 0.0f, 0.0f);
+  // World space, radians per second.
+  math::Vector3 angularVelocity = math::Vector3(0.0f, 0.0f, 0.0f);
+  // 0 makes the body static: it ignores forces, gravity and impulses.
+  float mass = 1.0f;
+  // Principal moments of inertia in body space, see ComputeBoxInertia.
+  math::Vector3 inertia = math::Vector3(1.0f, 1.0f, 1.0f);
+  // Shape for collisions; its bounds feed the broadphase.
+  Collider collider;
+  // Continuous collision for fast, small dynamic bodies such as
+  // projectiles, see PhysicsWorld::SetContinuous.
+  bool continuous = false;
+};
+
+// Two bodies whose bounds overlap, as reported by the broadphase.
+struct RigidBodyPair {
+  RigidBodyHandle a;
+  RigidBodyHandle b;
+};
+
+// Principal moments of inertia of solid shapes with uniform density.
+inline math::Vector3 ComputeBoxInertia(float mass,
+                                       const math::Vector3& halfExtents) {
+  const float x2 = 4.0f * halfExtents.x * halfExtents.x;
+  const float y2 = 4.0f * halfExtents.y * halfExtents.y;
+  const float z2 = 4.0f * halfExtents.z * halfExtents.z;
+  const float k = mass / 12.0f;
+  return math::Vector3(k * (y2 + z2), k * (x2 + z2), k * (x2 + y2));
+}
+
+inline math::Vector3 ComputeSphereInertia(float mass, float radius) {
+  const float i = 0.4f * mass * radius * radius;
+  return math::Vector3(i, i, i);
+}
+}  // namespace Engine
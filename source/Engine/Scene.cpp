@@ -1,5 +1,17 @@
 #include "Scene.hpp"
 
+#include <algorithm>
+#include <cmath>
+
+#include "Collision.hpp"
+#include "VectorOps.hpp"
+
+namespace {
+// Parallel Update: chunks per thread, and the fewest objects per chunk.
+constexpr size_t updateChunksPerThread = 8;
+constexpr size_t minUpdateChunk = 64;
+}  // namespace
+
 bool Engine::Scene::Initialize() {
   for (auto& obj : sceneObjects) {
     if (obj->Initialize() == false) return false;
@@ -7,10 +19,82 @@ bool Engine::Scene::Initialize() {
   return true;
 }
 
-void Engine::Scene::Update() {
+void Engine::Scene::FixedUpdate(float dt) {
   for (auto& obj : sceneObjects) {
-    obj->Update();
+    obj->FixedUpdate(dt);
+  }
+  UpdateBroadphase(dt);
+  UpdateContacts();
+  physicsWorld.IntegrateVelocities(dt);
+  solver.Solve(physicsWorld, contacts, dt);
+  physicsWorld.IntegratePositions(dt);
+  UpdateSleep(dt);
+}
+
+void Engine::Scene::Update() {
+  const size_t count = sceneObjects.size();
+  const unsigned threads =
+      parallelUpdate && jobs != nullptr ? jobs->GetThreadCount() : 1;
+  // About updateChunksPerThread chunks per thread, for stealing to even
+  // out uneven updates; one chunk when serial.
+  const size_t chunkSize =
+      threads > 1
+          ? std::max(minUpdateChunk, count / (updateChunksPerThread * threads))
+          : std::max<size_t>(count, 1);
+  const size_t chunkCount = (count + chunkSize - 1) / chunkSize;
+  if (commandBuffers.size() < chunkCount) commandBuffers.resize(chunkCount);
+  auto updateChunks = [&](size_t firstChunk, size_t lastChunk) {
+    for (size_t chunk = firstChunk; chunk < lastChunk; ++chunk) {
+      SceneCommands commands(commandBuffers[chunk]);
+      const size_t end = std::min(count, (chunk + 1) * chunkSize);
+      for (size_t i = chunk * chunkSize; i < end; ++i)
+        sceneObjects[i]->UpdateDeferred(commands);
+    }
+  };
+  if (threads > 1) {
+    jobs->ParallelFor(0, chunkCount, updateChunks, 1);
+  } else {
+    updateChunks(0, chunkCount);
   }
+  ApplyCommands();
+}
+
+void Engine::Scene::ApplyCommands() {
+  // Chunks hold consecutive objects, and each records its objects' commands
+  // in order, so the buffers in chunk order give the order of a serial
+  // update.
+  destroyedObjects.clear();
+  for (auto& buffer : commandBuffers) {
+    for (SceneCommands::Command& command : buffer) {
+      switch (command.type) {
+        case SceneCommands::Type::SPAWN:
+          command.spawned->Initialize();
+          AddGameObject(std::move(command.spawned));
+          break;
+        case SceneCommands::Type::DESTROY:
+          RemoveRigidBody(*command.destroyed);
+          destroyedObjects.push_back(command.destroyed);
+          break;
+        case SceneCommands::Type::WRITE:
+          command.write(*this);
+          break;
+      }
+    }
+  }
+  // Destroyed objects stay owned until every command has run, then leave
+  // in one pass that keeps the others in order.
+  if (!destroyedObjects.empty()) {
+    std::sort(destroyedObjects.begin(), destroyedObjects.end());
+    sceneObjects.erase(
+        std::remove_if(sceneObjects.begin(), sceneObjects.end(),
+                       [&](const std::shared_ptr<GameObject>& object) {
+                         return std::binary_search(destroyedObjects.begin(),
+                                                   destroyedObjects.end(),
+                                                   object.get());
+                       }),
+        sceneObjects.end());
+  }
+  for (auto& buffer : commandBuffers) buffer.clear();
 }
 
 void Engine::Scene::Render() {
@@ -19,4 +103,294 @@ void Engine::Scene::Render() {
   }
 }
 
-void Engine::Scene::Exit() { sceneObjects.clear(); }
+void Engine::Scene::Exit() {
+  sceneObjects.clear();
+  physicsWorld.Clear();
+  broadphase.Clear();
+  proxyOfSlot.clear();
+  bodyOfProxy.clear();
+  grid.Clear();
+  gridBodies.clear();
+  bodyPairs.clear();
+  contacts.Clear();
+  islandGraph.Clear();
+  sweptBodies.clear();
+  sweepOfSlot.clear();
+  commandBuffers.clear();
+}
+
+void Engine::Scene::AddGameObject(std::shared_ptr<GameObject> object) {
+  sceneObjects.push_back(object);
+}
+
+Engine::RigidBodyHandle Engine::Scene::AddRigidBody(
+    GameObject& object, const RigidBodyDesc& desc) {
+  const RigidBodyHandle body = physicsWorld.CreateBody(desc);
+  object.SetRigidBody(body);
+  if (broadphaseType == BroadphaseType::TREE) CreateProxy(body);
+  if (physicsWorld.GetInverseMass(body) > 0.0f) islandGraph.AddBody(body);
+  return body;
+}
+
+void Engine::Scene::CreateProxy(RigidBodyHandle body) {
+  const uint32_t proxy =
+      broadphase.CreateProxy(physicsWorld.GetWorldBounds(body), body.slot);
+  if (proxyOfSlot.size() <= body.slot) proxyOfSlot.resize(body.slot + 1);
+  proxyOfSlot[body.slot] = proxy;
+  if (bodyOfProxy.size() <= proxy) bodyOfProxy.resize(proxy + 1);
+  bodyOfProxy[proxy] = body;
+}
+
+void Engine::Scene::RemoveRigidBody(GameObject& object) {
+  const RigidBodyHandle body = object.GetRigidBody();
+  if (!physicsWorld.IsAlive(body)) return;
+  if (broadphaseType == BroadphaseType::TREE)
+    broadphase.DestroyProxy(proxyOfSlot[body.slot]);
+  islandGraph.RemoveBody(body);
+  physicsWorld.DestroyBody(body);
+  object.SetRigidBody(RigidBodyHandle());
+}
+
+Engine::PhysicsWorld& Engine::Scene::GetPhysicsWorld() { return physicsWorld; }
+
+void Engine::Scene::SetBroadphase(BroadphaseType type) {
+  if (type == broadphaseType) return;
+  broadphaseType = type;
+  broadphase.Clear();
+  proxyOfSlot.clear();
+  bodyOfProxy.clear();
+  grid.Clear();
+  gridBodies.clear();
+  bodyPairs.clear();
+  if (type == BroadphaseType::TREE) {
+    for (uint32_t i = 0; i < physicsWorld.GetBodyCount(); ++i)
+      CreateProxy(physicsWorld.GetHandle(i));
+  }
+}
+
+void Engine::Scene::UpdateBroadphase(float dt) {
+  // The grid is rebuilt from every body; the tree only moves awake ones.
+  const size_t count = broadphaseType == BroadphaseType::GRID
+                           ? physicsWorld.GetBodyCount()
+                           : physicsWorld.GetAwakeCount();
+  worldBounds.resize(count);
+  physicsWorld.ComputeWorldBounds(worldBounds.data(), count);
+  SweepContinuousBodies(dt);
+
+  bodyPairs.clear();
+  if (broadphaseType == BroadphaseType::GRID) {
+    grid.Build(worldBounds.data(), count);
+    grid.FindPairs(broadphasePairs);
+    gridBodies.resize(count);
+    for (uint32_t i = 0; i < count; ++i)
+      gridBodies[i] = physicsWorld.GetHandle(i);
+    for (const BroadphasePair& pair : broadphasePairs)
+      bodyPairs.push_back({gridBodies[pair.a], gridBodies[pair.b]});
+    return;
+  }
+
+  // Bodies still inside their fat boxes leave the tree untouched.
+  for (uint32_t i = 0; i < count; ++i) {
+    const RigidBodyHandle body = physicsWorld.GetHandle(i);
+    broadphase.MoveProxy(proxyOfSlot[body.slot], worldBounds[i],
+                         physicsWorld.GetLinearVelocity(body) * dt);
+  }
+  broadphase.UpdatePairs();
+  broadphasePairs.clear();
+  broadphase.GetOverlappingPairs(broadphasePairs);
+  for (const BroadphasePair& pair : broadphasePairs)
+    bodyPairs.push_back({bodyOfProxy[pair.a], bodyOfProxy[pair.b]});
+}
+
+void Engine::Scene::SweepContinuousBodies(float dt) {
+  for (RigidBodyHandle body : sweptBodies) sweepOfSlot[body.slot] = 0.0f;
+  sweptBodies.clear();
+  for (RigidBodyHandle body : physicsWorld.GetContinuousBodies()) {
+    if (!physicsWorld.IsAwake(body)) continue;
+    math::Vector3 displacement;
+    // A fast body's bounds cover its whole motion this step, so the
+    // broadphase pairs it with anything it could pass through.
+    if (physicsWorld.ComputeSweep(body, dt, displacement)) {
+      math::Aabb& box = worldBounds[physicsWorld.GetIndex(body)];
+      box = math::Aabb::Merge(
+          box, {box.min + displacement, box.max + displacement});
+    }
+    // Slower ones keep colliding speculatively, or a body stopped just
+    // short of a surface would sink into it on the next step.
+    if (sweepOfSlot.size() <= body.slot) sweepOfSlot.resize(body.slot + 1);
+    sweepOfSlot[body.slot] = std::sqrt(math::LengthSquared(displacement));
+    sweptBodies.push_back(body);
+  }
+}
+
+float Engine::Scene::GetSweep(RigidBodyHandle body) const {
+  return body.slot < sweepOfSlot.size() ? sweepOfSlot[body.slot] : 0.0f;
+}
+
+void Engine::Scene::UpdateContacts() {
+  contacts.BeginStep();
+  for (const RigidBodyPair& pair : bodyPairs) {
+    if (!physicsWorld.IsAlive(pair.a) || !physicsWorld.IsAlive(pair.b))
+      continue;
+    if (physicsWorld.GetInverseMass(pair.a) == 0.0f &&
+        physicsWorld.GetInverseMass(pair.b) == 0.0f)
+      continue;
+    Contact& contact = contacts.Acquire(pair.a, pair.b);
+    const bool awakeA = physicsWorld.IsAwake(contact.a);
+    const bool awakeB = physicsWorld.IsAwake(contact.b);
+    // Neither body moved: the contact stays as it was.
+    if (!awakeA && !awakeB) continue;
+    const bool wasTouching = contact.manifold.pointCount > 0;
+    ContactManifold manifold;
+    const float margin = GetSweep(contact.a) + GetSweep(contact.b);
+    if (margin > 0.0f) {
+      CollideSpeculative(physicsWorld.GetCollider(contact.a),
+                         physicsWorld.GetPose(contact.a),
+                         physicsWorld.GetCollider(contact.b),
+                         physicsWorld.GetPose(contact.b), margin, &contact.gjk,
+                         manifold);
+    } else {
+      Collide(physicsWorld.GetCollider(contact.a),
+              physicsWorld.GetPose(contact.a),
+              physicsWorld.GetCollider(contact.b),
+              physicsWorld.GetPose(contact.b), &contact.gjk, manifold);
+    }
+    ContactCache::Update(contact, manifold);
+    if (manifold.pointCount > 0) {
+      if (!awakeA) WakeIsland(contact.a);
+      if (!awakeB) WakeIsland(contact.b);
+      islandGraph.Link(contact.a, contact.b);
+    } else if (wasTouching) {
+      islandGraph.Unlink(contact.a, contact.b);
+    }
+  }
+  separatedPairs.clear();
+  contacts.EndStep(separatedPairs);
+  for (const RigidBodyPair& pair : separatedPairs)
+    islandGraph.Unlink(pair.a, pair.b);
+  islandGraph.MergeLinks();
+}
+
+void Engine::Scene::UpdateSleep(float dt) {
+  physicsWorld.UpdateSleepTimes(dt);
+  const float timeToSleep = physicsWorld.GetTimeToSleep();
+  islandGraph.BeginSleepCheck();
+  sleepyIslands.clear();
+  sleepyBodies.clear();
+  for (uint32_t i = 0; i < physicsWorld.GetAwakeCount(); ++i) {
+    const RigidBodyHandle body = physicsWorld.GetHandle(i);
+    const float time = physicsWorld.GetSleepTime(i);
+    const uint32_t island = islandGraph.GetIsland(body);
+    if (island == IslandGraph::noIsland) {
+      // Static bodies sleep on their own; no contact wakes them.
+      if (time >= timeToSleep) sleepyBodies.push_back(body);
+    } else if (islandGraph.ReportSleepTime(island, time)) {
+      sleepyIslands.push_back(island);
+    }
+  }
+
+  // An island that lost a link may hold a resting pile and a body that
+  // moved away. Split the one whose restful body waited longest, at most
+  // one per step, so its pieces can sleep apart.
+  uint32_t split = IslandGraph::noIsland;
+  float splitTime = timeToSleep;
+  for (uint32_t island : sleepyIslands) {
+    if (islandGraph.NeedsSplit(island)) {
+      if (islandGraph.GetMaxSleepTime(island) >= splitTime) {
+        split = island;
+        splitTime = islandGraph.GetMaxSleepTime(island);
+      }
+      continue;
+    }
+    if (islandGraph.GetMinSleepTime(island) < timeToSleep) continue;
+    islandGraph.ForEachBody(island, [&](RigidBodyHandle body) {
+      sleepyBodies.push_back(body);
+    });
+  }
+  for (RigidBodyHandle body : sleepyBodies) physicsWorld.SetAwake(body, false);
+  if (split != IslandGraph::noIsland)
+    islandGraph.Split(split, contacts.GetContacts());
+}
+
+void Engine::Scene::WakeIsland(RigidBodyHandle body) {
+  const uint32_t island = islandGraph.GetIsland(body);
+  if (island == IslandGraph::noIsland) return;
+  islandGraph.ForEachBody(island, [&](RigidBodyHandle member) {
+    physicsWorld.SetAwake(member, true);
+  });
+}
+
+void Engine::Scene::GetOverlappingBodies(
+    std::vector<RigidBodyPair>& out) const {
+  out.insert(out.end(), bodyPairs.begin(), bodyPairs.end());
+}
+
+void Engine::Scene::QueryBounds(const math::Aabb& box,
+                                std::vector<RigidBodyHandle>& out) const {
+  if (broadphaseType == BroadphaseType::GRID) {
+    // The grid holds the bounds of the last step; check the current ones.
+    grid.Query(box, [&](uint32_t index) {
+      const RigidBodyHandle body = gridBodies[index];
+      if (physicsWorld.IsAlive(body) &&
+          physicsWorld.GetWorldBounds(body).Overlaps(box))
+        out.push_back(body);
+      return true;
+    });
+    return;
+  }
+  broadphase.Query(box, [&](uint32_t proxy) {
+    const RigidBodyHandle body = bodyOfProxy[proxy];
+    if (physicsWorld.GetWorldBounds(body).Overlaps(box)) out.push_back(body);
+    return true;
+  });
+}
+
+bool Engine::Scene::RayCast(const math::Vector3& origin,
+                            const math::Vector3& direction, float maxDistance,
+                            RayHit& hit) const {
+  const math::Vector3 inverse(1.0f / direction.x, 1.0f / direction.y,
+                              1.0f / direction.z);
+  bool found = false;
+  // The bounds only pick the candidates; the hit is on the collider.
+  auto cast = [&](RigidBodyHandle body, float closest) {
+    float distance;
+    if (!physicsWorld.GetWorldBounds(body).IntersectsRay(origin, inverse,
+                                                         closest, distance) ||
+        !RayCastCollider(physicsWorld.GetCollider(body),
+                         physicsWorld.GetPose(body), origin, direction,
+                         closest, distance))
+      return closest;
+    found = true;
+    hit.body = body;
+    hit.distance = distance;
+    hit.point = math::MulAdd(origin, direction, distance);
+    // Only closer hits are of interest from here on.
+    return distance;
+  };
+  if (broadphaseType == BroadphaseType::GRID) {
+    // The grid holds the bounds of the last step; `cast` checks the
+    // current ones.
+    grid.RayCast(origin, direction, maxDistance,
+                 [&](uint32_t index, float closest) {
+                   const RigidBodyHandle body = gridBodies[index];
+                   return physicsWorld.IsAlive(body) ? cast(body, closest)
+                                                     : closest;
+                 });
+    return found;
+  }
+  broadphase.RayCast(origin, direction, maxDistance,
+                     [&](uint32_t proxy, float closest) {
+                       return cast(bodyOfProxy[proxy], closest);
+                     });
+  return found;
+}
+
+void Engine::Scene::SetInterpolationAlpha(float alpha) {
+  interpolationAlpha = alpha;
+}
+
+math::Affine3x4 Engine::Scene::GetInterpolatedTransform(
+    const GameObject& object) const {
+  return physicsWorld.GetInterpolatedTransform(object.GetRigidBody(),
+                                               interpolationAlpha);
+}
\ No newline at end of file
@@ -1,17 +1,142 @@
 #pragma once
 
+#include <Aabb.hpp>
+#include <ContactCache.hpp>
+#include <ContactSolver.hpp>
+#include <DynamicAabbTree.hpp>
 #include <GameObject.hpp>
+#include <IslandGraph.hpp>
+#include <JobSystem.hpp>
+#include <PhysicsWorld.hpp>
+#include <SceneCommands.hpp>
+#include <SpatialHashGrid.hpp>
 #include <memory>
 #include <vector>
 namespace Engine {
+// TREE suits bodies of mixed sizes and scenes where most bodies rest;
+// GRID suits many moving bodies of similar size, such as particles.
+enum class BroadphaseType { TREE, GRID };
+
 class Scene {
  private:
   std::vector<std::shared_ptr<GameObject>> sceneObjects;
+  PhysicsWorld physicsWorld;
+  float interpolationAlpha = 1.0f;
+  BroadphaseType broadphaseType = BroadphaseType::TREE;
+  // Tree broadphase over the bodies' world bounds, one proxy per body.
+  DynamicAabbTree broadphase;
+  std::vector<uint32_t> proxyOfSlot;
+  std::vector<RigidBodyHandle> bodyOfProxy;
+  // Grid broadphase, rebuilt every step. Grid indices are PhysicsWorld
+  // array indices at build time; gridBodies maps them to handles.
+  SpatialHashGrid grid;
+  std::vector<RigidBodyHandle> gridBodies;
+  // Pairs from either broadphase, refilled every step.
+  std::vector<BroadphasePair> broadphasePairs;
+  std::vector<RigidBodyPair> bodyPairs;
+  // Scratch space for the per-step bounds, in PhysicsWorld array order.
+  std::vector<math::Aabb> worldBounds;
+  ContactCache contacts;
+  ContactSolver solver;
+  // Persistent islands for sleeping, and per-step scratch.
+  IslandGraph islandGraph;
+  std::vector<RigidBodyPair> separatedPairs;
+  std::vector<uint32_t> sleepyIslands;
+  std::vector<RigidBodyHandle> sleepyBodies;
+  // Awake continuous bodies, and per slot the length of their motion this
+  // step, 0 for other bodies: the speculative margin of their pairs.
+  std::vector<RigidBodyHandle> sweptBodies;
+  std::vector<float> sweepOfSlot;
+  JobSystem* jobs = nullptr;
+  // Objects are updated in chunks, across the job system's threads when
+  // parallelUpdate is on. Each chunk records into its own command buffer,
+  // so buffers never depend on which thread runs a chunk.
+  bool parallelUpdate = false;
+  std::vector<std::vector<SceneCommands::Command>> commandBuffers;
+  // Scratch for applying the buffers.
+  std::vector<GameObject*> destroyedObjects;
+
+  void CreateProxy(RigidBodyHandle body);
+  void UpdateBroadphase(float dt);
+  void SweepContinuousBodies(float dt);
+  float GetSweep(RigidBodyHandle body) const;
+  void UpdateContacts();
+  void UpdateSleep(float dt);
+  void WakeIsland(RigidBodyHandle body);
+  void ApplyCommands();
 
  public:
   bool Initialize();
+  // Advances the simulation by exactly dt; driven by Engine's fixed step
+  // (see GameObject::FixedUpdate for the thread it runs on).
+  // Bodies sleep once every body of their island has been at rest for the
+  // world's time to sleep (see PhysicsWorld::SetTimeToSleep). Sleeping
+  // bodies are not integrated, moved in the tree broadphase, collided with
+  // each other or solved; a moving body touching one wakes its island.
+  // Fast continuous bodies (see PhysicsWorld::SetContinuous) are found by
+  // the broadphase along their whole motion and collide speculatively.
+  void FixedUpdate(float dt);
+  // Updates every object, then applies the commands they recorded.
   void Update();
   void Render();
   void Exit();
+
+  void AddGameObject(std::shared_ptr<GameObject> object);
+  // Creates a body in this scene's world and hands its handle to `object`.
+  RigidBodyHandle AddRigidBody(GameObject& object, const RigidBodyDesc& desc);
+  // Destroys the object's body and resets its handle.
+  void RemoveRigidBody(GameObject& object);
+  PhysicsWorld& GetPhysicsWorld();
+  ContactSolver& GetContactSolver() { return solver; }
+  // Threads for the physics step; Engine::AddScene passes its own. Null
+  // runs everything on the calling thread.
+  void SetJobSystem(JobSystem* jobSystem) {
+    jobs = jobSystem;
+    solver.SetJobSystem(jobSystem);
+    grid.SetJobSystem(jobSystem);
+  }
+  // Off by default. When on, Update runs objects' Update in parallel on
+  // the job system, so objects may read the scene and change only their
+  // own state; everything else goes through their SceneCommands.
+  void SetParallelUpdate(bool enabled) { parallelUpdate = enabled; }
+  bool IsParallelUpdate() const { return parallelUpdate; }
+
+  // Switching rebuilds the broadphase for the current bodies; the new one
+  // reports pairs after the next FixedUpdate.
+  void SetBroadphase(BroadphaseType type);
+  BroadphaseType GetBroadphase() const { return broadphaseType; }
+  // Grid cell size; 0, the default, sizes cells to the largest body.
+  void SetGridCellSize(float size) { grid.SetCellSize(size); }
+
+  struct RayHit {
+    RigidBodyHandle body;
+    float distance;
+    math::Vector3 point;
+  };
+
+  // Pairs of bodies whose bounds overlapped at the start of the last
+  // FixedUpdate, each once; the candidates for narrowphase collision. The
+  // tree compares fattened bounds and so reports a few more pairs than the
+  // grid. Bodies removed since then may still appear until the next one.
+  void GetOverlappingBodies(std::vector<RigidBodyPair>& out) const;
+  // Narrowphase results of the last FixedUpdate, one per overlapping pair
+  // with at least one dynamic body; pairs that do not touch have an empty
+  // manifold.
+  const std::vector<Contact>& GetContacts() const {
+    return contacts.GetContacts();
+  }
+  // Appends the bodies whose world bounds overlap `box`.
+  void QueryBounds(const math::Aabb& box,
+                   std::vector<RigidBodyHandle>& out) const;
+  // Closest body whose collider the ray hits within maxDistance; see
+  // RayCastCollider. `direction` must be normalized.
+  bool RayCast(const math::Vector3& origin, const math::Vector3& direction,
+               float maxDistance, RayHit& hit) const;
+
+  // Fraction of a fixed step elapsed since the last FixedUpdate, set by the
+  // Engine every frame.
+  void SetInterpolationAlpha(float alpha);
+  // Render pose of the object's body, blended between the last two steps.
+  math::Affine3x4 GetInterpolatedTransform(const GameObject& object) const;
 };
 }  // namespace Engine
\ No newline at end of file
@@ -0,0 +1,15 @@
+#include "SceneCommands.hpp"
+
+#include <utility>
+
+void Engine::SceneCommands::Spawn(std::shared_ptr<GameObject> object) {
+  buffer.push_back({Type::SPAWN, std::move(object), nullptr, {}});
+}
+
+void Engine::SceneCommands::Destroy(GameObject& object) {
+  buffer.push_back({Type::DESTROY, nullptr, &object, {}});
+}
+
+void Engine::SceneCommands::Defer(std::function<void(Scene&)> write) {
+  buffer.push_back({Type::WRITE, nullptr, nullptr, std::move(write)});
+}
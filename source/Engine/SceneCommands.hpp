@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace Engine {
+class GameObject;
+class Scene;
+
+// Changes to a scene that one object records during Scene::Update,
+// applied once every object has been updated. Commands apply in the order
+// of the objects that recorded them, each object's in the order recorded,
+// so the result does not depend on which thread updated which object.
+// Scene hands each object its own SceneCommands, over the buffer of the
+// chunk of objects being updated; use it only during that update.
+class SceneCommands {
+ private:
+  friend class Scene;
+
+  enum class Type { SPAWN, DESTROY, WRITE };
+  struct Command {
+    Type type;
+    std::shared_ptr<GameObject> spawned;
+    GameObject* destroyed;
+    std::function<void(Scene&)> write;
+  };
+
+  std::vector<Command>& buffer;
+
+  explicit SceneCommands(std::vector<Command>& buffer) : buffer(buffer) {}
+
+ public:
+  // Adds `object` to the scene and initializes it; its first update is in
+  // the next frame.
+  void Spawn(std::shared_ptr<GameObject> object);
+  // Removes `object` and its rigid body from the scene.
+  void Destroy(GameObject& object);
+  // Calls `write` with the scene, for changes to other objects or to the
+  // physics world.
+  void Defer(std::function<void(Scene&)> write);
+};
+}  // namespace Engine
@@ -0,0 +1,247 @@
+#include "SpatialHashGrid.hpp"
+
+#include <algorithm>
+#include <limits>
+
+namespace {
+// Cells after the own cell in (x, y, z) order; with the own cell this
+// visits every neighboring pair of cells exactly once.
+constexpr int32_t forwardNeighbors[13][3] = {
+    {0, 0, 1},  {0, 1, -1}, {0, 1, 0},  {0, 1, 1},  {1, -1, -1},
+    {1, -1, 0}, {1, -1, 1}, {1, 0, -1}, {1, 0, 0},  {1, 0, 1},
+    {1, 1, -1}, {1, 1, 0},  {1, 1, 1}};
+
+int32_t CellCoordinate(float value, float inverseCellSize) {
+  return static_cast<int32_t>(std::floor(value * inverseCellSize));
+}
+
+// Below this many boxes the passes are too short to be worth splitting.
+constexpr size_t minParallelBoxes = 4096;
+// FindPairs' work per box varies with the crowding around it, so it is cut
+// finer than Build's passes, for stealing to even it out.
+constexpr size_t pairRangesPerThread = 4;
+}  // namespace
+
+Engine::SpatialHashGrid::SpatialHashGrid(float cellSize)
+    : cellSize(cellSize) {}
+
+size_t Engine::SpatialHashGrid::Bucket(int32_t x, int32_t y, int32_t z) const {
+  // Linear index into the grid spanned by the occupied cells, wrapped onto
+  // the table. Unlike a scrambling hash this keeps neighboring cells in
+  // nearby buckets, so the neighbor walks in FindPairs stream through
+  // memory instead of jumping around it.
+  const uint64_t linear =
+      static_cast<uint64_t>(int64_t(x) - lowest[0]) +
+      strideY * static_cast<uint64_t>(int64_t(y) - lowest[1]) +
+      strideZ * static_cast<uint64_t>(int64_t(z) - lowest[2]);
+  return static_cast<size_t>(linear) & mask;
+}
+
+size_t Engine::SpatialHashGrid::RangeCount(size_t count,
+                                           size_t rangesPerThread) const {
+  if (jobs == nullptr || count < minParallelBoxes) return 1;
+  const size_t threads = jobs->GetThreadCount();
+  return threads <= 1 ? 1 : threads * rangesPerThread;
+}
+
+template <typename Body>
+void Engine::SpatialHashGrid::ForEachRange(size_t rangeCount,
+                                           Body&& body) const {
+  if (rangeCount <= 1) {
+    body(size_t(0));
+    return;
+  }
+  jobs->ParallelFor(
+      0, rangeCount,
+      [&](size_t first, size_t last) {
+        for (size_t range = first; range < last; ++range) body(range);
+      },
+      1);
+}
+
+void Engine::SpatialHashGrid::Build(const math::Aabb* boxes, size_t count) {
+  // Every pass works on the same slices of the boxes, in parallel.
+  const size_t rangeCount = RangeCount(count, 1);
+  ranges.resize(rangeCount);
+  auto first = [&](size_t range) { return count * range / rangeCount; };
+
+  ForEachRange(rangeCount, [&](size_t r) {
+    float largest = 0.0f;
+    for (size_t i = first(r); i < first(r + 1); ++i) {
+      const math::Vector3 size = boxes[i].max - boxes[i].min;
+      largest = std::max(largest, std::max(size.x, std::max(size.y, size.z)));
+    }
+    ranges[r].largest = largest;
+  });
+  float largest = 0.0f;
+  for (const Range& range : ranges) largest = std::max(largest, range.largest);
+  effectiveCellSize = std::max(cellSize, largest);
+  if (effectiveCellSize <= 0.0f) effectiveCellSize = 1.0f;
+  const float inverse = 1.0f / effectiveCellSize;
+
+  cells.resize(count);
+  ForEachRange(rangeCount, [&](size_t r) {
+    Range& range = ranges[r];
+    for (int axis = 0; axis < 3; ++axis) {
+      range.lower[axis] = std::numeric_limits<int32_t>::max();
+      range.upper[axis] = std::numeric_limits<int32_t>::min();
+    }
+    for (size_t i = first(r); i < first(r + 1); ++i) {
+      const math::Vector3 center = boxes[i].Center();
+      Entry& cell = cells[i];
+      cell.x = CellCoordinate(center.x, inverse);
+      cell.y = CellCoordinate(center.y, inverse);
+      cell.z = CellCoordinate(center.z, inverse);
+      cell.index = static_cast<uint32_t>(i);
+      const int32_t c[3] = {cell.x, cell.y, cell.z};
+      for (int axis = 0; axis < 3; ++axis) {
+        range.lower[axis] = std::min(range.lower[axis], c[axis]);
+        range.upper[axis] = std::max(range.upper[axis], c[axis]);
+      }
+    }
+  });
+  int32_t lower[3] = {0, 0, 0};
+  int32_t upper[3] = {0, 0, 0};
+  if (count > 0) {
+    for (int axis = 0; axis < 3; ++axis) {
+      lower[axis] = ranges[0].lower[axis];
+      upper[axis] = ranges[0].upper[axis];
+      for (const Range& range : ranges) {
+        lower[axis] = std::min(lower[axis], range.lower[axis]);
+        upper[axis] = std::max(upper[axis], range.upper[axis]);
+      }
+    }
+  }
+  // Odd strides, so rows and slabs that wrap around the table do not land
+  // on top of each other.
+  for (int axis = 0; axis < 3; ++axis) {
+    lowest[axis] = lower[axis];
+    highest[axis] = upper[axis];
+  }
+  const uint64_t spanX = static_cast<uint64_t>(int64_t(upper[0]) - lower[0]);
+  const uint64_t spanY = static_cast<uint64_t>(int64_t(upper[1]) - lower[1]);
+  strideY = (spanX + 1) | 1;
+  strideZ = (strideY * (spanY + 1)) | 1;
+
+  // Table size: a power of two with at least two buckets per box.
+  size_t tableSize = 64;
+  while (tableSize < count * 2) tableSize *= 2;
+  mask = tableSize - 1;
+  bucketStart.resize(tableSize + 1);
+  bucketOfBox.resize(count);
+  rangeOffsets.resize(rangeCount * tableSize);
+  ForEachRange(rangeCount, [&](size_t r) {
+    uint32_t* counts = &rangeOffsets[r * tableSize];
+    std::fill(counts, counts + tableSize, 0u);
+    for (size_t i = first(r); i < first(r + 1); ++i) {
+      bucketOfBox[i] =
+          static_cast<uint32_t>(Bucket(cells[i].x, cells[i].y, cells[i].z));
+      ++counts[bucketOfBox[i]];
+    }
+  });
+
+  // Counting sort. An exclusive prefix sum over the counts in (bucket,
+  // slice) order gives each slice's first position in each bucket, so
+  // filling forward keeps the boxes of a bucket in input order. The sum
+  // runs over blocks of buckets: block totals, a scan of those, then each
+  // block from its start.
+  auto firstBucket = [&](size_t block) {
+    return tableSize * block / rangeCount;
+  };
+  ForEachRange(rangeCount, [&](size_t block) {
+    uint32_t total = 0;
+    for (size_t r = 0; r < rangeCount; ++r) {
+      const uint32_t* counts = &rangeOffsets[r * tableSize];
+      for (size_t b = firstBucket(block); b < firstBucket(block + 1); ++b)
+        total += counts[b];
+    }
+    ranges[block].blockStart = total;
+  });
+  uint32_t position = 0;
+  for (Range& range : ranges) {
+    const uint32_t total = range.blockStart;
+    range.blockStart = position;
+    position += total;
+  }
+  ForEachRange(rangeCount, [&](size_t block) {
+    uint32_t next = ranges[block].blockStart;
+    for (size_t b = firstBucket(block); b < firstBucket(block + 1); ++b) {
+      bucketStart[b] = next;
+      for (size_t r = 0; r < rangeCount; ++r) {
+        uint32_t& offset = rangeOffsets[r * tableSize + b];
+        const uint32_t boxesInBucket = offset;
+        offset = next;
+        next += boxesInBucket;
+      }
+    }
+  });
+  bucketStart[tableSize] = static_cast<uint32_t>(count);
+
+  entries.resize(count);
+  sortedBoxes.resize(count);
+  ForEachRange(rangeCount, [&](size_t r) {
+    uint32_t* offsets = &rangeOffsets[r * tableSize];
+    for (size_t i = first(r); i < first(r + 1); ++i) {
+      const uint32_t position = offsets[bucketOfBox[i]]++;
+      entries[position] = cells[i];
+      sortedBoxes[position] = boxes[i];
+    }
+  });
+}
+
+void Engine::SpatialHashGrid::Clear() {
+  entries.clear();
+  sortedBoxes.clear();
+}
+
+void Engine::SpatialHashGrid::AddPairsOf(
+    uint32_t i, std::vector<BroadphasePair>& out) const {
+  const Entry& e = entries[i];
+  const math::Aabb& box = sortedBoxes[i];
+  auto emit = [&](uint32_t j) {
+    if (!box.Overlaps(sortedBoxes[j])) return;
+    const uint32_t other = entries[j].index;
+    out.push_back({std::min(e.index, other), std::max(e.index, other)});
+  };
+
+  // Later boxes of the same cell, which share its bucket.
+  const size_t own = Bucket(e.x, e.y, e.z);
+  for (uint32_t j = i + 1; j < bucketStart[own + 1]; ++j) {
+    const Entry& f = entries[j];
+    if (f.x == e.x && f.y == e.y && f.z == e.z) emit(j);
+  }
+  // Every box of the forward neighbor cells.
+  for (const auto& offset : forwardNeighbors) {
+    const int32_t x = e.x + offset[0];
+    const int32_t y = e.y + offset[1];
+    const int32_t z = e.z + offset[2];
+    const size_t bucket = Bucket(x, y, z);
+    for (uint32_t j = bucketStart[bucket]; j < bucketStart[bucket + 1]; ++j) {
+      const Entry& f = entries[j];
+      if (f.x == x && f.y == y && f.z == z) emit(j);
+    }
+  }
+}
+
+void Engine::SpatialHashGrid::FindPairs(
+    std::vector<BroadphasePair>& out) const {
+  out.clear();
+  const size_t count = entries.size();
+  const size_t rangeCount = RangeCount(count, pairRangesPerThread);
+  if (rangeCount == 1) {
+    for (uint32_t i = 0; i < count; ++i) AddPairsOf(i, out);
+    return;
+  }
+  // Each slice collects its own pairs; joined in slice order, they come
+  // out as in the serial loop.
+  if (pairBuffers.size() < rangeCount) pairBuffers.resize(rangeCount);
+  ForEachRange(rangeCount, [&](size_t r) {
+    std::vector<BroadphasePair>& pairs = pairBuffers[r];
+    pairs.clear();
+    const size_t end = count * (r + 1) / rangeCount;
+    for (size_t i = count * r / rangeCount; i < end; ++i)
+      AddPairsOf(static_cast<uint32_t>(i), pairs);
+  });
+  for (size_t r = 0; r < rangeCount; ++r)
+    out.insert(out.end(), pairBuffers[r].begin(), pairBuffers[r].end());
+}
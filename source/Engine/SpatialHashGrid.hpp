@@ -0,0 +1,246 @@
+#pragma once
+
+#include <Aabb.hpp>
+#include <JobSystem.hpp>
+#include <PairSet.hpp>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Engine {
+// Uniform grid broadphase for many bodies of similar size, rebuilt from
+// scratch every step. Each box is filed under the cell holding its center;
+// with cells at least as large as the largest box, overlapping boxes are
+// always in the same or adjacent cells. Cells are mapped into a table and
+// sorted into it with a counting sort, so a rebuild is a few linear passes
+// and, once the buffers have grown to the body count, allocates nothing.
+// With a job system, large grids run each pass over slices of the boxes in
+// parallel; the result does not depend on the thread count.
+class SpatialHashGrid {
+ private:
+  struct Entry {
+    int32_t x, y, z;
+    // Position of the box in the array passed to Build.
+    uint32_t index;
+  };
+
+  // What each slice of a parallel pass reports back.
+  struct Range {
+    float largest;
+    int32_t lower[3];
+    int32_t upper[3];
+    // Boxes in this slice's block of buckets, then the block's first
+    // position in `entries`.
+    uint32_t blockStart;
+  };
+
+  float cellSize;
+  float effectiveCellSize = 0.0f;
+  size_t mask = 0;
+  // Lowest and highest occupied cells, and the strides of the linear cell
+  // index.
+  int64_t lowest[3] = {0, 0, 0};
+  int64_t highest[3] = {0, 0, 0};
+  uint64_t strideY = 1;
+  uint64_t strideZ = 1;
+  // Entries of bucket b are entries[bucketStart[b], bucketStart[b + 1]).
+  std::vector<uint32_t> bucketStart;
+  std::vector<Entry> entries;
+  // Boxes in the same order as `entries`, so neighbor tests read memory
+  // sequentially within a bucket.
+  std::vector<math::Aabb> sortedBoxes;
+  // Scratch space in input order.
+  std::vector<Entry> cells;
+  std::vector<uint32_t> bucketOfBox;
+
+  JobSystem* jobs = nullptr;
+  std::vector<Range> ranges;
+  // Per slice of the boxes, one counter per bucket, slice after slice:
+  // first the slice's boxes in the bucket, then where the first of them
+  // goes.
+  std::vector<uint32_t> rangeOffsets;
+  // Pairs found by each slice of a parallel FindPairs.
+  mutable std::vector<std::vector<BroadphasePair>> pairBuffers;
+
+  size_t Bucket(int32_t x, int32_t y, int32_t z) const;
+  // Slices to split `count` boxes into: one without parallelism.
+  size_t RangeCount(size_t count, size_t rangesPerThread) const;
+  // Calls body(range) for every range in [0, rangeCount), in parallel.
+  template <typename Body>
+  void ForEachRange(size_t rangeCount, Body&& body) const;
+  // Pairs of entry i with the entries after it in its cell and with those
+  // of its forward neighbor cells.
+  void AddPairsOf(uint32_t i, std::vector<BroadphasePair>& out) const;
+
+ public:
+  // 0 sizes the cells to the largest box of each Build. A larger size is
+  // used as given; a smaller one is raised to the largest box.
+  explicit SpatialHashGrid(float cellSize = 0.0f);
+
+  void SetCellSize(float size) { cellSize = size; }
+  // Null, the default, builds and finds pairs on the calling thread only.
+  void SetJobSystem(JobSystem* jobSystem) { jobs = jobSystem; }
+  // Cell size used by the last Build.
+  float GetCellSize() const { return effectiveCellSize; }
+  size_t GetBoxCount() const { return entries.size(); }
+
+  void Build(const math::Aabb* boxes, size_t count);
+  // Empties the grid but keeps its memory.
+  void Clear();
+  // Replaces the contents of `out` with every pair of overlapping boxes,
+  // as indices into the array given to Build, each once.
+  void FindPairs(std::vector<BroadphasePair>& out) const;
+
+  // Calls callback(index) for every box overlapping `box`; the walk stops
+  // early when the callback returns false.
+  template <typename Callback>
+  void Query(const math::Aabb& box, Callback&& callback) const;
+  // Walks the boxes the ray origin + t * direction, 0 <= t <= maxDistance,
+  // passes through, stepping from cell to cell along the ray (3D-DDA), so
+  // near boxes come before far ones. callback(index, maxDistance) returns
+  // the new maximum distance: the distance of a hit to clip the ray,
+  // maxDistance to keep going, or 0 to stop.
+  template <typename Callback>
+  void RayCast(const math::Vector3& origin, const math::Vector3& direction,
+               float maxDistance, Callback&& callback) const;
+};
+
+template <typename Callback>
+void SpatialHashGrid::Query(const math::Aabb& box, Callback&& callback) const {
+  if (entries.empty()) return;
+  // A box reaches at most into the cells next to its own.
+  const float inverse = 1.0f / effectiveCellSize;
+  const float lower[3] = {box.min.x * inverse - 1.0f,
+                          box.min.y * inverse - 1.0f,
+                          box.min.z * inverse - 1.0f};
+  const float upper[3] = {box.max.x * inverse + 1.0f,
+                          box.max.y * inverse + 1.0f,
+                          box.max.z * inverse + 1.0f};
+  double cellCount = 1.0;
+  for (int axis = 0; axis < 3; ++axis)
+    cellCount *= std::floor(upper[axis]) - std::floor(lower[axis]) + 1.0;
+
+  // Large queries are cheaper as a plain scan.
+  if (cellCount >= static_cast<double>(entries.size())) {
+    for (size_t i = 0; i < entries.size(); ++i) {
+      if (sortedBoxes[i].Overlaps(box) && !callback(entries[i].index)) return;
+    }
+    return;
+  }
+
+  const int32_t x0 = static_cast<int32_t>(std::floor(lower[0]));
+  const int32_t y0 = static_cast<int32_t>(std::floor(lower[1]));
+  const int32_t z0 = static_cast<int32_t>(std::floor(lower[2]));
+  const int32_t x1 = static_cast<int32_t>(std::floor(upper[0]));
+  const int32_t y1 = static_cast<int32_t>(std::floor(upper[1]));
+  const int32_t z1 = static_cast<int32_t>(std::floor(upper[2]));
+  for (int32_t x = x0; x <= x1; ++x) {
+    for (int32_t y = y0; y <= y1; ++y) {
+      for (int32_t z = z0; z <= z1; ++z) {
+        const size_t bucket = Bucket(x, y, z);
+        for (uint32_t i = bucketStart[bucket]; i < bucketStart[bucket + 1];
+             ++i) {
+          const Entry& e = entries[i];
+          if (e.x != x || e.y != y || e.z != z) continue;
+          if (sortedBoxes[i].Overlaps(box) && !callback(e.index)) return;
+        }
+      }
+    }
+  }
+}
+
+template <typename Callback>
+void SpatialHashGrid::RayCast(const math::Vector3& origin,
+                              const math::Vector3& direction,
+                              float maxDistance, Callback&& callback) const {
+  if (entries.empty()) return;
+  const math::Vector3 inverse(1.0f / direction.x, 1.0f / direction.y,
+                              1.0f / direction.z);
+  // A box lies within one cell of the cell holding its center, so the ray
+  // can only hit boxes filed next to the cells it crosses, and only inside
+  // the occupied cells grown by one.
+  const float size = effectiveCellSize;
+  const math::Aabb occupied{
+      math::Vector3(float(lowest[0] - 1) * size, float(lowest[1] - 1) * size,
+                    float(lowest[2] - 1) * size),
+      math::Vector3(float(highest[0] + 2) * size, float(highest[1] + 2) * size,
+                    float(highest[2] + 2) * size)};
+  float start;
+  if (!occupied.IntersectsRay(origin, inverse, maxDistance, start)) return;
+
+  const float o[3] = {origin.x, origin.y, origin.z};
+  const float d[3] = {direction.x, direction.y, direction.z};
+  int32_t cell[3];
+  int32_t step[3];
+  // Distance along the ray to the next cell boundary on each axis, and
+  // between boundaries.
+  float next[3];
+  float delta[3];
+  for (int axis = 0; axis < 3; ++axis) {
+    const float entry = std::floor((o[axis] + d[axis] * start) / size);
+    cell[axis] = static_cast<int32_t>(
+        std::min(std::max(static_cast<int64_t>(entry), lowest[axis] - 1),
+                 highest[axis] + 1));
+    if (d[axis] > 0.0f) {
+      step[axis] = 1;
+      next[axis] = (float(cell[axis] + 1) * size - o[axis]) / d[axis];
+      delta[axis] = size / d[axis];
+    } else if (d[axis] < 0.0f) {
+      step[axis] = -1;
+      next[axis] = (float(cell[axis]) * size - o[axis]) / d[axis];
+      delta[axis] = -size / d[axis];
+    } else {
+      step[axis] = 0;
+      next[axis] = INFINITY;
+      delta[axis] = INFINITY;
+    }
+  }
+
+  // Offers the boxes filed in cells low..high; false once the callback
+  // stops the walk.
+  auto visit = [&](const int32_t(&low)[3], const int32_t(&high)[3]) {
+    for (int32_t x = low[0]; x <= high[0]; ++x) {
+      for (int32_t y = low[1]; y <= high[1]; ++y) {
+        for (int32_t z = low[2]; z <= high[2]; ++z) {
+          const size_t bucket = Bucket(x, y, z);
+          for (uint32_t i = bucketStart[bucket]; i < bucketStart[bucket + 1];
+               ++i) {
+            const Entry& e = entries[i];
+            if (e.x != x || e.y != y || e.z != z) continue;
+            float distance;
+            if (!sortedBoxes[i].IntersectsRay(origin, inverse, maxDistance,
+                                              distance))
+              continue;
+            maxDistance = callback(e.index, maxDistance);
+            if (maxDistance <= 0.0f) return false;
+          }
+        }
+      }
+    }
+    return true;
+  };
+
+  int32_t low[3] = {cell[0] - 1, cell[1] - 1, cell[2] - 1};
+  int32_t high[3] = {cell[0] + 1, cell[1] + 1, cell[2] + 1};
+  if (!visit(low, high)) return;
+  for (;;) {
+    int axis = next[0] < next[1] ? 0 : 1;
+    if (next[2] < next[axis]) axis = 2;
+    // Boxes not offered yet start past the boundary ahead.
+    if (step[axis] == 0 || next[axis] > maxDistance) return;
+    cell[axis] += step[axis];
+    next[axis] += delta[axis];
+    // Past the occupied cells, and moving away from them.
+    if (cell[axis] < lowest[axis] - 1 || cell[axis] > highest[axis] + 1)
+      return;
+    // Each step brings one new slab of cells within one of the ray.
+    for (int other = 0; other < 3; ++other) {
+      low[other] = cell[other] - 1;
+      high[other] = cell[other] + 1;
+    }
+    low[axis] = high[axis] = cell[axis] + step[axis];
+    if (!visit(low, high)) return;
+  }
+}
+}  // namespace Engine
@@ -0,0 +1,215 @@
+#include "SweepAndPrune.hpp"
+
+#include <algorithm>
+
+namespace {
+// Orders by value; at equal values a lower bound comes first, so touching
+// boxes count as overlapping like in Aabb::Overlaps.
+template <typename Endpoint>
+bool Less(const Endpoint& a, const Endpoint& b) {
+  return a.value < b.value ||
+         (a.value == b.value && (a.data & 1) == 0 && (b.data & 1) != 0);
+}
+
+float Component(const math::Vector3& v, int axis) {
+  return axis == 0 ? v.x : (axis == 1 ? v.y : v.z);
+}
+}  // namespace
+
+Engine::SweepAndPrune::SweepAndPrune(unsigned axisMask) {
+  for (int axis = 0; axis < 3; ++axis) {
+    if (axisMask & (1u << axis)) sortedAxes[sortedAxisCount++] = axis;
+  }
+  // At least one axis has to be swept.
+  if (sortedAxisCount == 0) sortedAxes[sortedAxisCount++] = 0;
+}
+
+uint32_t Engine::SweepAndPrune::CreateProxy(const math::Aabb& box,
+                                            uint32_t userData) {
+  uint32_t id;
+  if (freeProxies.empty()) {
+    id = static_cast<uint32_t>(proxies.size());
+    proxies.emplace_back();
+  } else {
+    id = freeProxies.back();
+    freeProxies.pop_back();
+  }
+  Proxy& proxy = proxies[id];
+  for (int axis = 0; axis < 3; ++axis) {
+    proxy.min[axis] = Component(box.min, axis);
+    proxy.max[axis] = Component(box.max, axis);
+  }
+  proxy.userData = userData;
+  proxy.alive = true;
+  // New endpoints start at the end and are sorted into place by Update.
+  for (int i = 0; i < sortedAxisCount; ++i) {
+    const int axis = sortedAxes[i];
+    auto& list = endpoints[axis];
+    proxy.minIndex[axis] = static_cast<uint32_t>(list.size());
+    list.push_back({proxy.min[axis], id << 1});
+    proxy.maxIndex[axis] = static_cast<uint32_t>(list.size());
+    list.push_back({proxy.max[axis], (id << 1) | 1});
+  }
+  ++createdSinceUpdate;
+  ++proxyCount;
+  return id;
+}
+
+void Engine::SweepAndPrune::DestroyProxy(uint32_t proxy) {
+  proxies[proxy].alive = false;
+  destroyedProxies.push_back(proxy);
+  --proxyCount;
+}
+
+void Engine::SweepAndPrune::MoveProxy(uint32_t proxy, const math::Aabb& box) {
+  Proxy& p = proxies[proxy];
+  for (int axis = 0; axis < 3; ++axis) {
+    p.min[axis] = Component(box.min, axis);
+    p.max[axis] = Component(box.max, axis);
+  }
+  for (int i = 0; i < sortedAxisCount; ++i) {
+    const int axis = sortedAxes[i];
+    endpoints[axis][p.minIndex[axis]].value = p.min[axis];
+    endpoints[axis][p.maxIndex[axis]].value = p.max[axis];
+  }
+}
+
+math::Aabb Engine::SweepAndPrune::GetBox(uint32_t proxy) const {
+  const Proxy& p = proxies[proxy];
+  return {math::Vector3(p.min[0], p.min[1], p.min[2]),
+          math::Vector3(p.max[0], p.max[1], p.max[2])};
+}
+
+uint32_t Engine::SweepAndPrune::GetUserData(uint32_t proxy) const {
+  return proxies[proxy].userData;
+}
+
+bool Engine::SweepAndPrune::OverlapsOnSortedAxes(const Proxy& a,
+                                                 const Proxy& b) const {
+  for (int i = 0; i < sortedAxisCount; ++i) {
+    const int axis = sortedAxes[i];
+    if (a.min[axis] > b.max[axis] || a.max[axis] < b.min[axis]) return false;
+  }
+  return true;
+}
+
+bool Engine::SweepAndPrune::OverlapsOnAllAxes(const Proxy& a,
+                                              const Proxy& b) const {
+  for (int axis = 0; axis < 3; ++axis) {
+    if (a.min[axis] > b.max[axis] || a.max[axis] < b.min[axis]) return false;
+  }
+  return true;
+}
+
+void Engine::SweepAndPrune::SortAxis(int axis) {
+  auto& list = endpoints[axis];
+  for (size_t i = 1; i < list.size(); ++i) {
+    const Endpoint e = list[i];
+    if (!Less(e, list[i - 1])) continue;
+    const uint32_t proxyE = e.data >> 1;
+    const bool upperE = (e.data & 1) != 0;
+    size_t j = i;
+    do {
+      const Endpoint f = list[j - 1];
+      const uint32_t proxyF = f.data >> 1;
+      const bool upperF = (f.data & 1) != 0;
+      if (proxyE != proxyF) {
+        // A lower bound passing an upper bound starts an overlap on this
+        // axis; the reverse ends one.
+        if (!upperE && upperF) {
+          if (OverlapsOnSortedAxes(proxies[proxyE], proxies[proxyF]))
+            pairs.Insert(proxyE, proxyF);
+        } else if (upperE && !upperF) {
+          pairs.Erase(proxyE, proxyF);
+        }
+      }
+      list[j] = f;
+      Proxy& moved = proxies[proxyF];
+      (upperF ? moved.maxIndex : moved.minIndex)[axis] =
+          static_cast<uint32_t>(j);
+      --j;
+    } while (j > 0 && Less(e, list[j - 1]));
+    list[j] = e;
+    Proxy& p = proxies[proxyE];
+    (upperE ? p.maxIndex : p.minIndex)[axis] = static_cast<uint32_t>(j);
+  }
+}
+
+void Engine::SweepAndPrune::Rebuild() {
+  for (int i = 0; i < sortedAxisCount; ++i) {
+    const int axis = sortedAxes[i];
+    auto& list = endpoints[axis];
+    std::sort(list.begin(), list.end(), Less<Endpoint>);
+    for (size_t j = 0; j < list.size(); ++j) {
+      Proxy& p = proxies[list[j].data >> 1];
+      ((list[j].data & 1) ? p.maxIndex : p.minIndex)[axis] =
+          static_cast<uint32_t>(j);
+    }
+  }
+
+  // One sweep along the first axis finds every pair from scratch.
+  pairs.Clear();
+  active.clear();
+  for (const Endpoint& e : endpoints[sortedAxes[0]]) {
+    const uint32_t id = e.data >> 1;
+    if (e.data & 1) {
+      auto it = std::find(active.begin(), active.end(), id);
+      *it = active.back();
+      active.pop_back();
+      continue;
+    }
+    for (uint32_t other : active) {
+      if (OverlapsOnSortedAxes(proxies[id], proxies[other]))
+        pairs.Insert(id, other);
+    }
+    active.push_back(id);
+  }
+}
+
+void Engine::SweepAndPrune::Update() {
+  if (!destroyedProxies.empty()) {
+    // Forget destroyed proxies: drop their pairs and close the gaps their
+    // endpoints leave.
+    stalePairs.clear();
+    for (const BroadphasePair& pair : pairs.GetPairs()) {
+      if (!proxies[pair.a].alive || !proxies[pair.b].alive)
+        stalePairs.push_back(pair);
+    }
+    for (const BroadphasePair& pair : stalePairs) pairs.Erase(pair.a, pair.b);
+    for (int i = 0; i < sortedAxisCount; ++i) {
+      const int axis = sortedAxes[i];
+      auto& list = endpoints[axis];
+      list.erase(std::remove_if(list.begin(), list.end(),
+                                [this](const Endpoint& e) {
+                                  return !proxies[e.data >> 1].alive;
+                                }),
+                 list.end());
+      for (size_t j = 0; j < list.size(); ++j) {
+        Proxy& p = proxies[list[j].data >> 1];
+        ((list[j].data & 1) ? p.maxIndex : p.minIndex)[axis] =
+            static_cast<uint32_t>(j);
+      }
+    }
+    freeProxies.insert(freeProxies.end(), destroyedProxies.begin(),
+                       destroyedProxies.end());
+    destroyedProxies.clear();
+  }
+
+  // Each new proxy is an insertion sort pass over the whole list, so large
+  // batches of new proxies are cheaper to sort from scratch.
+  if (createdSinceUpdate > 64 && createdSinceUpdate * 4 > proxyCount) {
+    Rebuild();
+  } else {
+    for (int i = 0; i < sortedAxisCount; ++i) SortAxis(sortedAxes[i]);
+  }
+  createdSinceUpdate = 0;
+}
+
+void Engine::SweepAndPrune::GetOverlappingPairs(
+    std::vector<BroadphasePair>& out) const {
+  for (const BroadphasePair& pair : pairs.GetPairs()) {
+    if (sortedAxisCount == 3 ||
+        OverlapsOnAllAxes(proxies[pair.a], proxies[pair.b]))
+      out.push_back(pair);
+  }
+}
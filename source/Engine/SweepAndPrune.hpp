@@ -0,0 +1,75 @@
+#pragma once
+
+#include <Aabb.hpp>
+#include <PairSet.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Engine {
+// Sweep-and-prune broadphase. Box endpoints are kept sorted along each
+// enabled axis; Update re-sorts them with insertion sort, which is close to
+// O(n) when boxes move a little per frame, and turns every swap of a lower
+// and an upper endpoint into an incremental pair insert or erase.
+class SweepAndPrune {
+ public:
+  enum Axis : unsigned { AXIS_X = 1, AXIS_Y = 2, AXIS_Z = 4 };
+
+ private:
+  struct Endpoint {
+    float value;
+    // proxy << 1 | 1 for an upper bound.
+    uint32_t data;
+  };
+
+  struct Proxy {
+    float min[3];
+    float max[3];
+    uint32_t userData;
+    // Position of the proxy's endpoints in each axis array.
+    uint32_t minIndex[3];
+    uint32_t maxIndex[3];
+    bool alive;
+  };
+
+  int sortedAxes[3];
+  int sortedAxisCount = 0;
+  std::vector<Endpoint> endpoints[3];
+  std::vector<Proxy> proxies;
+  std::vector<uint32_t> freeProxies;
+  // Proxies destroyed since the last Update; their ids are reused after it.
+  std::vector<uint32_t> destroyedProxies;
+  size_t createdSinceUpdate = 0;
+  size_t proxyCount = 0;
+  PairSet pairs;
+  // Scratch space, kept to avoid allocating every Update.
+  std::vector<uint32_t> active;
+  std::vector<BroadphasePair> stalePairs;
+
+  bool OverlapsOnSortedAxes(const Proxy& a, const Proxy& b) const;
+  bool OverlapsOnAllAxes(const Proxy& a, const Proxy& b) const;
+  void SortAxis(int axis);
+  void Rebuild();
+
+ public:
+  // Endpoints are sorted along the axes in `axisMask`. Sorting all three
+  // gives exact pairs; leaving out an axis most boxes overlap on (e.g. up
+  // for bodies resting on a floor) keeps the pair set small and the
+  // remaining axis is tested when the pairs are read.
+  explicit SweepAndPrune(unsigned axisMask = AXIS_X | AXIS_Y | AXIS_Z);
+
+  // Returns a proxy id; ids of destroyed proxies are reused.
+  uint32_t CreateProxy(const math::Aabb& box, uint32_t userData);
+  void DestroyProxy(uint32_t proxy);
+  // New bounds take effect at the next Update.
+  void MoveProxy(uint32_t proxy, const math::Aabb& box);
+  math::Aabb GetBox(uint32_t proxy) const;
+  uint32_t GetUserData(uint32_t proxy) const;
+  size_t GetProxyCount() const { return proxyCount; }
+
+  // Re-sorts the endpoints and brings the pair set up to date.
+  void Update();
+  // Appends every overlapping pair of proxy ids, each exactly once.
+  void GetOverlappingPairs(std::vector<BroadphasePair>& out) const;
+};
+}  // namespace Engine
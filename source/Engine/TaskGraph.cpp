@@ -0,0 +1,139 @@
+#include "TaskGraph.hpp"
+
+#include <utility>
+
+namespace {
+constexpr uint32_t noTask = 0xFFFFFFFFu;
+}  // namespace
+
+uint32_t Engine::TaskGraph::GetResource(const std::string& name) {
+  for (uint32_t i = 0; i < resources.size(); ++i) {
+    if (resources[i] == name) return i;
+  }
+  resources.push_back(name);
+  return static_cast<uint32_t>(resources.size() - 1);
+}
+
+uint32_t Engine::TaskGraph::AddTask(std::string name,
+                                    std::vector<uint32_t> reads,
+                                    std::vector<uint32_t> writes,
+                                    std::function<void()> function,
+                                    TaskAffinity affinity) {
+  Task task;
+  task.name = std::move(name);
+  task.reads = std::move(reads);
+  task.writes = std::move(writes);
+  task.function = std::move(function);
+  task.affinity = affinity;
+  task.predecessorCount = 0;
+  tasks.push_back(std::move(task));
+  built = false;
+  return static_cast<uint32_t>(tasks.size() - 1);
+}
+
+void Engine::TaskGraph::Clear() {
+  tasks.clear();
+  resources.clear();
+  roots.clear();
+  mainTaskCount = 0;
+  built = true;
+}
+
+uint32_t Engine::TaskGraph::GetPredecessorCount(uint32_t task) {
+  if (!built) Build();
+  return tasks[task].predecessorCount;
+}
+
+void Engine::TaskGraph::Build() {
+  const uint32_t count = static_cast<uint32_t>(tasks.size());
+  // Per resource: the last task to write it, and the tasks that read it
+  // since then.
+  std::vector<uint32_t> lastWriter(resources.size(), noTask);
+  std::vector<std::vector<uint32_t>> readers(resources.size());
+  // The task that last got an edge from each task, so edges are unique.
+  std::vector<uint32_t> linkedTo(count, noTask);
+  for (Task& task : tasks) {
+    task.successors.clear();
+    task.predecessorCount = 0;
+  }
+  auto link = [&](uint32_t from, uint32_t to) {
+    if (from == noTask || from == to || linkedTo[from] == to) return;
+    linkedTo[from] = to;
+    tasks[from].successors.push_back(to);
+    ++tasks[to].predecessorCount;
+  };
+
+  roots.clear();
+  mainTaskCount = 0;
+  for (uint32_t t = 0; t < count; ++t) {
+    const Task& task = tasks[t];
+    for (uint32_t resource : task.reads) link(lastWriter[resource], t);
+    for (uint32_t resource : task.writes) {
+      link(lastWriter[resource], t);
+      for (uint32_t reader : readers[resource]) link(reader, t);
+    }
+    for (uint32_t resource : task.reads) readers[resource].push_back(t);
+    for (uint32_t resource : task.writes) {
+      lastWriter[resource] = t;
+      readers[resource].clear();
+    }
+    if (task.predecessorCount == 0) roots.push_back(t);
+    if (task.affinity == TaskAffinity::MAIN_THREAD) ++mainTaskCount;
+  }
+  waiting.reset(new std::atomic<uint32_t>[count]);
+  built = true;
+}
+
+void Engine::TaskGraph::Schedule(uint32_t task) {
+  if (tasks[task].affinity == TaskAffinity::MAIN_THREAD) {
+    {
+      std::lock_guard<std::mutex> lock(mainMutex);
+      mainReady.push_back(task);
+    }
+    mainWake.notify_one();
+    return;
+  }
+  jobs->Run(
+      [this, task] {
+        tasks[task].function();
+        Complete(task);
+      },
+      &running);
+}
+
+void Engine::TaskGraph::Complete(uint32_t task) {
+  // Successors are queued before this task's job is done, so `running`
+  // stays above zero until the last task finishes.
+  for (uint32_t successor : tasks[task].successors) {
+    if (waiting[successor].fetch_sub(1, std::memory_order_acq_rel) == 1)
+      Schedule(successor);
+  }
+}
+
+void Engine::TaskGraph::Run(JobSystem& jobSystem) {
+  if (!built) Build();
+  if (jobSystem.GetThreadCount() <= 1) {
+    // The order tasks were added in respects every edge.
+    for (Task& task : tasks) task.function();
+    return;
+  }
+
+  jobs = &jobSystem;
+  for (uint32_t t = 0; t < tasks.size(); ++t)
+    waiting[t].store(tasks[t].predecessorCount, std::memory_order_relaxed);
+  for (uint32_t root : roots) Schedule(root);
+
+  // Main-thread tasks as they become ready; the workers run the rest.
+  for (uint32_t left = mainTaskCount; left > 0; --left) {
+    uint32_t task;
+    {
+      std::unique_lock<std::mutex> lock(mainMutex);
+      mainWake.wait(lock, [&] { return !mainReady.empty(); });
+      task = mainReady.back();
+      mainReady.pop_back();
+    }
+    tasks[task].function();
+    Complete(task);
+  }
+  jobSystem.Wait(running);
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <JobSystem.hpp>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace Engine {
+// MAIN_THREAD tasks run on the thread that calls TaskGraph::Run, the one
+// that owns the window and the GL context; ANY_THREAD tasks run on the job
+// system's workers.
+enum class TaskAffinity { ANY_THREAD, MAIN_THREAD };
+
+// Stages of a frame and the resources each reads and writes, built once
+// and run every frame. Edges come from the declarations: a task waits for
+// the tasks added before it that write a resource it reads, or that read
+// or write one it writes. The result is that of running the tasks in the
+// order they were added, while tasks that share nothing run side by side.
+class TaskGraph {
+ private:
+  struct Task {
+    std::string name;
+    std::vector<uint32_t> reads;
+    std::vector<uint32_t> writes;
+    std::function<void()> function;
+    TaskAffinity affinity;
+    std::vector<uint32_t> successors;
+    uint32_t predecessorCount;
+  };
+
+  std::vector<std::string> resources;
+  std::vector<Task> tasks;
+  std::vector<uint32_t> roots;
+  uint32_t mainTaskCount = 0;
+  bool built = true;
+
+  // State of the current Run.
+  JobSystem* jobs = nullptr;
+  std::unique_ptr<std::atomic<uint32_t>[]> waiting;
+  JobCounter running;
+  std::mutex mainMutex;
+  std::condition_variable mainWake;
+  std::vector<uint32_t> mainReady;
+
+  void Build();
+  void Schedule(uint32_t task);
+  // Releases the task's successors.
+  void Complete(uint32_t task);
+
+ public:
+  // Id of the named resource, added on first use, so subsystems agree on
+  // a resource by its name.
+  uint32_t GetResource(const std::string& name);
+  // Returns the task's index. The graph is rebuilt on the next Run.
+  uint32_t AddTask(std::string name, std::vector<uint32_t> reads,
+                   std::vector<uint32_t> writes,
+                   std::function<void()> function,
+                   TaskAffinity affinity = TaskAffinity::ANY_THREAD);
+  void Clear();
+  size_t GetTaskCount() const { return tasks.size(); }
+  const std::string& GetTaskName(uint32_t task) const {
+    return tasks[task].name;
+  }
+  // Tasks that must finish before `task` may start.
+  uint32_t GetPredecessorCount(uint32_t task);
+
+  // Runs every task once and returns when all are done. Must be called
+  // from the main thread, and not from inside a task. Without workers the
+  // tasks run in the order they were added.
+  void Run(JobSystem& jobSystem);
+};
+}  // namespace Engine
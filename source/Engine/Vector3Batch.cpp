@@ -0,0 +1,236 @@
+#include "Vector3Batch.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#include "BatchKernels.hpp"
+
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define VECTOR3_BATCH_SSE 1
+#include <immintrin.h>
+#endif
+
+namespace {
+#ifdef VECTOR3_BATCH_SSE
+float HorizontalMin(__m128 v) {
+  v = _mm_min_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 0, 3, 2)));
+  v = _mm_min_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1)));
+  return _mm_cvtss_f32(v);
+}
+
+float HorizontalMax(__m128 v) {
+  v = _mm_max_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 0, 3, 2)));
+  v = _mm_max_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1)));
+  return _mm_cvtss_f32(v);
+}
+#endif
+
+float ReduceMin(const float* values, size_t count) {
+  size_t i = 0;
+  float result = values[0];
+#ifdef VECTOR3_BATCH_SSE
+  if (count >= 16) {
+    // Four independent accumulators hide the latency of minps.
+    __m128 m0 = _mm_load_ps(values + 0);
+    __m128 m1 = _mm_load_ps(values + 4);
+    __m128 m2 = _mm_load_ps(values + 8);
+    __m128 m3 = _mm_load_ps(values + 12);
+    for (i = 16; i + 16 <= count; i += 16) {
+      m0 = _mm_min_ps(m0, _mm_load_ps(values + i + 0));
+      m1 = _mm_min_ps(m1, _mm_load_ps(values + i + 4));
+      m2 = _mm_min_ps(m2, _mm_load_ps(values + i + 8));
+      m3 = _mm_min_ps(m3, _mm_load_ps(values + i + 12));
+    }
+    result = HorizontalMin(_mm_min_ps(_mm_min_ps(m0, m1), _mm_min_ps(m2, m3)));
+  }
+#endif
+  for (; i < count; ++i) result = std::min(result, values[i]);
+  return result;
+}
+
+float ReduceMax(const float* values, size_t count) {
+  size_t i = 0;
+  float result = values[0];
+#ifdef VECTOR3_BATCH_SSE
+  if (count >= 16) {
+    // Four independent accumulators hide the latency of maxps.
+    __m128 m0 = _mm_load_ps(values + 0);
+    __m128 m1 = _mm_load_ps(values + 4);
+    __m128 m2 = _mm_load_ps(values + 8);
+    __m128 m3 = _mm_load_ps(values + 12);
+    for (i = 16; i + 16 <= count; i += 16) {
+      m0 = _mm_max_ps(m0, _mm_load_ps(values + i + 0));
+      m1 = _mm_max_ps(m1, _mm_load_ps(values + i + 4));
+      m2 = _mm_max_ps(m2, _mm_load_ps(values + i + 8));
+      m3 = _mm_max_ps(m3, _mm_load_ps(values + i + 12));
+    }
+    result = HorizontalMax(_mm_max_ps(_mm_max_ps(m0, m1), _mm_max_ps(m2, m3)));
+  }
+#endif
+  for (; i < count; ++i) result = std::max(result, values[i]);
+  return result;
+}
+}  // namespace
+
+math::Vector3Batch::Vector3Batch(size_t count)
+    : xs(count, 0.0f), ys(count, 0.0f), zs(count, 0.0f) {}
+
+math::Vector3Batch::Vector3Batch(const Vector3* values, size_t count) {
+  FromAoS(values, count);
+}
+
+void math::Vector3Batch::Resize(size_t count) {
+  xs.resize(count, 0.0f);
+  ys.resize(count, 0.0f);
+  zs.resize(count, 0.0f);
+}
+
+void math::Vector3Batch::Reserve(size_t count) {
+  xs.reserve(count);
+  ys.reserve(count);
+  zs.reserve(count);
+}
+
+void math::Vector3Batch::Clear() {
+  xs.clear();
+  ys.clear();
+  zs.clear();
+}
+
+void math::Vector3Batch::PushBack(const Vector3& v) {
+  xs.push_back(v.x);
+  ys.push_back(v.y);
+  zs.push_back(v.z);
+}
+
+void math::Vector3Batch::SwapRemove(size_t i) {
+  xs[i] = xs.back();
+  ys[i] = ys.back();
+  zs[i] = zs.back();
+  xs.pop_back();
+  ys.pop_back();
+  zs.pop_back();
+}
+
+void math::Vector3Batch::FromAoS(const Vector3* values, size_t count) {
+  Resize(count);
+  for (size_t i = 0; i < count; ++i) {
+    xs[i] = values[i].x;
+    ys[i] = values[i].y;
+    zs[i] = values[i].z;
+  }
+}
+
+void math::Vector3Batch::ToAoS(Vector3* out) const {
+  for (size_t i = 0; i < Size(); ++i) out[i] = Vector3(xs[i], ys[i], zs[i]);
+}
+
+void math::Vector3Batch::Add(const Vector3Batch& rhs) {
+  const size_t count = Size();
+  float* x = xs.data();
+  float* y = ys.data();
+  float* z = zs.data();
+  for (size_t i = 0; i < count; ++i) x[i] += rhs.xs[i];
+  for (size_t i = 0; i < count; ++i) y[i] += rhs.ys[i];
+  for (size_t i = 0; i < count; ++i) z[i] += rhs.zs[i];
+}
+
+void math::Vector3Batch::Subtract(const Vector3Batch& rhs) {
+  const size_t count = Size();
+  float* x = xs.data();
+  float* y = ys.data();
+  float* z = zs.data();
+  for (size_t i = 0; i < count; ++i) x[i] -= rhs.xs[i];
+  for (size_t i = 0; i < count; ++i) y[i] -= rhs.ys[i];
+  for (size_t i = 0; i < count; ++i) z[i] -= rhs.zs[i];
+}
+
+void math::Vector3Batch::Scale(float s) {
+  for (float& x : xs) x *= s;
+  for (float& y : ys) y *= s;
+  for (float& z : zs) z *= s;
+}
+
+void math::Vector3Batch::MulAdd(const Vector3Batch& rhs, float s) {
+  const size_t count = Size();
+  MulAddStream(xs.data(), rhs.xs.data(), s, xs.data(), count);
+  MulAddStream(ys.data(), rhs.ys.data(), s, ys.data(), count);
+  MulAddStream(zs.data(), rhs.zs.data(), s, zs.data(), count);
+}
+
+void math::Vector3Batch::Normalize() {
+  const size_t count = Size();
+  float* x = xs.data();
+  float* y = ys.data();
+  float* z = zs.data();
+  size_t i = 0;
+#ifdef VECTOR3_BATCH_SSE
+  const __m128 zero = _mm_setzero_ps();
+  const __m128 one = _mm_set1_ps(1.0f);
+  for (; i + 4 <= count; i += 4) {
+    const __m128 vx = _mm_load_ps(x + i);
+    const __m128 vy = _mm_load_ps(y + i);
+    const __m128 vz = _mm_load_ps(z + i);
+    const __m128 lengthSq =
+        _mm_add_ps(_mm_add_ps(_mm_mul_ps(vx, vx), _mm_mul_ps(vy, vy)),
+                   _mm_mul_ps(vz, vz));
+    // 1 / sqrt(0) is inf; the mask turns it into 0 so zero vectors stay 0.
+    const __m128 invLength =
+        _mm_and_ps(_mm_cmpgt_ps(lengthSq, zero),
+                   _mm_div_ps(one, _mm_sqrt_ps(lengthSq)));
+    _mm_store_ps(x + i, _mm_mul_ps(vx, invLength));
+    _mm_store_ps(y + i, _mm_mul_ps(vy, invLength));
+    _mm_store_ps(z + i, _mm_mul_ps(vz, invLength));
+  }
+#endif
+  for (; i < count; ++i) {
+    const float lengthSq = x[i] * x[i] + y[i] * y[i] + z[i] * z[i];
+    const float invLength =
+        lengthSq > 0.0f ? 1.0f / std::sqrt(lengthSq) : 0.0f;
+    x[i] *= invLength;
+    y[i] *= invLength;
+    z[i] *= invLength;
+  }
+}
+
+math::Vector3 math::Vector3Batch::Min() const {
+  return Vector3(ReduceMin(xs.data(), Size()), ReduceMin(ys.data(), Size()),
+                 ReduceMin(zs.data(), Size()));
+}
+
+math::Vector3 math::Vector3Batch::Max() const {
+  return Vector3(ReduceMax(xs.data(), Size()), ReduceMax(ys.data(), Size()),
+                 ReduceMax(zs.data(), Size()));
+}
+
+void math::Vector3Batch::Dot(const Vector3Batch& a, const Vector3Batch& b,
+                             float* out) {
+  const size_t count = a.Size();
+  for (size_t i = 0; i < count; ++i) {
+    out[i] = a.xs[i] * b.xs[i] + a.ys[i] * b.ys[i] + a.zs[i] * b.zs[i];
+  }
+}
+
+void math::Vector3Batch::Cross(const Vector3Batch& a, const Vector3Batch& b,
+                               Vector3Batch& out) {
+  const size_t count = a.Size();
+  out.Resize(count);
+  const float* ax = a.xs.data();
+  const float* ay = a.ys.data();
+  const float* az = a.zs.data();
+  const float* bx = b.xs.data();
+  const float* by = b.ys.data();
+  const float* bz = b.zs.data();
+  float* ox = out.xs.data();
+  float* oy = out.ys.data();
+  float* oz = out.zs.data();
+  for (size_t i = 0; i < count; ++i) {
+    const float x = ay[i] * bz[i] - az[i] * by[i];
+    const float y = az[i] * bx[i] - ax[i] * bz[i];
+    const float z = ax[i] * by[i] - ay[i] * bx[i];
+    ox[i] = x;
+    oy[i] = y;
+    oz[i] = z;
+  }
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <AlignedAllocator.hpp>
+#include <Vector3.hpp>
+#include <cstddef>
+#include <vector>
+
+namespace math {
+// Structure-of-arrays storage for many Vector3s: x, y and z live in three
+// separate 32-byte aligned arrays, so bulk operations touch contiguous
+// floats and vectorize cleanly.
+class Vector3Batch {
+ public:
+  using Buffer = std::vector<float, AlignedAllocator<float>>;
+
+  Vector3Batch() = default;
+  // `count` zero vectors.
+  explicit Vector3Batch(size_t count);
+  Vector3Batch(const Vector3* values, size_t count);
+
+  size_t Size() const { return xs.size(); }
+  bool Empty() const { return xs.empty(); }
+  void Resize(size_t count);
+  void Reserve(size_t count);
+  void Clear();
+  void PushBack(const Vector3& v);
+  // O(1) removal: moves the last element into slot i.
+  void SwapRemove(size_t i);
+
+  Vector3 Get(size_t i) const { return Vector3(xs[i], ys[i], zs[i]); }
+  void Set(size_t i, const Vector3& v) {
+    xs[i] = v.x;
+    ys[i] = v.y;
+    zs[i] = v.z;
+  }
+
+  float* X() { return xs.data(); }
+  float* Y() { return ys.data(); }
+  float* Z() { return zs.data(); }
+  const float* X() const { return xs.data(); }
+  const float* Y() const { return ys.data(); }
+  const float* Z() const { return zs.data(); }
+
+  // Conversion from/to array-of-structs storage.
+  void FromAoS(const Vector3* values, size_t count);
+  void ToAoS(Vector3* out) const;
+
+  // Component-wise, in place. rhs must have the same size.
+  void Add(const Vector3Batch& rhs);
+  void Subtract(const Vector3Batch& rhs);
+  void Scale(float s);
+  // this += rhs * s
+  void MulAdd(const Vector3Batch& rhs, float s);
+  // Zero-length vectors stay zero.
+  void Normalize();
+
+  // Component-wise minimum/maximum over all elements; the batch must not be
+  // empty.
+  Vector3 Min() const;
+  Vector3 Max() const;
+
+  // out[i] = dot(a[i], b[i]); out must hold a.Size() floats.
+  static void Dot(const Vector3Batch& a, const Vector3Batch& b, float* out);
+  // out[i] = cross(a[i], b[i]); out may be a or b and is resized as needed.
+  static void Cross(const Vector3Batch& a, const Vector3Batch& b,
+                    Vector3Batch& out);
+
+ private:
+  Buffer xs;
+  Buffer ys;
+  Buffer zs;
+};
+}  // namespace math
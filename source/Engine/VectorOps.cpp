@@ -0,0 +1,54 @@
+#include "VectorOps.hpp"
+
+// The loops read the inputs of element i before writing out[i], so they are
+// correct when out aliases an input. The in-place case is split out because
+// the compiler's runtime overlap check rejects out == input and would fall
+// back to the scalar loop for the most common call.
+namespace {
+void MulAddInPlace(math::Vector3* a, const math::Vector3* b, float s,
+                   size_t count) {
+  for (size_t i = 0; i < count; ++i) {
+    a[i].x += b[i].x * s;
+    a[i].y += b[i].y * s;
+    a[i].z += b[i].z * s;
+  }
+}
+
+void IntegrateInPlace(math::Vector3* p, const math::Vector3* v,
+                      const math::Vector3* a, float dt, size_t count) {
+  const float halfDtSq = 0.5f * dt * dt;
+  for (size_t i = 0; i < count; ++i) {
+    p[i].x += v[i].x * dt + a[i].x * halfDtSq;
+    p[i].y += v[i].y * dt + a[i].y * halfDtSq;
+    p[i].z += v[i].z * dt + a[i].z * halfDtSq;
+  }
+}
+}  // namespace
+
+void math::MulAdd(const Vector3* a, const Vector3* b, float s, Vector3* out,
+                  size_t count) {
+  if (out == a) return MulAddInPlace(out, b, s, count);
+  for (size_t i = 0; i < count; ++i) {
+    const float x = a[i].x + b[i].x * s;
+    const float y = a[i].y + b[i].y * s;
+    const float z = a[i].z + b[i].z * s;
+    out[i].x = x;
+    out[i].y = y;
+    out[i].z = z;
+  }
+}
+
+void math::IntegratePositions(const Vector3* p, const Vector3* v,
+                              const Vector3* a, float dt, Vector3* out,
+                              size_t count) {
+  if (out == p) return IntegrateInPlace(out, v, a, dt, count);
+  const float halfDtSq = 0.5f * dt * dt;
+  for (size_t i = 0; i < count; ++i) {
+    const float x = p[i].x + v[i].x * dt + a[i].x * halfDtSq;
+    const float y = p[i].y + v[i].y * dt + a[i].y * halfDtSq;
+    const float z = p[i].z + v[i].z * dt + a[i].z * halfDtSq;
+    out[i].x = x;
+    out[i].y = y;
+    out[i].z = z;
+  }
+}
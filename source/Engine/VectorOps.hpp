@@ -0,0 +1,124 @@
+#pragma once
+
+#include <Vector3.hpp>
+#include <cstddef>
+
+// Vector3 arithmetic that produces its result in one pass instead of through
+// a chain of value-returning operators, each of which materializes a
+// temporary Vector3.
+namespace math {
+inline float Dot(const Vector3& a, const Vector3& b) {
+  return a.x * b.x + a.y * b.y + a.z * b.z;
+}
+
+inline float LengthSquared(const Vector3& v) { return Dot(v, v); }
+
+inline Vector3 Cross(const Vector3& a, const Vector3& b) {
+  return Vector3(a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z,
+                 a.x * b.y - a.y * b.x);
+}
+
+// a + b * s
+inline Vector3 MulAdd(const Vector3& a, const Vector3& b, float s) {
+  return Vector3(a.x + b.x * s, a.y + b.y * s, a.z + b.z * s);
+}
+
+// a + b * s + c * t
+inline Vector3 MulAdd(const Vector3& a, const Vector3& b, float s,
+                      const Vector3& c, float t) {
+  return Vector3(a.x + b.x * s + c.x * t, a.y + b.y * s + c.y * t,
+                 a.z + b.z * s + c.z * t);
+}
+
+// p + v * dt + a * dt^2 / 2
+inline Vector3 IntegratePosition(const Vector3& p, const Vector3& v,
+                                 const Vector3& a, float dt) {
+  return MulAdd(p, v, dt, a, 0.5f * dt * dt);
+}
+
+// Batched forms. The loops are written so that the compiler vectorizes them
+// (configure with -DMATH_BENCH_VECTORIZE_REPORT=ON to check). out may alias
+// any input.
+void MulAdd(const Vector3* a, const Vector3* b, float s, Vector3* out,
+            size_t count);
+void IntegratePositions(const Vector3* p, const Vector3* v, const Vector3* a,
+                        float dt, Vector3* out, size_t count);
+
+// Expression templates for the cases the helpers above do not cover:
+//   Vector3 r = Evaluate(Lazy(p) + Lazy(v) * dt - Lazy(n) * (2 * d));
+// builds no intermediate Vector3 and evaluates each component once.
+// Expressions hold references to their operands, so evaluate them in the
+// statement that builds them instead of storing them with auto.
+namespace expr {
+template <typename E>
+struct Vec3Expr {
+  const E& Self() const { return static_cast<const E&>(*this); }
+};
+
+struct Ref : Vec3Expr<Ref> {
+  const Vector3& v;
+  explicit Ref(const Vector3& v) : v(v) {}
+  float X() const { return v.x; }
+  float Y() const { return v.y; }
+  float Z() const { return v.z; }
+};
+
+template <typename L, typename R>
+struct Sum : Vec3Expr<Sum<L, R>> {
+  L l;
+  R r;
+  Sum(const L& l, const R& r) : l(l), r(r) {}
+  float X() const { return l.X() + r.X(); }
+  float Y() const { return l.Y() + r.Y(); }
+  float Z() const { return l.Z() + r.Z(); }
+};
+
+template <typename L, typename R>
+struct Difference : Vec3Expr<Difference<L, R>> {
+  L l;
+  R r;
+  Difference(const L& l, const R& r) : l(l), r(r) {}
+  float X() const { return l.X() - r.X(); }
+  float Y() const { return l.Y() - r.Y(); }
+  float Z() const { return l.Z() - r.Z(); }
+};
+
+template <typename E>
+struct Scaled : Vec3Expr<Scaled<E>> {
+  E e;
+  float s;
+  Scaled(const E& e, float s) : e(e), s(s) {}
+  float X() const { return e.X() * s; }
+  float Y() const { return e.Y() * s; }
+  float Z() const { return e.Z() * s; }
+};
+
+template <typename L, typename R>
+Sum<L, R> operator+(const Vec3Expr<L>& l, const Vec3Expr<R>& r) {
+  return Sum<L, R>(l.Self(), r.Self());
+}
+
+template <typename L, typename R>
+Difference<L, R> operator-(const Vec3Expr<L>& l, const Vec3Expr<R>& r) {
+  return Difference<L, R>(l.Self(), r.Self());
+}
+
+template <typename E>
+Scaled<E> operator*(const Vec3Expr<E>& e, float s) {
+  return Scaled<E>(e.Self(), s);
+}
+
+template <typename E>
+Scaled<E> operator*(float s, const Vec3Expr<E>& e) {
+  return Scaled<E>(e.Self(), s);
+}
+}  // namespace expr
+
+inline expr::Ref Lazy(const Vector3& v) { return expr::Ref(v); }
+
+template <typename E>
+Vector3 Evaluate(const expr::Vec3Expr<E>& e) {
+  const E& self = e.Self();
+  return Vector3(self.X(), self.Y(), self.Z());
+}
+}  // namespace math
@@ -7,6 +7,6 @@ uniform mat4 transform;
 
 void main()
 {
-    gl_Position = vec4(vertexPosition, 1.0) * transform;
+    gl_Position = transform * vec4(vertexPosition, 1.0);
     fragmentColor = vec3(vertexPosition.x, vertexPosition.y, vertexPosition.z);
 }
\ No newline at end of file
@@ -16,6 +16,7 @@
 #include <iostream>
 #include <memory>
 
+#include "Affine3x4.hpp"
 #include "Matrix4x4.hpp"
 #include "Vector2.hpp"
 #include "Vector3.hpp"
@@ -74,7 +75,16 @@ int main(void) {
   std::shared_ptr<Engine::Scene> scene = std::make_shared<Engine::Scene>();
   engine->AddScene(scene);
 
-  engine->EnterScene(0);
+  // The cube spins as a rigid body, so its speed no longer depends on the
+  // frame rate (it used to turn 0.01 rad per frame).
+  std::shared_ptr<Engine::GameObject> cube =
+      std::make_shared<Engine::GameObject>();
+  scene->AddGameObject(cube);
+  scene->GetPhysicsWorld().SetGravity(math::Vector3(0.0f, 0.0f, 0.0f));
+  scene->GetPhysicsWorld().SetDamping(0.0f, 0.0f);
+  Engine::RigidBodyDesc cubeBody;
+  cubeBody.angularVelocity = math::Vector3(0.0f, 0.6f, 0.0f);
+  scene->AddRigidBody(*cube, cubeBody);
 
   // load shader
 
@@ -91,23 +101,25 @@ int main(void) {
   }
   /* END OF SHADER PART */
 
+  // Last, so the first frame does not simulate the loading time.
+  engine->EnterScene(0);
+
   /* DRAW THE TRIANGLE */
+  // Constant parts of the model transform, folded at compile time.
+  constexpr auto modelScale = math::Affine3x4::CreateScale(0.1f, 0.1f, 0.1f);
+  constexpr auto modelTranslation =
+      math::Affine3x4::CreateTranslation(0.0f, 0.0f, -0.3f);
 
   while (!engine->NeedsToCloseWindow()) {
-    static float yaw = 0.0f;
-    yaw += 0.01f;
     engine->Update();
-    math::Matrix4x4 transform = math::Matrix4x4::CreateIdentityMatrix();
-    transform = transform * math::Matrix4x4::CreateScaleMatrix(
-                                math::Vector3(0.1, 0.1, 0.1));
-
-    transform = transform * math::Matrix4x4::CreateRotationYawMatrix(yaw);
-    transform = transform * math::Matrix4x4::CreateTranslationMatrix(
-                                math::Vector3(0, 0, -0.3f));
-    transform = transform * math::Matrix4x4::CreatePerspectiveMatrix(
-                                0.785398,
-                                engine->GetWidth() / (float)engine->GetHeight(),
-                                0.1f, 100.0f);
+    // The model transform is affine; only the projection needs a full 4x4.
+    const math::Affine3x4 model = modelScale *
+                                  scene->GetInterpolatedTransform(*cube) *
+                                  modelTranslation;
+    math::Matrix4x4 transform =
+        model * math::Matrix4x4::CreatePerspectiveMatrix(
+                    0.785398, engine->GetWidth() / (float)engine->GetHeight(),
+                    0.1f, 100.0f);
 
     // transform.ToString();
 
@@ -119,9 +131,10 @@ int main(void) {
 
     unsigned int transformLoc =
         glGetUniformLocation(shader_utils.getProgram().value(), "transform");
-    // If transpose is GL_TRUE, each matrix is assumed to be supplied in row
-    // major order.
-    glUniformMatrix4fv(transformLoc, 1, GL_TRUE, &transform.element[0][0]);
+    // Matrix4x4 is row-major with row vectors, which is exactly the
+    // column-major, column-vector layout GL expects (see GpuMatrix.hpp), so
+    // it is uploaded untransposed and the shader computes transform * v.
+    glUniformMatrix4fv(transformLoc, 1, GL_FALSE, &transform.element[0][0]);
     engine->Render();
 
     mesh->Render();